@@ -0,0 +1,595 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/archivemountpoint.h>
+#include <vcl/filesystem/readers/archivefilereader.h>
+#include <vcl/filesystem/util/archive.h>
+#include <vcl/filesystem/util/archivewriter.h>
+#include <vcl/filesystem/filesystem.h>
+
+// zlib
+#include <ZipLib/extlibs/zlib/zlib.h>
+
+// Benchmark support
+#include "benchmark.h"
+
+namespace
+{
+	template<typename T>
+	void writeLE(std::ofstream& file, T value)
+	{
+		for (size_t i = 0; i < sizeof(T); i++)
+			file.put(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+
+	/*!
+	 *	\brief Write an archive with empty, stored entries
+	 *	\param zip_file Path of the archive
+	 *	\param nr_entries Number of entries in the archive
+	 */
+	void writeArchive(const std::experimental::filesystem::path& zip_file, size_t nr_entries)
+	{
+		std::ofstream file{ zip_file.string(), std::ios::binary };
+		std::vector<uint32_t> offsets(nr_entries);
+
+		auto entry_name = [](size_t e)
+		{
+			return "textures/set" + std::to_string(e / 1000) + "/texture" + std::to_string(e) + ".dds";
+		};
+
+		// Local file headers
+		for (size_t e = 0; e < nr_entries; e++)
+		{
+			const auto name = entry_name(e);
+			offsets[e] = static_cast<uint32_t>(file.tellp());
+			writeLE<uint32_t>(file, 0x04034b50);
+			writeLE<uint16_t>(file, 20);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint16_t>(file, static_cast<uint16_t>(name.size()));
+			writeLE<uint16_t>(file, 0);
+			file.write(name.data(), name.size());
+		}
+
+		// Central directory
+		const auto dir_offset = static_cast<uint32_t>(file.tellp());
+		for (size_t e = 0; e < nr_entries; e++)
+		{
+			const auto name = entry_name(e);
+			writeLE<uint32_t>(file, 0x02014b50);
+			writeLE<uint16_t>(file, 20);
+			writeLE<uint16_t>(file, 20);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint16_t>(file, static_cast<uint16_t>(name.size()));
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, offsets[e]);
+			file.write(name.data(), name.size());
+		}
+		const auto dir_size = static_cast<uint32_t>(file.tellp()) - dir_offset;
+
+		// End of central directory, the entry count is stored in the zip64 record for large archives
+		const auto nr_records = static_cast<uint16_t>(std::min<size_t>(nr_entries, 0xffff));
+		if (nr_entries >= 0xffff)
+		{
+			const auto record_offset = static_cast<uint64_t>(file.tellp());
+			writeLE<uint32_t>(file, 0x06064b50);
+			writeLE<uint64_t>(file, 44);
+			writeLE<uint16_t>(file, 45);
+			writeLE<uint16_t>(file, 45);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint64_t>(file, nr_entries);
+			writeLE<uint64_t>(file, nr_entries);
+			writeLE<uint64_t>(file, dir_size);
+			writeLE<uint64_t>(file, dir_offset);
+
+			writeLE<uint32_t>(file, 0x07064b50);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint64_t>(file, record_offset);
+			writeLE<uint32_t>(file, 1);
+		}
+		writeLE<uint32_t>(file, 0x06054b50);
+		writeLE<uint16_t>(file, 0);
+		writeLE<uint16_t>(file, 0);
+		writeLE<uint16_t>(file, nr_records);
+		writeLE<uint16_t>(file, nr_records);
+		writeLE<uint32_t>(file, dir_size);
+		writeLE<uint32_t>(file, dir_offset);
+		writeLE<uint16_t>(file, 0);
+	}
+
+	//! \returns compressible content resembling a text asset
+	std::vector<char> makeContent(size_t size)
+	{
+		const char* words[] = { "shader ", "texture ", "mesh ", "audio ", "level ", "script ", "\n" };
+
+		std::mt19937 rnd{ 1 };
+		std::vector<char> content;
+		content.reserve(size + 16);
+		while (content.size() < size)
+		{
+			const char* word = words[rnd() % 7];
+			content.insert(content.end(), word, word + std::char_traits<char>::length(word));
+		}
+		content.resize(size);
+
+		return content;
+	}
+
+	//! Content of an entry of a benchmark archive
+	struct BenchmarkEntry
+	{
+		std::string Name;
+		std::vector<char> Content;
+	};
+
+	/*!
+	 *	\brief Write an archive with deflated entries
+	 *	\param zip_file Path of the archive
+	 *	\param entries Names and uncompressed content of the entries
+	 */
+	void writeDeflatedArchive(const std::experimental::filesystem::path& zip_file, const std::vector<BenchmarkEntry>& entries)
+	{
+		std::ofstream file{ zip_file.string(), std::ios::binary };
+
+		struct Record
+		{
+			uint32_t Offset;
+			uint32_t Crc;
+			uint32_t CompressedSize;
+		};
+		std::vector<Record> records;
+
+		for (const auto& entry : entries)
+		{
+			const auto& content = entry.Content;
+
+			z_stream stream{};
+			deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+			std::vector<char> data(deflateBound(&stream, static_cast<uLong>(content.size())));
+			stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+			stream.avail_in = static_cast<uInt>(content.size());
+			stream.next_out = reinterpret_cast<Bytef*>(data.data());
+			stream.avail_out = static_cast<uInt>(data.size());
+			deflate(&stream, Z_FINISH);
+			data.resize(stream.total_out);
+			deflateEnd(&stream);
+
+			const auto crc = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(content.data()), static_cast<uInt>(content.size())));
+			records.push_back({ static_cast<uint32_t>(file.tellp()), crc, static_cast<uint32_t>(data.size()) });
+
+			writeLE<uint32_t>(file, 0x04034b50);
+			writeLE<uint16_t>(file, 20);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 8);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, crc);
+			writeLE<uint32_t>(file, static_cast<uint32_t>(data.size()));
+			writeLE<uint32_t>(file, static_cast<uint32_t>(content.size()));
+			writeLE<uint16_t>(file, static_cast<uint16_t>(entry.Name.size()));
+			writeLE<uint16_t>(file, 0);
+			file.write(entry.Name.data(), entry.Name.size());
+			file.write(data.data(), data.size());
+		}
+
+		const auto dir_offset = static_cast<uint32_t>(file.tellp());
+		for (size_t e = 0; e < entries.size(); e++)
+		{
+			const auto& entry = entries[e];
+			writeLE<uint32_t>(file, 0x02014b50);
+			writeLE<uint16_t>(file, 20);
+			writeLE<uint16_t>(file, 20);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 8);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, records[e].Crc);
+			writeLE<uint32_t>(file, records[e].CompressedSize);
+			writeLE<uint32_t>(file, static_cast<uint32_t>(entry.Content.size()));
+			writeLE<uint16_t>(file, static_cast<uint16_t>(entry.Name.size()));
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, records[e].Offset);
+			file.write(entry.Name.data(), entry.Name.size());
+		}
+		const auto dir_size = static_cast<uint32_t>(file.tellp()) - dir_offset;
+
+		writeLE<uint32_t>(file, 0x06054b50);
+		writeLE<uint16_t>(file, 0);
+		writeLE<uint16_t>(file, 0);
+		writeLE<uint16_t>(file, static_cast<uint16_t>(entries.size()));
+		writeLE<uint16_t>(file, static_cast<uint16_t>(entries.size()));
+		writeLE<uint32_t>(file, dir_size);
+		writeLE<uint32_t>(file, dir_offset);
+		writeLE<uint16_t>(file, 0);
+	}
+}
+
+VCL_FILESYSTEM_BENCHMARK(ArchiveMount)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+	using Vcl::FileSystem::Benchmark::report;
+
+	for (size_t nr_entries : { 10000, 100000, 400000 })
+	{
+		const std::experimental::filesystem::path zip_file{ "ArchiveMountBenchmark.zip" };
+		writeArchive(zip_file, nr_entries);
+
+		std::unique_ptr<Util::Archive> archive;
+		const auto ns_mount = measure(1, [&](uint64_t)
+		{
+			archive = std::make_unique<Util::Archive>(zip_file);
+		});
+
+		const auto idx = nr_entries / 2;
+		const std::experimental::filesystem::path hit{ "textures/set" + std::to_string(idx / 1000) + "/texture" + std::to_string(idx) + ".dds" };
+		const std::experimental::filesystem::path miss{ "textures/missing.dds" };
+
+		bool found = false;
+		const auto ns_hit = measure(100000, [&](uint64_t) { found |= archive->entryExists(hit); });
+		const auto ns_miss = measure(100000, [&](uint64_t) { found |= archive->entryExists(miss); });
+		Vcl::FileSystem::Benchmark::doNotOptimize(found);
+
+		const auto config = std::to_string(nr_entries) + " entries";
+		report("ArchiveMount/mount", config, ns_mount / 1e6, "ms");
+		report("ArchiveMount/memory", config, static_cast<double>(archive->indexMemory()) / nr_entries, "bytes/entry");
+		report("ArchiveMount/hit", config, ns_hit);
+		report("ArchiveMount/miss", config, ns_miss);
+
+		archive.reset();
+		std::experimental::filesystem::remove(zip_file);
+	}
+}
+
+VCL_FILESYSTEM_BENCHMARK(ArchiveSeek)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+	using Vcl::FileSystem::Benchmark::report;
+
+	const auto content = makeContent(32 << 20);
+	const std::experimental::filesystem::path zip_file{ "ArchiveSeekBenchmark.zip" };
+	writeDeflatedArchive(zip_file, { { "level.txt", content } });
+
+	// A span larger than the entry disables the checkpoints, every backward seek restarts at the beginning
+	for (size_t span : { size_t(64) << 20, size_t(4) << 20, size_t(1) << 20, size_t(256) << 10 })
+	{
+		ArchiveOptions options;
+		options.SeekIndexSpan = span;
+
+		FileSystem fs;
+		fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options));
+
+		std::shared_ptr<FileReader> reader;
+		const auto ns_open = measure(1, [&](uint64_t) { reader = fs.createReader("/content/level.txt"); });
+
+		std::vector<char> buffer(4096);
+		std::mt19937 offsets{ 2 };
+		size_t read = 0;
+		const auto ns_seek = measure(50, [&](uint64_t)
+		{
+			read += reader->readAt(offsets() % content.size(), buffer.data(), buffer.size());
+		});
+		Vcl::FileSystem::Benchmark::doNotOptimize(read);
+
+		const auto config = span >= content.size() ? std::string{ "no index" } : std::to_string(span >> 10) + " KiB span";
+		report("ArchiveSeek/open", config, ns_open / 1e6, "ms");
+		report("ArchiveSeek/random read", config, ns_seek / 1e3, "us");
+	}
+
+	std::experimental::filesystem::remove(zip_file);
+}
+
+VCL_FILESYSTEM_BENCHMARK(ArchiveInflate)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+	using Vcl::FileSystem::Benchmark::report;
+
+	const auto content = makeContent(32 << 20);
+	const std::experimental::filesystem::path zip_file{ "ArchiveInflateBenchmark.zip" };
+	writeDeflatedArchive(zip_file, { { "level.txt", content } });
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file));
+	Util::Archive archive{ zip_file };
+
+	const double mib = static_cast<double>(content.size()) / (1 << 20);
+	std::vector<char> buffer(content.size());
+	for (const std::string config : { "direct", "ZipLib" })
+	{
+		auto open = [&]() -> std::shared_ptr<FileReader>
+		{
+			if (config == "direct")
+				return fs.createReader("/content/level.txt");
+
+			auto stream = archive.stream();
+			return std::make_shared<ArchiveFileReader>("/content/level.txt", archive.openEntry(0, *stream), stream);
+		};
+
+		// Decode the entire entry into a single buffer
+		uint64_t read = 0;
+		const auto ns_whole = measure(5, [&](uint64_t)
+		{
+			read += open()->read(buffer.data(), buffer.size());
+		});
+
+		// Stream the entry in blocks
+		const auto ns_blocks = measure(5, [&](uint64_t)
+		{
+			auto reader = open();
+			while (!reader->eof())
+				read += reader->read(buffer.data(), 64 << 10);
+		});
+		Vcl::FileSystem::Benchmark::doNotOptimize(read);
+
+		report("ArchiveInflate/whole entry", config, mib / (ns_whole / 1e9), "MiB/s");
+		report("ArchiveInflate/64 KiB blocks", config, mib / (ns_blocks / 1e9), "MiB/s");
+	}
+
+	std::experimental::filesystem::remove(zip_file);
+}
+
+VCL_FILESYSTEM_BENCHMARK(ArchiveLoadBatch)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+	using Vcl::FileSystem::Benchmark::report;
+
+	// Assets of a level, each decodable independently
+	const size_t nr_entries = 2000;
+	const auto content = makeContent(64 << 10);
+	std::vector<BenchmarkEntry> entries;
+	std::vector<std::experimental::filesystem::path> files;
+	for (size_t e = 0; e < nr_entries; e++)
+	{
+		entries.push_back({ "level/asset" + std::to_string(e) + ".txt", content });
+		files.push_back("/content/level/asset" + std::to_string(e) + ".txt");
+	}
+
+	const std::experimental::filesystem::path zip_file{ "ArchiveLoadBatchBenchmark.zip" };
+	writeDeflatedArchive(zip_file, entries);
+
+	const double mib = static_cast<double>(nr_entries * content.size()) / (1 << 20);
+	const unsigned int nr_cores = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int nr_workers : { 1u, 2u, 4u, nr_cores })
+	{
+		ArchiveOptions options;
+		options.NrWorkers = nr_workers;
+		ArchiveMountPoint mp{ "Content", "/content", zip_file, options };
+
+		size_t loaded = 0;
+		const auto ns_load = measure(3, [&](uint64_t)
+		{
+			loaded += mp.loadFiles(files).size();
+		});
+		Vcl::FileSystem::Benchmark::doNotOptimize(loaded);
+
+		report("ArchiveLoadBatch/loadFiles", std::to_string(nr_workers) + " workers", mib / (ns_load / 1e9), "MiB/s");
+	}
+
+	std::experimental::filesystem::remove(zip_file);
+}
+
+VCL_FILESYSTEM_BENCHMARK(ArchiveThreads)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+	using Vcl::FileSystem::Benchmark::report;
+
+	const size_t nr_entries = 256;
+	const size_t entry_size = 64 << 10;
+	const auto content = makeContent(entry_size);
+	std::vector<BenchmarkEntry> entries;
+	for (size_t e = 0; e < nr_entries; e++)
+		entries.push_back({ "asset" + std::to_string(e) + ".txt", content });
+
+	const std::experimental::filesystem::path zip_file{ "ArchiveThreadsBenchmark.zip" };
+	writeDeflatedArchive(zip_file, entries);
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file));
+
+	// Every thread opens its own readers on the same archive
+	auto run = [&](unsigned int nr_threads, size_t read_size, size_t nr_reads)
+	{
+		std::atomic<uint64_t> total{ 0 };
+		const auto ns = measure(1, [&](uint64_t)
+		{
+			std::vector<std::thread> threads;
+			for (unsigned int t = 0; t < nr_threads; t++)
+			{
+				threads.emplace_back([&, t]()
+				{
+					std::mt19937 rnd{ t };
+					std::vector<char> buffer(read_size);
+					uint64_t read = 0;
+					for (size_t i = 0; i < nr_reads; i++)
+					{
+						auto reader = fs.createReader("/content/asset" + std::to_string(rnd() % nr_entries) + ".txt");
+						const uint64_t offset = read_size < entry_size ? rnd() % (entry_size - read_size) : 0;
+						read += reader->readAt(offset, buffer.data(), buffer.size());
+					}
+					total += read;
+				});
+			}
+			for (auto& thread : threads)
+				thread.join();
+		});
+
+		return static_cast<double>(total) / (1 << 20) / (ns / 1e9);
+	};
+
+	const unsigned int nr_cores = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int nr_threads : { 1u, 2u, 4u, nr_cores })
+	{
+		const auto config = std::to_string(nr_threads) + " threads";
+		report("ArchiveThreads/whole entries", config, run(nr_threads, entry_size, 2000 / nr_threads), "MiB/s");
+		report("ArchiveThreads/4 KiB reads", config, run(nr_threads, 4096, 20000 / nr_threads), "MiB/s");
+	}
+
+	std::experimental::filesystem::remove(zip_file);
+}
+
+VCL_FILESYSTEM_BENCHMARK(ArchiveWrite)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+	using Vcl::FileSystem::Benchmark::report;
+
+	// Many small assets and one large entry split into blocks
+	const auto small = makeContent(256 << 10);
+	const auto large = makeContent(32 << 20);
+	const double mib = (64.0 * small.size() + large.size()) / (1 << 20);
+
+	const std::experimental::filesystem::path zip_file{ "ArchiveWriteBenchmark.zip" };
+
+	// Reference: a single stream compressing the same data
+	const auto ns_serial = measure(1, [&](uint64_t)
+	{
+		auto compress = [](const std::vector<char>& data)
+		{
+			std::vector<Bytef> output(compressBound(static_cast<uLong>(data.size())));
+			uLongf size = static_cast<uLongf>(output.size());
+			compress2(output.data(), &size, reinterpret_cast<const Bytef*>(data.data()), static_cast<uLong>(data.size()), Z_DEFAULT_COMPRESSION);
+			Vcl::FileSystem::Benchmark::doNotOptimize(size);
+		};
+		for (int i = 0; i < 64; i++)
+			compress(small);
+		compress(large);
+	});
+	report("ArchiveWrite/serial deflate", "1 thread", mib / (ns_serial / 1e9), "MiB/s");
+
+	const unsigned int nr_cores = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int nr_workers : { 1u, 2u, 4u, nr_cores })
+	{
+		ArchiveOptions options;
+		options.Create = true;
+		options.NrWorkers = nr_workers;
+
+		const auto ns_write = measure(1, [&](uint64_t)
+		{
+			auto mount = std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options);
+			auto archive = mount.get();
+
+			FileSystem fs;
+			fs.addMountPoint(std::move(mount));
+
+			for (int i = 0; i < 64; i++)
+				fs.createWriter("/content/asset" + std::to_string(i) + ".txt")->write(const_cast<char*>(small.data()), small.size());
+			fs.createWriter("/content/level.txt")->write(const_cast<char*>(large.data()), large.size());
+
+			archive->finalize();
+		});
+
+		report("ArchiveWrite/createWriter", std::to_string(nr_workers) + " workers", mib / (ns_write / 1e9), "MiB/s");
+	}
+
+	std::experimental::filesystem::remove(zip_file);
+}
+
+VCL_FILESYSTEM_BENCHMARK(ArchiveUpdate)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+	using Vcl::FileSystem::Benchmark::report;
+
+	const size_t nr_entries = 1024;
+	const auto content = makeContent(256 << 10);
+	std::vector<BenchmarkEntry> entries;
+	for (size_t e = 0; e < nr_entries; e++)
+		entries.push_back({ "asset" + std::to_string(e) + ".txt", content });
+
+	const std::experimental::filesystem::path zip_file{ "ArchiveUpdateBenchmark.zip" };
+	writeDeflatedArchive(zip_file, entries);
+	const auto config = std::to_string(nr_entries) + " entries";
+
+	auto mount = std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file);
+	auto archive = mount.get();
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount));
+
+	// Replace a single entry of the mounted archive
+	const auto ns_append = measure(10, [&](uint64_t i)
+	{
+		archive->beginUpdate();
+		fs.createWriter("/content/asset" + std::to_string(i) + ".txt")->write(const_cast<char*>(content.data()), content.size());
+		archive->finalize();
+	});
+	report("ArchiveUpdate/replace entry", config, ns_append / 1e6, "ms");
+
+	const auto ns_compact = measure(1, [&](uint64_t) { archive->compact(); });
+	report("ArchiveUpdate/compact", config, ns_compact / 1e6, "ms");
+
+	// Reference: writing the entire archive again
+	const std::experimental::filesystem::path rewritten_file{ "ArchiveUpdateRewritten.zip" };
+	const auto ns_rewrite = measure(1, [&](uint64_t)
+	{
+		Util::ArchiveWriter writer{ rewritten_file, 1 };
+		for (const auto& entry : entries)
+		{
+			auto handle = writer.createEntry(entry.Name);
+			writer.write(handle, entry.Content.data(), entry.Content.size());
+			writer.close(handle);
+		}
+		writer.finalize();
+	});
+	report("ArchiveUpdate/rewrite archive", config, ns_rewrite / 1e6, "ms");
+
+	std::experimental::filesystem::remove(rewritten_file);
+	std::experimental::filesystem::remove(zip_file);
+}
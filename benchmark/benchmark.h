@@ -0,0 +1,90 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Vcl { namespace FileSystem { namespace Benchmark
+{
+	//! Signature of a single benchmark
+	using BenchmarkFunction = std::function<void()>;
+
+	//! \returns the list of all registered benchmarks
+	std::vector<std::pair<std::string, BenchmarkFunction>>& benchmarks();
+
+	//! Helper adding a benchmark to the global list during static initialization
+	struct Registration
+	{
+		Registration(std::string name, BenchmarkFunction func)
+		{
+			benchmarks().emplace_back(std::move(name), std::move(func));
+		}
+	};
+
+	/*!
+	 *	\brief Measure the average run-time of a function
+	 *	\param iterations Number of times 'func' is invoked
+	 *	\param func Function to measure, called with the index of the iteration
+	 *	\returns the average time per invocation in nano-seconds
+	 */
+	template<typename Func>
+	double measure(uint64_t iterations, Func&& func)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (uint64_t i = 0; i < iterations; i++)
+			func(i);
+		const auto end = std::chrono::high_resolution_clock::now();
+
+		return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+	}
+
+	//! Print a single measurement in a common format
+	void report(const std::string& name, const std::string& config, double value, const char* unit = "ns/op");
+
+	//! Prevent the compiler from optimizing away a value
+	template<typename T>
+	void doNotOptimize(const T& value)
+	{
+		volatile auto sink = value;
+		(void) sink;
+	}
+}}}
+
+#define VCL_FILESYSTEM_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define VCL_FILESYSTEM_BENCHMARK_CONCAT(a, b) VCL_FILESYSTEM_BENCHMARK_CONCAT_IMPL(a, b)
+
+//! Register a new benchmark
+#define VCL_FILESYSTEM_BENCHMARK(name) \
+	static void name(); \
+	static Vcl::FileSystem::Benchmark::Registration VCL_FILESYSTEM_BENCHMARK_CONCAT(name, _registration){ #name, name }; \
+	static void name()
@@ -0,0 +1,59 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "benchmark.h"
+
+// C++ standard library
+#include <cstdio>
+#include <cstring>
+
+namespace Vcl { namespace FileSystem { namespace Benchmark
+{
+	std::vector<std::pair<std::string, BenchmarkFunction>>& benchmarks()
+	{
+		static std::vector<std::pair<std::string, BenchmarkFunction>> list;
+		return list;
+	}
+
+	void report(const std::string& name, const std::string& config, double value, const char* unit)
+	{
+		std::printf("%-32s %-24s %14.2f %s\n", name.c_str(), config.c_str(), value, unit);
+	}
+}}}
+
+int main(int argc, char* argv[])
+{
+	using namespace Vcl::FileSystem::Benchmark;
+
+	// Optional filter selecting the benchmarks to run
+	const char* filter = argc > 1 ? argv[1] : "";
+
+	for (const auto& bench : benchmarks())
+	{
+		if (bench.first.find(filter) != std::string::npos)
+			bench.second();
+	}
+
+	return 0;
+}
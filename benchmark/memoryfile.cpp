@@ -0,0 +1,109 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <string>
+#include <vector>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/memorymountpoint.h>
+#include <vcl/filesystem/filesystem.h>
+
+// Benchmark support
+#include "benchmark.h"
+
+VCL_FILESYSTEM_BENCHMARK(MemoryFileWrite)
+{
+	using namespace Vcl::FileSystem;
+
+	struct Configuration
+	{
+		const char* Name;
+		size_t PageSize;
+		bool HugePages;
+	};
+	const Configuration configs[] =
+	{
+		{ "4KiB", 4 << 10, false },
+		{ "64KiB", 64 << 10, false },
+		{ "2MiB", 2 << 20, false },
+		{ "2MiB+huge", 2 << 20, true },
+	};
+
+	const uint64_t file_size = 1ull << 30;
+	std::vector<char> data(64 << 10, 'x');
+
+	for (const auto& config : configs)
+	{
+		FileSystem fs;
+		fs.addMountPoint(std::make_unique<MemoryMountPoint>("Memory", "/memory", config.PageSize, config.HugePages));
+
+		for (int run = 0; run < 2; run++)
+		{
+			const auto ns = Vcl::FileSystem::Benchmark::measure(1, [&](uint64_t)
+			{
+				auto writer = fs.createWriter("/memory/File" + std::to_string(run) + ".bin");
+				for (uint64_t written = 0; written < file_size; written += data.size())
+					writer->write(data.data(), data.size());
+			});
+
+			Vcl::FileSystem::Benchmark::report("MemoryFileWrite/MiB", config.Name, ns / (file_size >> 20));
+		}
+	}
+}
+
+VCL_FILESYSTEM_BENCHMARK(MemoryFileLookup)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+
+	for (size_t nr_files : { 100, 10000, 100000 })
+	{
+		FileSystem fs;
+		fs.addMountPoint(std::make_unique<MemoryMountPoint>("Shaders", "/shaders"));
+
+		uint32_t value = 0;
+		const auto ns_create = measure(nr_files, [&](uint64_t i)
+		{
+			fs.createWriter("/shaders/blob" + std::to_string(i) + ".bin")->write(&value, sizeof(value));
+		});
+
+		const std::experimental::filesystem::path hit{ "/shaders/blob" + std::to_string(nr_files / 2) + ".bin" };
+		const std::experimental::filesystem::path miss{ "/shaders/missing.bin" };
+
+		bool found = false;
+		const auto ns_hit = measure(100000, [&](uint64_t) { found |= fs.exists(hit); });
+		const auto ns_miss = measure(100000, [&](uint64_t) { found |= fs.exists(miss); });
+		Vcl::FileSystem::Benchmark::doNotOptimize(found);
+
+		const auto config = std::to_string(nr_files) + " files";
+		Vcl::FileSystem::Benchmark::report("MemoryFileLookup/create", config, ns_create);
+		Vcl::FileSystem::Benchmark::report("MemoryFileLookup/hit", config, ns_hit);
+		Vcl::FileSystem::Benchmark::report("MemoryFileLookup/miss", config, ns_miss);
+	}
+}
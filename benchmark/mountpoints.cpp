@@ -0,0 +1,66 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <string>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/memorymountpoint.h>
+#include <vcl/filesystem/filesystem.h>
+
+// Benchmark support
+#include "benchmark.h"
+
+VCL_FILESYSTEM_BENCHMARK(MountPointLookup)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+
+	for (size_t nr_mounts : { 1, 10, 100, 1000, 10000 })
+	{
+		// One mount point per downloadable content package
+		FileSystem fs;
+		fs.addMountPoint(std::make_unique<MemoryMountPoint>("Base", "/"));
+		for (size_t m = 0; m < nr_mounts; m++)
+		{
+			auto mount_path = "/content/dlc/" + std::to_string(m);
+			fs.addMountPoint(std::make_unique<MemoryMountPoint>("DLC", mount_path));
+		}
+
+		const std::experimental::filesystem::path hit{ "/content/dlc/" + std::to_string(nr_mounts - 1) + "/textures/terrain/rock.dds" };
+		const std::experimental::filesystem::path miss{ "/shaders/common/lighting.hlsl" };
+
+		bool found = false;
+		auto ns_hit = measure(1000000, [&](uint64_t) { found |= fs.exists(hit); });
+		auto ns_miss = measure(1000000, [&](uint64_t) { found |= fs.exists(miss); });
+		Vcl::FileSystem::Benchmark::doNotOptimize(found);
+
+		Vcl::FileSystem::Benchmark::report("MountPointLookup/hit", std::to_string(nr_mounts) + " mounts", ns_hit);
+		Vcl::FileSystem::Benchmark::report("MountPointLookup/miss", std::to_string(nr_mounts) + " mounts", ns_miss);
+	}
+}
@@ -0,0 +1,176 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <random>
+#include <string>
+#include <vector>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/packmountpoint.h>
+#include <vcl/filesystem/util/packwriter.h>
+#include <vcl/filesystem/filesystem.h>
+
+// Benchmark support
+#include "benchmark.h"
+
+namespace
+{
+	//! \returns compressible text of 'size' bytes
+	std::vector<char> makeContent(size_t size)
+	{
+		const char* words[] = { "shader ", "texture ", "mesh ", "audio ", "level ", "script ", "\n" };
+
+		std::mt19937 rnd{ 1 };
+		std::vector<char> content;
+		content.reserve(size + 16);
+		while (content.size() < size)
+		{
+			const char* word = words[rnd() % 7];
+			content.insert(content.end(), word, word + std::char_traits<char>::length(word));
+		}
+		content.resize(size);
+
+		return content;
+	}
+}
+
+VCL_FILESYSTEM_BENCHMARK(PackSeek)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+	using Vcl::FileSystem::Benchmark::report;
+
+	// Same content as 'ArchiveSeek', random reads only decode the blocks they cover
+	const auto content = makeContent(32 << 20);
+	const std::experimental::filesystem::path pack_file{ "PackSeekBenchmark.pack" };
+
+	for (uint32_t block_size : { 16u << 10, 64u << 10, 256u << 10 })
+	{
+		const auto ns_build = measure(1, [&](uint64_t)
+		{
+			Util::PackWriter writer{ pack_file, 0, block_size };
+			writer.addFile("level.txt", content.data(), content.size());
+			writer.finalize();
+		});
+
+		FileSystem fs;
+		const auto ns_mount = measure(1, [&](uint64_t)
+		{
+			fs.addMountPoint(std::make_unique<PackMountPoint>("Content", "/content", pack_file));
+		});
+		auto reader = fs.createReader("/content/level.txt");
+
+		std::vector<char> buffer(4096);
+		std::mt19937 offsets{ 2 };
+		size_t read = 0;
+		const auto ns_seek = measure(1000, [&](uint64_t)
+		{
+			read += reader->readAt(offsets() % content.size(), buffer.data(), buffer.size());
+		});
+
+		std::vector<char> file(content.size());
+		const auto ns_read = measure(3, [&](uint64_t)
+		{
+			read += reader->readAt(0, file.data(), file.size());
+		});
+		Vcl::FileSystem::Benchmark::doNotOptimize(read);
+
+		const auto config = std::to_string(block_size >> 10) + " KiB blocks";
+		report("PackSeek/build", config, ns_build / 1e6, "ms");
+		report("PackSeek/ratio", config, 100.0 * std::experimental::filesystem::file_size(pack_file) / content.size(), "%");
+		report("PackSeek/mount", config, ns_mount / 1e3, "us");
+		report("PackSeek/random read", config, ns_seek / 1e3, "us");
+		report("PackSeek/read file", config, (content.size() >> 20) / (ns_read / 1e9), "MiB/s");
+	}
+
+	std::experimental::filesystem::remove(pack_file);
+}
+
+VCL_FILESYSTEM_BENCHMARK(PackDeduplicate)
+{
+	using namespace Vcl::FileSystem;
+	using Vcl::FileSystem::Benchmark::measure;
+	using Vcl::FileSystem::Benchmark::report;
+
+	// Each texture of a set is copied to every level
+	const size_t nr_textures = 64;
+	const size_t texture_size = 256 << 10;
+	const auto content = makeContent(nr_textures * texture_size);
+	const std::experimental::filesystem::path pack_file{ "PackDeduplicateBenchmark.pack" };
+
+	for (size_t nr_copies : { 1, 4, 16 })
+	{
+		const auto ns_build = measure(1, [&](uint64_t)
+		{
+			Util::PackWriter writer{ pack_file, 0 };
+			for (size_t level = 0; level < nr_copies; level++)
+			{
+				for (size_t t = 0; t < nr_textures; t++)
+				{
+					const auto name = "level" + std::to_string(level) + "/texture" + std::to_string(t) + ".dds";
+					writer.addFile(name, content.data() + t * texture_size, texture_size);
+				}
+			}
+			writer.finalize();
+		});
+
+		PackOptions options;
+		options.CacheBudget = size_t(1) << 30;
+
+		auto mount = std::make_unique<PackMountPoint>("Content", "/content", pack_file, options);
+		const auto* cache = mount->cache();
+
+		FileSystem fs;
+		fs.addMountPoint(std::move(mount));
+
+		std::vector<char> buffer(texture_size);
+		size_t read = 0;
+		const auto ns_read = measure(1, [&](uint64_t)
+		{
+			for (size_t level = 0; level < nr_copies; level++)
+			{
+				for (size_t t = 0; t < nr_textures; t++)
+				{
+					auto reader = fs.createReader("/content/level" + std::to_string(level) + "/texture" + std::to_string(t) + ".dds");
+					read += reader->read(buffer.data(), buffer.size());
+				}
+			}
+		});
+		Vcl::FileSystem::Benchmark::doNotOptimize(read);
+
+		const double total_size = static_cast<double>(nr_copies * content.size());
+		const auto config = std::to_string(nr_copies) + " copies";
+		report("PackDeduplicate/build", config, ns_build / 1e6, "ms");
+		report("PackDeduplicate/ratio", config, 100.0 * std::experimental::filesystem::file_size(pack_file) / total_size, "%");
+		report("PackDeduplicate/read all", config, ns_read / 1e6, "ms");
+		report("PackDeduplicate/cache", config, 100.0 * cache->size() / total_size, "%");
+	}
+
+	std::experimental::filesystem::remove(pack_file);
+}
@@ -0,0 +1,82 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/volumemountpoint.h>
+
+// Benchmark support
+#include "benchmark.h"
+
+VCL_FILESYSTEM_BENCHMARK(VolumeBatchLoad)
+{
+	namespace fs = std::experimental::filesystem;
+	using namespace Vcl::FileSystem;
+
+	// Directory with many small files, spread over sub-directories
+	const size_t nr_files = 100000;
+	const fs::path content_dir{ "BatchBenchmarkContent" };
+	fs::remove_all(content_dir);
+
+	std::vector<fs::path> files;
+	files.reserve(nr_files);
+	std::string content(1024, 'x');
+	for (size_t f = 0; f < nr_files; f++)
+	{
+		const auto dir_name = std::to_string(f / 1000);
+		if (f % 1000 == 0)
+			fs::create_directories(content_dir / dir_name);
+
+		const auto file_name = dir_name + "/" + std::to_string(f) + ".bin";
+		std::ofstream file{ (content_dir / file_name).string(), std::ios::binary };
+		file.write(content.data(), 512 + f % 512);
+		files.emplace_back("/content/" + file_name);
+	}
+
+	VolumeMountPoint mp{ "Content", "/content", content_dir };
+	for (auto io : { VolumeBatchIO::Blocking, VolumeBatchIO::Ring, VolumeBatchIO::Blocking, VolumeBatchIO::Ring })
+	{
+		size_t loaded_bytes = 0;
+		const auto ns = Vcl::FileSystem::Benchmark::measure(1, [&](uint64_t)
+		{
+			for (const auto& file : mp.loadFiles(files, io))
+				loaded_bytes += file.Data.size();
+		});
+		Vcl::FileSystem::Benchmark::doNotOptimize(loaded_bytes);
+
+		const auto config = std::string(io == VolumeBatchIO::Ring ? "io_uring" : "blocking") + ", " + std::to_string(nr_files) + " files";
+		Vcl::FileSystem::Benchmark::report("VolumeBatchLoad/file", config, ns / nr_files);
+	}
+
+	fs::remove_all(content_dir);
+}
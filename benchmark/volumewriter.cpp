@@ -0,0 +1,69 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <string>
+#include <vector>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/volumemountpoint.h>
+#include <vcl/filesystem/filesystem.h>
+
+// Benchmark support
+#include "benchmark.h"
+
+VCL_FILESYSTEM_BENCHMARK(VolumeWrite)
+{
+	namespace fs = std::experimental::filesystem;
+	using namespace Vcl::FileSystem;
+
+	const fs::path content_dir{ "WriteBenchmarkContent" };
+	fs::remove_all(content_dir);
+
+	FileSystem file_system;
+	file_system.addMountPoint(std::make_unique<VolumeMountPoint>("Content", "/content", content_dir));
+
+	const uint64_t file_size = 256ull << 20;
+	std::vector<char> data(4 << 20, 'x');
+	for (uint64_t write_size : { 64, 4096, 4 << 20 })
+	{
+		const auto ns = Vcl::FileSystem::Benchmark::measure(1, [&](uint64_t)
+		{
+			auto writer = file_system.createWriter("/content/Cache.bin");
+			writer->reserve(file_size);
+			for (uint64_t written = 0; written < file_size; written += write_size)
+				writer->write(data.data(), write_size);
+			writer->close();
+		});
+
+		const auto config = std::to_string(write_size) + " B writes";
+		Vcl::FileSystem::Benchmark::report("VolumeWrite/MiB", config, ns / (file_size >> 20));
+	}
+
+	fs::remove_all(content_dir);
+}
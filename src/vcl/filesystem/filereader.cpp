@@ -24,6 +24,9 @@
  */
 #include "filereader.h"
 
+// C++ standard library
+#include <algorithm>
+
 namespace Vcl { namespace FileSystem
 {
 	FileReader::FileReader(path virtual_path)
@@ -31,4 +34,44 @@ namespace Vcl { namespace FileSystem
 	{
 
 	}
+
+	uint64_t FileReader::readv(std::vector<ReadRequest>& requests) const
+	{
+		uint64_t read_bytes = 0;
+		for (auto* request : sortByOffset(requests))
+		{
+			request->ReadBytes = readAt(request->Offset, request->Buffer, request->Size);
+			read_bytes += request->ReadBytes;
+		}
+
+		return read_bytes;
+	}
+
+	std::vector<ReadRequest*> FileReader::sortByOffset(std::vector<ReadRequest>& requests)
+	{
+		std::vector<ReadRequest*> order;
+		order.reserve(requests.size());
+		for (auto& request : requests)
+			order.push_back(&request);
+
+		std::stable_sort(order.begin(), order.end(), [](const ReadRequest* a, const ReadRequest* b)
+		{
+			return a->Offset < b->Offset;
+		});
+
+		return order;
+	}
+
+	FileView FileReader::view(uint64_t offset, uint64_t size) const
+	{
+		if (offset >= this->size())
+			return{};
+
+		size = std::min(size, this->size() - offset);
+		std::shared_ptr<std::byte> buffer{ new std::byte[size], std::default_delete<std::byte[]>() };
+		const auto read_bytes = readAt(offset, buffer.get(), size);
+
+		const std::byte* data = buffer.get();
+		return{ data, read_bytes, std::move(buffer) };
+	}
 }}
@@ -28,11 +28,66 @@
 #include <vcl/config/global.h>
 
 // C++ standard library
+#include <cstddef>
 #include <cstdint>
-#include <filesystem>
+#include <experimental/filesystem>
+#include <memory>
+#include <vector>
 
 namespace Vcl { namespace FileSystem
 {
+	/*!
+	 *	\brief Read-only view of a range of a file
+	 *
+	 *	The view either points directly into memory backing the file (e.g. a
+	 *	memory mapped file) or into a copy owned by the view. In both cases
+	 *	the memory stays valid as long as the view exists.
+	 */
+	class FileView
+	{
+	public:
+		FileView() = default;
+		FileView(const std::byte* data, uint64_t size, std::shared_ptr<const void> storage)
+		: _data{ data }
+		, _size{ size }
+		, _storage{ std::move(storage) }
+		{
+		}
+
+		const std::byte* data() const { return _data; }
+		uint64_t size() const { return _size; }
+		bool empty() const { return _size == 0; }
+
+		const std::byte* begin() const { return _data; }
+		const std::byte* end() const { return _data + _size; }
+
+	private:
+		//! Start of the viewed memory
+		const std::byte* _data{ nullptr };
+
+		//! Number of bytes in the view
+		uint64_t _size{ 0 };
+
+		//! Keeps the viewed memory alive
+		std::shared_ptr<const void> _storage;
+	};
+
+	//! Single range of a batched read
+	struct ReadRequest
+	{
+		//! Position in the file to start reading from
+		uint64_t Offset{ 0 };
+
+		//! Buffer to write the data to
+		void* Buffer{ nullptr };
+
+		//! Number of bytes to read
+		uint64_t Size{ 0 };
+
+		//! Number of bytes read, set by the reader
+		uint64_t ReadBytes{ 0 };
+	};
+
 	class FileReader
 	{
 	protected:
@@ -40,15 +95,54 @@ namespace Vcl { namespace FileSystem
 
 	public:
 		FileReader(path virtual_path);
+		virtual ~FileReader() = default;
 
 		virtual void     seek(const uint64_t pos) = 0;
 		virtual uint64_t read(void* buf, const uint64_t size) = 0;
 
+		/*!
+		 *	\brief Read from a fixed position of the file
+		 *	\param offset Position in the file to start reading from
+		 *	\param buf Buffer to write the data to
+		 *	\param size Number of bytes to read
+		 *	\returns the number of bytes read
+		 *
+		 *	The current position of the reader is neither used nor modified.
+		 *	The method can be called from multiple threads at the same time.
+		 */
+		virtual uint64_t readAt(uint64_t offset, void* buf, const uint64_t size) const = 0;
+
+		/*!
+		 *	\brief Read multiple ranges of the file at once
+		 *	\param requests Ranges to read. 'ReadBytes' is updated for each request.
+		 *	\returns the total number of bytes read
+		 *
+		 *	The requests may be given in any order. Readers process them in the
+		 *	order of the file and combine neighbouring ranges where possible.
+		 *	Like 'readAt', the current position is neither used nor modified.
+		 */
+		virtual uint64_t readv(std::vector<ReadRequest>& requests) const;
+
+		/*!
+		 *	\brief Access a range of the file without copying it
+		 *	\param offset Start of the range in the file
+		 *	\param size Number of bytes in the range
+		 *	\returns a view of the range, clamped to the end of the file
+		 *
+		 *	Readers which cannot access the file content in memory copy the range
+		 *	into a buffer owned by the view. The current position is not changed.
+		 */
+		virtual FileView view(uint64_t offset, uint64_t size) const;
+
 		//! \returns true if the end-of-file is reached
 		virtual bool     eof() const = 0;
 		virtual uint64_t size() const = 0;
 		virtual uint64_t pos() const = 0;
 
+	protected:
+		//! \returns pointers to the requests sorted by their offset
+		static std::vector<ReadRequest*> sortByOffset(std::vector<ReadRequest>& requests);
+
 	public: // Properties
 
 		//! \returns the path of the file within the virtual file system
@@ -25,23 +25,113 @@
 #include "filesystem.h"
 
 // C++ Standard Library
-#include <numeric>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+// VCL File System Library
+#include "util/threadpool.h"
 
 namespace Vcl { namespace FileSystem
 {
+	namespace
+	{
+		using path = std::experimental::filesystem::path;
+		using path_view = std::basic_string_view<path::value_type>;
+
+		bool isSeparator(path::value_type c)
+		{
+			return c == '/' || c == path::preferred_separator;
+		}
+
+		/*!
+		 *	\brief Visit the components of a path without allocating memory
+		 *	\param str Native representation of the path
+		 *	\param visitor Function called for each component. Returning false stops the iteration.
+		 *
+		 *	Empty components as well as '.' are skipped.
+		 */
+		template<typename Func>
+		void forEachComponent(path_view str, Func&& visitor)
+		{
+			size_t begin = 0;
+			while (begin < str.size())
+			{
+				if (isSeparator(str[begin]))
+				{
+					++begin;
+					continue;
+				}
+
+				size_t end = begin;
+				while (end < str.size() && !isSeparator(str[end]))
+					++end;
+
+				auto component = str.substr(begin, end - begin);
+				if (!(component.size() == 1 && component[0] == '.') && !visitor(component))
+					return;
+
+				begin = end;
+			}
+		}
+	}
+
+	FileSystem::FileSystem()
+	: FileSystem{ std::max(std::thread::hardware_concurrency(), 2u), 256 }
+	{
+	}
+
+	FileSystem::FileSystem(unsigned int nr_workers, size_t max_queued)
+	: _nrWorkers{ nr_workers }
+	, _maxQueued{ max_queued }
+	{
+	}
+
+	FileSystem::~FileSystem() = default;
+
 	void FileSystem::addMountPoint(std::unique_ptr<MountPoint> mp)
 	{
+		// Register the mount point in the tree of mount paths
+		MountPointNode* node = &_mountTree;
+		forEachComponent(mp->mountPath().native(), [&node](path_view name)
+		{
+			auto child = std::lower_bound(node->Children.begin(), node->Children.end(), name, [](const std::unique_ptr<MountPointNode>& n, path_view name)
+			{
+				return n->Name < name;
+			});
+
+			if (child == node->Children.end() || (*child)->Name != name)
+			{
+				auto new_node = std::make_unique<MountPointNode>();
+				new_node->Name = path::string_type{ name };
+				child = node->Children.emplace(child, std::move(new_node));
+			}
+
+			node = child->get();
+			return true;
+		});
+
+		// If the same path is mounted multiple times, the first mount point is used
+		if (!node->Mount)
+			node->Mount = mp.get();
+
 		// Store the mount point
 		_mountPoints.emplace_back(std::move(mp));
 	}
 
 	std::shared_ptr<FileReader> FileSystem::createReader(const path& file_name)
 	{
-		if (!exists(file_name))
+		return createReader(file_name, resolve(file_name));
+	}
+
+	std::shared_ptr<FileReader> FileSystem::createReader(const path& file_name, const ResolvedEntry& entry)
+	{
+		if (!entry)
 			throw std::domain_error(file_name.string() + " does not exist.");
 
-		auto mp = findMountPoint(file_name);
-		return mp->createReader(file_name);
+		return entry.Mount->createReader(file_name, entry);
 	}
 
 	std::shared_ptr<FileWriter> FileSystem::createWriter(const path& file_name)
@@ -51,31 +141,96 @@ namespace Vcl { namespace FileSystem
 	}
 
 	bool FileSystem::exists(const path& entry)
+	{
+		return static_cast<bool>(resolve(entry));
+	}
+
+	FileStatus FileSystem::stat(const path& entry)
+	{
+		auto resolved = resolve(entry);
+		if (!resolved)
+			throw std::domain_error(entry.string() + " does not exist.");
+
+		return resolved.Status;
+	}
+
+	ResolvedEntry FileSystem::resolve(const path& entry) const
 	{
 		auto mp = findMountPoint(entry);
-		if (mp)
+		if (!mp)
+			return{};
+
+		auto resolved = mp->resolve(entry);
+		resolved.Mount = mp;
+		return resolved;
+	}
+
+	AsyncRequest FileSystem::readAsync(const path& file_name, uint64_t offset, uint64_t size, AsyncCallback callback)
+	{
+		auto cancelled = std::make_shared<std::atomic<bool>>(false);
+		auto task = std::make_shared<std::packaged_task<std::vector<std::byte>()>>([this, file_name, offset, size, callback, cancelled]()
 		{
-			return mp->exists(entry);
-		}
-		else
+			if (cancelled->load())
+				throw RequestCancelled{};
+
+			auto reader = createReader(file_name);
+			if (offset >= reader->size())
+				return std::vector<std::byte>{};
+
+			std::vector<std::byte> data(std::min(size, reader->size() - offset));
+			data.resize(reader->readAt(offset, data.data(), data.size()));
+
+			if (callback)
+				callback(file_name, data);
+
+			return data;
+		});
+
+		AsyncRequest request{ task->get_future(), cancelled };
+		workers().enqueue([task]() { (*task)(); });
+		return request;
+	}
+
+	AsyncRequest FileSystem::loadAsync(const path& file_name, AsyncCallback callback)
+	{
+		return readAsync(file_name, 0, std::numeric_limits<uint64_t>::max(), std::move(callback));
+	}
+
+	Util::ThreadPool& FileSystem::workers()
+	{
+		std::call_once(_workersCreated, [this]()
 		{
-			return false;
-		}
+			_workers = std::make_unique<Util::ThreadPool>(_nrWorkers, _maxQueued);
+		});
+
+		return *_workers;
 	}
 
-	MountPoint* FileSystem::findMountPoint(path entry) const
+	MountPoint* FileSystem::findMountPoint(const path& entry) const
 	{
 		// Only consider the directory of the path to search for the mount point
-		entry.remove_filename();
+		path_view dir = entry.native();
+		auto last_sep = std::find_if(dir.rbegin(), dir.rend(), isSeparator);
+		dir = dir.substr(0, static_cast<size_t>(std::distance(last_sep, dir.rend())));
 
-		MountPoint* init{ nullptr };
-		auto mp = std::accumulate(_mountPoints.begin(), _mountPoints.end(), init, [&entry](MountPoint* a, const std::unique_ptr<MountPoint>& b) -> MountPoint*
+		// Walk down the tree and remember the deepest mount point
+		const MountPointNode* node = &_mountTree;
+		MountPoint* mp = node->Mount;
+		forEachComponent(dir, [&node, &mp](path_view name)
 		{
-			if ((!a || a->mountPath().string().length() < b->mountPath().string().length()) && 
-			    b->mountPath().compare(entry) <= 0)
-				return b.get();
-			else
-				return a;
+			auto child = std::lower_bound(node->Children.begin(), node->Children.end(), name, [](const std::unique_ptr<MountPointNode>& n, path_view name)
+			{
+				return n->Name < name;
+			});
+
+			if (child == node->Children.end() || (*child)->Name != name)
+				return false;
+
+			node = child->get();
+			if (node->Mount)
+				mp = node->Mount;
+
+			return true;
 		});
 
 		return mp;
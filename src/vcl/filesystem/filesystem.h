@@ -28,8 +28,15 @@
 #include <vcl/config/global.h>
 
 // C++ Standard Library
-#include <filesystem>
-#include <unordered_map>
+#include <atomic>
+#include <cstddef>
+#include <experimental/filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 // VCL File System Library
@@ -39,11 +46,76 @@
 
 namespace Vcl { namespace FileSystem
 {
+	namespace Util { class ThreadPool; }
+
+	//! Error reported by asynchronous requests cancelled before they were started
+	class RequestCancelled : public std::runtime_error
+	{
+	public:
+		RequestCancelled() : std::runtime_error{ "Request was cancelled." } {}
+	};
+
+	/*!
+	 *	\brief Handle to an asynchronous read request
+	 *
+	 *	The data is delivered through a future. Errors while reading
+	 *	the file are reported as exceptions when accessing the result.
+	 */
+	class AsyncRequest
+	{
+	public:
+		AsyncRequest(std::future<std::vector<std::byte>> result, std::shared_ptr<std::atomic<bool>> cancelled)
+		: _result{ std::move(result) }
+		, _cancelled{ std::move(cancelled) }
+		{
+		}
+
+		/*!
+		 *	\brief Cancel the request
+		 *
+		 *	Requests which are not started yet are completed with a
+		 *	'RequestCancelled' error. Running requests finish normally.
+		 */
+		void cancel() { _cancelled->store(true); }
+
+		//! \returns true if the request was cancelled
+		bool cancelled() const { return _cancelled->load(); }
+
+		//! Block until the request is completed
+		void wait() const { _result.wait(); }
+
+		//! \returns the read data once the request is completed
+		std::vector<std::byte> get() { return _result.get(); }
+
+		//! \returns the future delivering the read data
+		std::future<std::vector<std::byte>>& future() { return _result; }
+
+	private:
+		//! Result of the request
+		std::future<std::vector<std::byte>> _result;
+
+		//! Cancellation state shared with the worker
+		std::shared_ptr<std::atomic<bool>> _cancelled;
+	};
+
 	class FileSystem
 	{
 		using path = std::experimental::filesystem::path;
 
 	public:
+		//! Function called by the worker once the data of an asynchronous request is available
+		using AsyncCallback = std::function<void(const path& file_name, const std::vector<std::byte>& data)>;
+
+		FileSystem();
+
+		/*!
+		 *	\brief Create a file system with a custom set of I/O workers
+		 *	\param nr_workers Number of threads processing asynchronous requests
+		 *	\param max_queued Maximum number of pending asynchronous requests
+		 */
+		FileSystem(unsigned int nr_workers, size_t max_queued);
+		~FileSystem();
+
 		/*!
 		 *	\brief Add a new mount point to the virtual file system
 		 */
@@ -66,16 +138,100 @@ namespace Vcl { namespace FileSystem
 		  */
 		bool exists(const path& entry);
 
+		 /*!
+		  *	\brief Query the properties of an entry
+		  *	\param entry path to query
+		  *	\returns the size and type of the entry
+		  */
+		FileStatus stat(const path& entry);
+
+		 /*!
+		  *	\brief Locate an entry in the virtual file system
+		  *	\param entry path to locate
+		  *	\returns the entry together with the mount point it belongs to
+		  *
+		  *	The mount point and the entry within the mount point are searched
+		  *	only once. The result can be passed to 'createReader' in order to
+		  *	open the entry without searching it again.
+		  */
+		ResolvedEntry resolve(const path& entry) const;
+
+		 /*!
+		  *	\brief Create a new file reader for a resolved entry
+		  */
+		std::shared_ptr<FileReader> createReader(const path& file_name, const ResolvedEntry& entry);
+
+		 /*!
+		  *	\brief Read a range of a file on a worker thread
+		  *	\param file_name File to read from
+		  *	\param offset Start of the range
+		  *	\param size Number of bytes to read
+		  *	\param callback Optional function called on the worker thread once the data is read
+		  *	\returns a handle to the request
+		  *
+		  *	The calling thread only blocks if the maximum number of pending requests is reached.
+		  */
+		AsyncRequest readAsync(const path& file_name, uint64_t offset, uint64_t size, AsyncCallback callback = {});
+
+		 /*!
+		  *	\brief Read an entire file on a worker thread
+		  *	\param file_name File to read
+		  *	\param callback Optional function called on the worker thread once the data is read
+		  *	\returns a handle to the request
+		  */
+		AsyncRequest loadAsync(const path& file_name, AsyncCallback callback = {});
+
 	private:
+		/*!
+		 *	\brief Node in the tree of mount points
+		 *
+		 *	Each node represents a single component of a mount path.
+		 *	The children are kept sorted by name in order to allow
+		 *	a binary search while walking down the tree.
+		 */
+		struct MountPointNode
+		{
+			//! Path component represented by this node
+			path::string_type Name;
+
+			//! Mount point registered at this node (may be empty)
+			MountPoint* Mount{ nullptr };
+
+			//! Sub-directories containing further mount points
+			std::vector<std::unique_ptr<MountPointNode>> Children;
+		};
+
 		/*!
 		 *	\brief Find the mount point with the longst overlap with the path
 		 *	\param entry path to search the mount point for
 		 *	\returns the mount point belonging to the path 'entry'
+		 *
+		 *	The lookup walks the directory components of 'entry' down the
+		 *	mount point tree. Its cost only depends on the depth of the path
+		 *	and it does not allocate any memory.
 		 */
-		MountPoint* findMountPoint(path entry) const;
+		MountPoint* findMountPoint(const path& entry) const;
+
+		//! \returns the workers for asynchronous requests, created on first use
+		Util::ThreadPool& workers();
 
 	private:
 		/// Mount points
 		std::vector<std::unique_ptr<MountPoint>> _mountPoints;
+
+		/// Mount points organized by the components of their mount paths
+		MountPointNode _mountTree;
+
+		/// Number of threads processing asynchronous requests
+		unsigned int _nrWorkers;
+
+		/// Maximum number of pending asynchronous requests
+		size_t _maxQueued;
+
+		/// Guards the creation of the workers
+		std::once_flag _workersCreated;
+
+		/// Workers processing asynchronous requests. Destroyed first to finish pending requests.
+		std::unique_ptr<Util::ThreadPool> _workers;
 	};
 }}
@@ -31,5 +31,18 @@ namespace Vcl { namespace FileSystem
 	{
 
 	}
+
+	void FileWriter::reserve(const uint64_t)
+	{
+	}
+
+	void FileWriter::flush()
+	{
+	}
+
+	void FileWriter::close()
+	{
+		flush();
+	}
 }}
 
@@ -29,7 +29,7 @@
 
 // C++ standard library
 #include <cstdint>
-#include <filesystem>
+#include <experimental/filesystem>
 
 namespace Vcl { namespace FileSystem
 {
@@ -40,12 +40,28 @@ namespace Vcl { namespace FileSystem
 
 	public:
 		FileWriter(path virtual_path);
+		virtual ~FileWriter() = default;
 
 		virtual void     seek(const uint64_t pos) = 0;
 		virtual void     write(void* buf, const uint64_t size) = 0;
 
 		virtual uint64_t pos() const = 0;
 
+		/*!
+		 *	\brief Announce the final size of the file
+		 *	\param size Expected size of the file in bytes
+		 *
+		 *	Writers may use the hint to allocate the storage up-front.
+		 *	The size of the file is not changed.
+		 */
+		virtual void     reserve(const uint64_t size);
+
+		//! Pass all buffered data to the underlying storage
+		virtual void     flush();
+
+		//! Flush the buffered data and release the underlying storage. No writes are allowed afterwards.
+		virtual void     close();
+
 	public: // Properties
 
 		//! \returns the path of the file within the virtual file system
@@ -28,7 +28,10 @@
 #include <vcl/config/global.h>
 
 // C++ Standard Library
-#include <filesystem>
+#include <cstdint>
+#include <experimental/filesystem>
+#include <memory>
+#include <vector>
 
 // VCL File System Library
 #include "filereader.h"
@@ -36,6 +39,56 @@
 
 namespace Vcl { namespace FileSystem
 {
+	class MountPoint;
+
+	//! Properties of an entry in the virtual file system
+	struct FileStatus
+	{
+		//! Size of the entry in bytes
+		uint64_t Size{ 0 };
+
+		//! True if the entry is a directory
+		bool IsDirectory{ false };
+	};
+
+	//! Content of a file loaded as part of a batch
+	struct LoadedFile
+	{
+		//! Content of the file
+		std::vector<std::byte> Data;
+
+		//! Error code (errno) of the failed operation, 0 on success
+		int Error{ 0 };
+	};
+
+	/*!
+	 *	\brief Entry located by a mount point
+	 *
+	 *	'Index' and 'Handle' are specific to the mount point resolving the
+	 *	entry and are only interpreted by that mount point. They allow opening
+	 *	the entry without searching it a second time.
+	 */
+	struct ResolvedEntry
+	{
+		//! True if the entry was found
+		bool Exists{ false };
+
+		//! Mount point the entry belongs to
+		MountPoint* Mount{ nullptr };
+
+		//! Mount point specific index of the entry
+		uint64_t Index{ 0 };
+
+		//! Mount point specific data of the entry
+		std::shared_ptr<void> Handle;
+
+		//! Properties of the entry
+		FileStatus Status;
+
+		//! \returns true if the entry exists
+		explicit operator bool() const { return Exists; }
+	};
+
 	class MountPoint
 	{
 	protected:
@@ -43,22 +96,29 @@ namespace Vcl { namespace FileSystem
 
 	public:
 		MountPoint(std::string name, path mount_path);
-		
+		virtual ~MountPoint() = default;
+
+		 /*!
+		  *	\brief Locate an entry of the mount point
+		  *	\param entry path of the entry in the virtual file system
+		  *	\returns the entry, which evaluates to false if it does not exist
+		  */
+		virtual ResolvedEntry resolve(const path& entry) const = 0;
+
 		 /*!
 		  *	\brief Create a new file reader
+		  *	\param file_name path of the file in the virtual file system
+		  *	\param entry entry previously returned by 'resolve' for 'file_name'
 		  */
-		virtual std::shared_ptr<FileReader> createReader(const path& file_name) = 0;
+		virtual std::shared_ptr<FileReader> createReader(const path& file_name, const ResolvedEntry& entry) = 0;
 		
 		 /*!
 		  *	\brief Create a new file writer
 		  */
 		virtual std::shared_ptr<FileWriter> createWriter(const path& file_name) = 0;
 
-		//! 
-		virtual bool exists(const path& entry) const = 0;
-
 		//! \returns the path in the virtual file system, where this mount-point is mounted.
-		const path mountPath() const { return _mountPath; }
+		const path& mountPath() const { return _mountPath; }
 		
 	protected:
 		//! \returns the relative part of a filename for this mount point
@@ -24,36 +24,423 @@
  */
 #include "archivemountpoint.h"
 
+// C++ standard library
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+ // ZipLib
+#include <ZipLib/ZipFile.h>
+
  // VCL File System Library
 #include "../readers/archivefilereader.h"
+#include "../readers/bufferfilereader.h"
+#include "../readers/inflatefilereader.h"
+#include "../readers/mappedfilereader.h"
+#include "../writers/archivefilewriter.h"
+#include "../util/threadpool.h"
 
 namespace Vcl { namespace FileSystem
 {
-	ArchiveMountPoint::ArchiveMountPoint(std::string name, path mount_path, path volume_path)
+	ArchiveMountPoint::ArchiveMountPoint(std::string name, path mount_path, path volume_path, ArchiveOptions options)
 	: MountPoint{ std::move(name), std::move(mount_path) }
-	, _archive{ volume_path }
+	, _volumePath{ std::move(volume_path) }
+	, _options{ options }
 	{
+		if (_options.Create)
+			_writer = std::make_shared<Util::ArchiveWriter>(_volumePath, numWorkers(), _options.CompressionLevel, _options.CompressionBlockSize);
+		else
+			_archive = std::make_unique<Util::Archive>(_volumePath);
+
+		if (_options.CacheBudget > 0)
+			_cache = std::make_unique<Util::EntryCache>(_options.CacheBudget, _options.MaxCachedSize);
 	}
 
-	std::shared_ptr<FileReader> ArchiveMountPoint::createReader(const path& file_name)
+	ArchiveMountPoint::~ArchiveMountPoint() = default;
+
+	void ArchiveMountPoint::beginUpdate()
 	{
-		// Remove the mount path from the entry
-		path rel_path = relativePath(file_name);
+		if (_writer)
+			throw std::logic_error(_volumePath.string() + " is already being written.");
+		if (!_archive)
+			throw std::logic_error(_volumePath.string() + " is not opened.");
 
-		auto entry = _archive.entry(rel_path);
-		return std::make_shared<ArchiveFileReader>(file_name, entry);
+		_writer = std::make_shared<Util::ArchiveWriter>(*_archive, numWorkers(), _options.CompressionLevel, _options.CompressionBlockSize);
 	}
 
-	std::shared_ptr<FileWriter> ArchiveMountPoint::createWriter(const path& file_name)
+	void ArchiveMountPoint::finalize()
 	{
-		return{};
+		if (!_writer)
+			return;
+
+		// The writer is kept until the archive is opened, thus failures with open entries can be retried
+		try
+		{
+			_writer->finalize();
+		}
+		catch (...)
+		{
+			// A writer failing to write the archive already restored an updated archive
+			if (_writer->isFinalized())
+				_writer.reset();
+			throw;
+		}
+
+		if (!_archive)
+		{
+			_archive = std::make_unique<Util::Archive>(_volumePath);
+			_writer.reset();
+			return;
+		}
+
+		// The index still describes the previous archive if the update fails, thus the appended data is removed
+		const auto base_size = _archive->mapping()->size();
+		std::vector<size_t> replaced;
+		try
+		{
+			replaced = _archive->update(_writer->writtenEntries());
+		}
+		catch (...)
+		{
+			std::error_code ec;
+			std::experimental::filesystem::resize_file(_volumePath, base_size, ec);
+			_writer.reset();
+			throw;
+		}
+
+		// Open writers keep the archive writer alive, it is not used for new files anymore
+		_writer.reset();
+
+		// Replaced entries keep their index, thus their decompressed content is outdated
+		for (size_t idx : replaced)
+		{
+			if (_cache)
+				_cache->erase(idx);
+			_seekIndices.erase(idx);
+		}
 	}
 
-	bool ArchiveMountPoint::exists(const path& entry) const
+	void ArchiveMountPoint::compact()
 	{
+		if (_writer)
+			throw std::logic_error(_volumePath.string() + " is being written.");
+		if (!_archive)
+			throw std::logic_error(_volumePath.string() + " is not opened.");
+
+		const path compacted = _volumePath.string() + ".compact";
+		try
+		{
+			Util::ArchiveWriter writer{ compacted, 1 };
+			for (size_t idx = 0; idx < _archive->nrEntries(); idx++)
+				writer.copyEntry(*_archive, idx);
+			writer.finalize();
+		}
+		catch (...)
+		{
+			std::error_code ec;
+			std::experimental::filesystem::remove(compacted, ec);
+			throw;
+		}
+
+		// Mapped files cannot be replaced on Windows, thus the archive is released during the rename
+		_archive.reset();
+		try
+		{
+			std::experimental::filesystem::rename(compacted, _volumePath);
+		}
+		catch (...)
+		{
+			std::error_code ec;
+			std::experimental::filesystem::remove(compacted, ec);
+			_archive = std::make_unique<Util::Archive>(_volumePath);
+			throw;
+		}
+
+		// Entries keep their order, thus cached content and seek indices remain valid
+		try
+		{
+			_archive = std::make_unique<Util::Archive>(_volumePath);
+		}
+		catch (...)
+		{
+			// The previous archive was replaced, thus the mount point is left without entries
+			if (_cache)
+				_cache->clear();
+			{
+				std::lock_guard<std::shared_mutex> guard{ _seekIndexMutex };
+				_seekIndices.clear();
+			}
+			throw;
+		}
+	}
+
+	ResolvedEntry ArchiveMountPoint::resolve(const path& entry) const
+	{
+		if (!_archive)
+			return{};
+
 		// Remove the mount path from the entry
-		path rel_path = relativePath(entry);
+		const auto idx = _archive->findPath(relativePath(entry));
+		if (idx == Util::Archive::npos)
+			return{};
+
+		ResolvedEntry resolved;
+		resolved.Exists = true;
+		resolved.Index = idx;
+		resolved.Status.Size = _archive->entry(idx).Size;
+		resolved.Status.IsDirectory = _archive->isDirectory(idx);
+		return resolved;
+	}
+
+	std::shared_ptr<FileReader> ArchiveMountPoint::createReader(const path& file_name, const ResolvedEntry& entry)
+	{
+		const auto idx = static_cast<size_t>(entry.Index);
+		if (isCached(idx))
+			return std::make_shared<BufferFileReader>(file_name, loadCached(file_name, idx));
+
+		return openEntry(file_name, idx);
+	}
+
+	std::vector<LoadedFile> ArchiveMountPoint::loadFiles(const std::vector<path>& files) const
+	{
+		std::vector<LoadedFile> results(files.size());
+		std::vector<size_t> entries(files.size(), Util::Archive::npos);
+		std::vector<uint64_t> sizes(files.size(), 0);
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			const auto idx = _archive ? _archive->findPath(relativePath(files[i])) : Util::Archive::npos;
+			if (idx == Util::Archive::npos)
+				results[i].Error = ENOENT;
+			else if (_archive->isDirectory(idx))
+				results[i].Error = EISDIR;
+			else
+			{
+				entries[i] = idx;
+				sizes[i] = _archive->entry(idx).Size;
+			}
+		}
+
+		// The results are kept until the end, thus limiting the work in flight would not bound the memory
+		runParallel(sizes, std::numeric_limits<uint64_t>::max(), [&](size_t i)
+		{
+			const auto idx = entries[i];
+			if (idx == Util::Archive::npos)
+				return;
+
+			auto& data = results[i].Data;
+			try
+			{
+				if (isCached(idx))
+				{
+					const auto content = loadCached(files[i], idx);
+					data.assign(content->begin(), content->end());
+				}
+				else
+				{
+					data.resize(sizes[i]);
+					data.resize(openEntry(files[i], idx)->readAt(0, data.data(), data.size()));
+				}
+			}
+			catch (const std::exception&)
+			{
+				data.clear();
+				results[i].Error = EIO;
+			}
+		});
+
+		return results;
+	}
+
+	void ArchiveMountPoint::prefetch(const std::vector<path>& files)
+	{
+		if (!_cache || !_archive)
+			return;
+
+		std::vector<path> names;
+		std::vector<size_t> entries;
+		std::vector<uint64_t> sizes;
+		for (const auto& file : files)
+		{
+			const auto idx = _archive->findPath(relativePath(file));
+			if (idx == Util::Archive::npos || _archive->isDirectory(idx) || !isCached(idx))
+				continue;
+
+			names.push_back(file);
+			entries.push_back(idx);
+			sizes.push_back(_archive->entry(idx).Size);
+		}
+
+		runParallel(sizes, _options.MaxPrefetchInFlight, [&](size_t i)
+		{
+			try
+			{
+				loadCached(names[i], entries[i]);
+			}
+			catch (const std::exception&)
+			{
+				// Failed entries report their error when they are read
+			}
+		});
+	}
+
+	bool ArchiveMountPoint::isCached(size_t idx) const
+	{
+		// Stored entries are read from the mapping without copies, caching them would not help
+		const auto& entry = _archive->entry(idx);
+		return _cache && entry.Method != Util::ArchiveEntry::Stored && entry.Size <= _cache->maxEntrySize();
+	}
+
+	Util::EntryCache::Content ArchiveMountPoint::loadCached(const path& file_name, size_t idx) const
+	{
+		return _cache->get(idx, [this, &file_name, idx]()
+		{
+			auto reader = openEntry(file_name, idx);
+			std::vector<std::byte> data(reader->size());
+			data.resize(reader->readAt(0, data.data(), data.size()));
+			return data;
+		});
+	}
+
+	void ArchiveMountPoint::runParallel(const std::vector<uint64_t>& sizes, uint64_t max_in_flight, const std::function<void(size_t)>& task) const
+	{
+		std::mutex mutex;
+		std::condition_variable done;
+		size_t pending = 0;
+		uint64_t in_flight = 0;
+
+		auto& pool = workers();
+		for (size_t i = 0; i < sizes.size(); i++)
+		{
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				done.wait(lock, [&]() { return in_flight == 0 || (in_flight <= max_in_flight && sizes[i] <= max_in_flight - in_flight); });
+				in_flight += sizes[i];
+				pending++;
+			}
+
+			pool.enqueue([&, i]()
+			{
+				task(i);
+
+				// Notify under the lock, the waiting caller destroys the condition variable once it is done
+				std::lock_guard<std::mutex> guard{ mutex };
+				in_flight -= sizes[i];
+				pending--;
+				done.notify_all();
+			});
+		}
+
+		std::unique_lock<std::mutex> lock{ mutex };
+		done.wait(lock, [&]() { return pending == 0; });
+	}
+
+	Util::ThreadPool& ArchiveMountPoint::workers() const
+	{
+		std::call_once(_workersCreated, [this]()
+		{
+			const unsigned int nr_threads = numWorkers();
+			_workers = std::make_unique<Util::ThreadPool>(nr_threads, 2 * nr_threads);
+		});
+
+		return *_workers;
+	}
+
+	unsigned int ArchiveMountPoint::numWorkers() const
+	{
+		return _options.NrWorkers > 0 ? _options.NrWorkers : std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	std::shared_ptr<FileReader> ArchiveMountPoint::openEntry(const path& file_name, size_t idx) const
+	{
+		const auto& entry = _archive->entry(idx);
+		const bool direct = !_archive->isEncrypted(idx);
+		if (direct && entry.Method == Util::ArchiveEntry::Stored)
+		{
+			// Data of stored entries is a plain range of the archive
+			if (entry.CompressedSize != entry.Size)
+				throw std::runtime_error("Unable to open " + file_name.string() + ", the entry is corrupt.");
+
+			return std::make_shared<MappedFileReader>(file_name, _archive->mapping(), _archive->dataOffset(idx), entry.Size);
+		}
+		if (direct && entry.Method == Util::ArchiveEntry::Deflated)
+		{
+			auto archive = _archive->mapping();
+			const auto data = archive->data() + _archive->dataOffset(idx);
+			auto index = seekIndex(idx, data);
+			return std::make_shared<InflateFileReader>(file_name, std::move(archive), data - archive->data(), entry.CompressedSize, entry.Size, std::move(index));
+		}
+
+		auto stream = _archive->stream();
+		auto archive_entry = _archive->openEntry(idx, *stream);
+		if (!archive_entry)
+			throw std::runtime_error("Unable to open " + file_name.string() + ".");
+
+		return std::make_shared<ArchiveFileReader>(file_name, std::move(archive_entry), std::move(stream));
+	}
+
+	std::shared_ptr<const Util::InflateIndex> ArchiveMountPoint::seekIndex(size_t idx, const std::byte* data) const
+	{
+		const auto& entry = _archive->entry(idx);
+		if (_options.SeekIndexSpan == 0 || entry.Size <= _options.SeekIndexSpan)
+			return{};
+
+		// Indices are built once, thus most opens only need the shared lock
+		std::shared_future<std::shared_ptr<const Util::InflateIndex>> existing;
+		{
+			std::shared_lock<std::shared_mutex> guard{ _seekIndexMutex };
+			auto index_it = _seekIndices.find(idx);
+			if (index_it != _seekIndices.end())
+				existing = index_it->second;
+		}
+
+		std::promise<std::shared_ptr<const Util::InflateIndex>> promise;
+		if (!existing.valid())
+		{
+			std::lock_guard<std::shared_mutex> guard{ _seekIndexMutex };
+			auto index_it = _seekIndices.find(idx);
+			if (index_it != _seekIndices.end())
+				existing = index_it->second;
+			else
+			{
+				// Register the pending build, later readers of the entry wait for it
+				_seekIndices.emplace(idx, promise.get_future().share());
+			}
+		}
+
+		// Wait for a concurrent build to complete
+		if (existing.valid())
+			return existing.get();
+
+		// Build the index without blocking readers of other entries
+		try
+		{
+			auto index = std::make_shared<const Util::InflateIndex>(data, entry.CompressedSize, _options.SeekIndexSpan);
+			promise.set_value(index);
+			return index;
+		}
+		catch (...)
+		{
+			// Failed builds are retried by the next reader
+			{
+				std::lock_guard<std::shared_mutex> guard{ _seekIndexMutex };
+				_seekIndices.erase(idx);
+			}
+
+			promise.set_exception(std::current_exception());
+			throw;
+		}
+	}
+
+	std::shared_ptr<FileWriter> ArchiveMountPoint::createWriter(const path& file_name)
+	{
+		if (!_writer)
+			return{};
 
-		return _archive.entryExists(rel_path);
+		return std::make_shared<ArchiveFileWriter>(file_name, _writer, Util::Archive::toEntryName(relativePath(file_name)));
 	}
 }}
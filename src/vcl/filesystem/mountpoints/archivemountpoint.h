@@ -27,12 +27,54 @@
 // VCL configuration
 #include <vcl/config/global.h>
 
+// C++ standard library
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
 // VCL File System Library
 #include "../util/archive.h"
+#include "../util/archivewriter.h"
+#include "../util/entrycache.h"
+#include "../util/inflate.h"
 #include "../mountpoint.h"
 
 namespace Vcl { namespace FileSystem
 {
+	namespace Util { class ThreadPool; }
+
+	//! Configuration of an archive mount point
+	struct ArchiveOptions
+	{
+		//! Maximum number of bytes of decompressed entries kept in memory, 0 disables the cache
+		size_t CacheBudget{ 0 };
+
+		//! Maximum size of a single entry to be cached
+		size_t MaxCachedSize{ 1 << 20 };
+
+		//! Distance of the seek checkpoints of deflated entries in bytes, 0 disables the seek index
+		size_t SeekIndexSpan{ 0 };
+
+		//! Number of threads decompressing batches of entries, 0 uses one per hardware thread
+		unsigned int NrWorkers{ 0 };
+
+		//! Maximum number of uncompressed bytes being prefetched at the same time
+		size_t MaxPrefetchInFlight{ 64 << 20 };
+
+		//! Create a new archive, written through 'createWriter' until the mount point is finalized
+		bool Create{ false };
+
+		//! zlib compression level of new entries (-1 to 9), 0 stores the entries without compression
+		int CompressionLevel{ -1 };
+
+		//! Size of the blocks of new entries which are compressed in parallel
+		size_t CompressionBlockSize{ 128 << 10 };
+	};
+
 	class ArchiveMountPoint : public MountPoint
 	{
 	public:
@@ -40,18 +82,157 @@ namespace Vcl { namespace FileSystem
 		 *	\brief Create a new mount point
 		 *	\param mount_path path to mount the volume directory to
 		 *	\param volume_path path to an archive on an actual volume to be mounted
+		 *	\param options configuration of caching and seeking
+		 *
+		 *	Create a new mount point that maps an archive on a native volume to a specific mount point.
+		 *	Stored and deflated entries are read from a memory mapping of the archive, other
+		 *	compression methods and encrypted entries are read through ZipLib.
+		 *	Readers of the mapping each keep their own decompression state, thus readers
+		 *	on different threads do not wait for each other. Readers using ZipLib share
+		 *	its stream and are serialized.
+		 *	Entries opened through a cache are decompressed once and read from memory afterwards.
+		 *	With a seek index, the first reader of a large deflated entry decompresses it once
+		 *	to record checkpoints. Seeking then resumes from the closest checkpoint.
+		 *	With 'Create' set, a new archive replaces the file at 'volume_path'. Each writer
+		 *	returned by 'createWriter' streams a new entry, which is compressed by the
+		 *	workers of the mount point. Entries can only be read once the mount point
+		 *	is finalized. Mounted archives are updated in the same way after 'beginUpdate',
+		 *	appending the new entries behind the existing data.
+		 */
+		ArchiveMountPoint(std::string name, path mount_path, path volume_path, ArchiveOptions options = {});
+		~ArchiveMountPoint();
+
+		/*!
+		 *	\brief Load a batch of entire files
+		 *	\param files paths of the files in the virtual file system
+		 *	\returns the content of each file in the order of 'files'
+		 *
+		 *	The entries are decompressed in parallel by the workers of the mount point,
+		 *	each directly into the buffer returned for it. Cached entries are copied
+		 *	from the cache.
+		 */
+		std::vector<LoadedFile> loadFiles(const std::vector<path>& files) const;
+
+		/*!
+		 *	\brief Decompress a batch of files into the cache
+		 *	\param files paths of the files in the virtual file system
+		 *
+		 *	The entries are decompressed in parallel by the workers of the mount point.
+		 *	The call blocks while the entries being decompressed exceed 'MaxPrefetchInFlight'
+		 *	and returns once all entries are cached. Files which are missing, not cached
+		 *	by the mount point or fail to load are skipped. Without a cache, or if the
+		 *	batch exceeds the cache budget, earlier entries may be evicted again.
+		 */
+		void prefetch(const std::vector<path>& files);
+
+		/*!
+		 *	\brief Start adding or replacing entries of the mounted archive
+		 *
+		 *	Files written through 'createWriter' are appended to the archive. Their
+		 *	cost only depends on the size of the new entries and the central directory.
+		 *	The previous content stays readable until the update is finalized.
+		 */
+		void beginUpdate();
+
+		/*!
+		 *	\brief Complete a newly created archive or an update
 		 *
-		 *	Create a new mount point that maps an archive on a native volume to a specific mount point
+		 *	Waits for the compression of the written entries and writes the central
+		 *	directory. A new archive is opened for reading, the index of an updated
+		 *	archive is changed in place. All writers need to be closed and no readers
+		 *	may be used concurrently. Errors of the compression are reported here,
+		 *	a failed update leaves the archive unchanged. If writers are still open,
+		 *	the update stays pending and can be finalized once they are closed.
+		 *	Has no effect if the archive is not being written.
 		 */
-		ArchiveMountPoint(std::string name, path mount_path, path volume_path);
+		void finalize();
+
+		/*!
+		 *	\brief Remove the data of replaced entries from the archive
+		 *
+		 *	The live entries are copied without recompression into a new file, which
+		 *	replaces the archive. Readers opened before keep reading the previous file.
+		 *	No readers may be used concurrently. On Windows, a mapped file cannot be
+		 *	replaced: all readers of the archive need to be closed, otherwise the
+		 *	compaction fails and the archive is left unchanged. If the compacted
+		 *	archive cannot be opened after it replaced the previous one, the error
+		 *	is reported and the mount point is left without entries.
+		 */
+		void compact();
+
+	public: // Properties
+
+		//! \returns the cache of decompressed entries, nullptr if disabled
+		const Util::EntryCache* cache() const { return _cache.get(); }
 
 	protected:
-		std::shared_ptr<FileReader> createReader(const path& file_name) override;
+		ResolvedEntry resolve(const path& entry) const override;
+		std::shared_ptr<FileReader> createReader(const path& file_name, const ResolvedEntry& entry) override;
 		std::shared_ptr<FileWriter> createWriter(const path& file_name) override;
-		bool exists(const path& entry) const override;
 
 	private:
-		//! Mounted archive 
-		Util::Archive _archive;
+		//! Create a reader decompressing the entry 'idx'
+		std::shared_ptr<FileReader> openEntry(const path& file_name, size_t idx) const;
+
+		//! \returns true if the entry 'idx' is kept in the cache
+		bool isCached(size_t idx) const;
+
+		//! \returns the content of the entry 'idx' from the cache, loaded if necessary
+		Util::EntryCache::Content loadCached(const path& file_name, size_t idx) const;
+
+		/*!
+		 *	\brief Execute tasks on the workers and wait for their completion
+		 *	\param sizes Number of bytes processed by each task
+		 *	\param max_in_flight Maximum number of bytes processed at the same time
+		 *	\param task Function processing a single item, must not throw
+		 *
+		 *	A single task exceeding 'max_in_flight' is executed on its own.
+		 */
+		void runParallel(const std::vector<uint64_t>& sizes, uint64_t max_in_flight, const std::function<void(size_t)>& task) const;
+
+		//! \returns the workers decompressing batches, created on first use
+		Util::ThreadPool& workers() const;
+
+		//! \returns the number of threads used for compression and decompression
+		unsigned int numWorkers() const;
+
+		/*!
+		 *	\brief Access the seek index of a deflated entry
+		 *	\param idx Index of the entry
+		 *	\param data Deflate stream of the entry
+		 *	\returns the seek index, empty for entries smaller than the span
+		 *
+		 *	The first reader of an entry builds its index, concurrent readers
+		 *	of the same entry wait for it instead of decompressing it again.
+		 */
+		std::shared_ptr<const Util::InflateIndex> seekIndex(size_t idx, const std::byte* data) const;
+
+	private:
+		//! Path of the archive on the volume
+		path _volumePath;
+
+		//! Mounted archive, empty while a new archive is written
+		std::unique_ptr<Util::Archive> _archive;
+
+		//! Archive being created
+		std::shared_ptr<Util::ArchiveWriter> _writer;
+
+		//! Configuration of the mount point
+		ArchiveOptions _options;
+
+		//! Decompressed entries
+		std::unique_ptr<Util::EntryCache> _cache;
+
+		//! Lock protecting the seek indices, shared while looking up existing indices
+		mutable std::shared_mutex _seekIndexMutex;
+
+		//! Seek indices of deflated entries, built once by the first reader of an entry
+		mutable std::unordered_map<size_t, std::shared_future<std::shared_ptr<const Util::InflateIndex>>> _seekIndices;
+
+		//! Guards the creation of the workers
+		mutable std::once_flag _workersCreated;
+
+		//! Workers decompressing batches of entries. Destroyed first to finish pending tasks.
+		mutable std::unique_ptr<Util::ThreadPool> _workers;
 	};
 }}
@@ -24,63 +24,167 @@
  */
 #include "memorymountpoint.h"
 
+// C++ standard library
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string_view>
+
  // VCL File System Library
 #include "../readers/memoryfilereader.h"
 #include "../writers/memoryfilewriter.h"
 
 namespace Vcl { namespace FileSystem
 {
-	MemoryMountPoint::MemoryMountPoint(std::string name, path mount_path)
+	namespace
+	{
+		bool isSeparator(char c)
+		{
+			return c == '/' || c == static_cast<char>(std::experimental::filesystem::path::preferred_separator);
+		}
+
+		/*!
+		 *	\brief Bring a relative path into a canonical form
+		 *
+		 *	Components are separated by a single '/'. Empty and '.' components
+		 *	are dropped and '..' removes the preceding component.
+		 */
+		std::string normalizePath(std::string_view str)
+		{
+			std::string key;
+			key.reserve(str.size());
+
+			size_t begin = 0;
+			while (begin < str.size())
+			{
+				if (isSeparator(str[begin]))
+				{
+					++begin;
+					continue;
+				}
+
+				size_t end = begin;
+				while (end < str.size() && !isSeparator(str[end]))
+					++end;
+
+				const auto component = str.substr(begin, end - begin);
+				if (component == "..")
+				{
+					const auto last = key.rfind('/');
+					key.erase(last == std::string::npos ? 0 : last);
+				}
+				else if (component != ".")
+				{
+					if (!key.empty())
+						key += '/';
+					key.append(component.data(), component.size());
+				}
+
+				begin = end;
+			}
+
+			return key;
+		}
+	}
+
+	MemoryMountPoint::MemoryMountPoint(std::string name, path mount_path, size_t page_size, bool huge_pages)
 	: MountPoint(std::move(name), std::move(mount_path))
+	, _arena(std::make_shared<Util::PageArena>(page_size, huge_pages))
 	{
 
 	}
 
-	std::shared_ptr<FileReader> MemoryMountPoint::createReader(const path& entry)
+	ResolvedEntry MemoryMountPoint::resolve(const path& entry) const
 	{
 		auto file = findMemoryFile(entry);
-		if (file)
-		{
-			return std::make_shared<MemoryFileReader>(file->relativePath(), std::move(file));
-		}
-		else
-		{
+		if (!file)
 			return{};
-		}
+
+		ResolvedEntry resolved;
+		resolved.Exists = true;
+		resolved.Status.Size = file->size();
+		resolved.Handle = std::move(file);
+		return resolved;
+	}
+
+	std::shared_ptr<FileReader> MemoryMountPoint::createReader(const path& filename, const ResolvedEntry& entry)
+	{
+		auto file = std::static_pointer_cast<Util::MemoryFile>(entry.Handle);
+		return std::make_shared<MemoryFileReader>(filename, std::move(file));
 	}
 	std::shared_ptr<FileWriter> MemoryMountPoint::createWriter(const path& entry)
 	{
-		auto file = findMemoryFile(entry);
-		if (file)
+		auto key = fileKey(entry);
+		auto& files = shard(key);
+
+		std::shared_ptr<Util::MemoryFile> file;
 		{
-			return std::make_shared<MemoryFileWriter>(file->relativePath(), std::move(file));
+			std::lock_guard<std::shared_mutex> guard{ files.Mutex };
+			auto& slot = files.Files[key];
+			if (!slot)
+				slot = std::make_shared<Util::MemoryFile>(key, _arena);
+
+			file = slot;
 		}
-		else
+
+		return std::make_shared<MemoryFileWriter>(file->relativePath(), std::move(file));
+	}
+
+	bool MemoryMountPoint::remove(const path& file_name)
+	{
+		const auto key = fileKey(file_name);
+		auto& files = shard(key);
+
+		// Release the file outside of the lock, its pages are returned to the arena
+		std::shared_ptr<Util::MemoryFile> file;
 		{
-			path rel_path = relativePath(entry);
-			_files.emplace_back(std::make_shared<Util::MemoryFile>(rel_path));
-			return std::make_shared<MemoryFileWriter>(rel_path, _files.back());
+			std::lock_guard<std::shared_mutex> guard{ files.Mutex };
+			auto file_it = files.Files.find(key);
+			if (file_it == files.Files.end())
+				return false;
+
+			file = std::move(file_it->second);
+			files.Files.erase(file_it);
 		}
+
+		return true;
 	}
-	bool MemoryMountPoint::exists(const path& entry) const
+
+	size_t MemoryMountPoint::nrFiles() const
 	{
-		return static_cast<bool>(findMemoryFile(entry));
+		size_t nr_files = 0;
+		for (const auto& files : _shards)
+		{
+			std::shared_lock<std::shared_mutex> guard{ files.Mutex };
+			nr_files += files.Files.size();
+		}
+
+		return nr_files;
 	}
 
 	std::shared_ptr<Util::MemoryFile> MemoryMountPoint::findMemoryFile(const path& filename) const
 	{
-		// Remove the mount path from the entry
-		path rel_path = relativePath(filename);
-
-		auto file_it = std::find_if(_files.begin(), _files.end(), [&rel_path](const std::shared_ptr<Util::MemoryFile>& file)
-		{
-			return file->relativePath() == rel_path;
-		});
+		const auto key = fileKey(filename);
+		const auto& files = shard(key);
 
-		if (file_it != _files.end())
-			return *file_it;
+		std::shared_lock<std::shared_mutex> guard{ files.Mutex };
+		auto file_it = files.Files.find(key);
+		if (file_it != files.Files.end())
+			return file_it->second;
 		else
 			return{};
 	}
-}}
 
+	MemoryMountPoint::Shard& MemoryMountPoint::shard(const std::string& key) const
+	{
+		// Use the upper bits, the lower ones select the bucket within the shard
+		const size_t hash = std::hash<std::string>{}(key);
+		return _shards[hash >> (std::numeric_limits<size_t>::digits - ShardBits)];
+	}
+
+	std::string MemoryMountPoint::fileKey(const path& filename) const
+	{
+		// Remove the mount path from the entry
+		return normalizePath(relativePath(filename).string());
+	}
+}}
@@ -28,8 +28,11 @@
 #include <vcl/config/global.h>
 
 // C++ standard library
+#include <array>
 #include <memory>
-#include <vector>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
 
 // VCL File System Library
 #include "../util/memoryfile.h"
@@ -37,21 +40,76 @@
 
 namespace Vcl { namespace FileSystem
 {
+	/*!
+	 *	\brief Mount point holding its files in memory
+	 *
+	 *	Files can be created, written, read and removed from multiple threads
+	 *	at once. The file index is split into shards with separate locks, so
+	 *	that accesses to different files rarely wait for each other.
+	 */
 	class MemoryMountPoint : public MountPoint
 	{
+		//! Number of bits of the file hash selecting the part of the index
+		static const int ShardBits = 6;
+
+		//! Number of independently locked parts of the file index
+		static const size_t NrShards = size_t(1) << ShardBits;
+
 	public:
-		MemoryMountPoint(std::string name, path mount_path);
+		/*!
+		 *	\brief Create a new mount point holding files in memory
+		 *	\param mount_path path to mount the in-memory files to
+		 *	\param page_size size of the pages holding the file content. Power of two between 4 KiB and 2 MiB.
+		 *	\param huge_pages back the pages with huge pages where supported
+		 *
+		 *	All the files of the mount point share a single page arena.
+		 */
+		MemoryMountPoint(std::string name, path mount_path, size_t page_size = Util::PageArena::DefaultPageSize, bool huge_pages = false);
+
+		/*!
+		 *	\brief Remove a file from the mount point
+		 *	\param file_name path of the file in the virtual file system
+		 *	\returns true if the file existed
+		 *
+		 *	Readers and writers already open on the file keep its content alive.
+		 */
+		bool remove(const path& file_name);
+
+	public: // Properties
+
+		//! \returns the number of files in the mount point
+		size_t nrFiles() const;
 
 	protected:
-		std::shared_ptr<FileReader> createReader(const path& filename) override;
+		ResolvedEntry resolve(const path& entry) const override;
+		std::shared_ptr<FileReader> createReader(const path& filename, const ResolvedEntry& entry) override;
 		std::shared_ptr<FileWriter> createWriter(const path& filename) override;
-		bool exists(const path& entry) const override;
 
 	private:
 		std::shared_ptr<Util::MemoryFile> findMemoryFile(const path& filename) const;
 
+		//! \returns the key of a file in the index
+		std::string fileKey(const path& filename) const;
+
 	private:
+		//! Part of the file index
+		struct alignas(64) Shard
+		{
+			//! Lock protecting the files of the shard
+			mutable std::shared_mutex Mutex;
+
+			//! Files of the shard, indexed by their normalized path relative to the mount point
+			std::unordered_map<std::string, std::shared_ptr<Util::MemoryFile>> Files;
+		};
+
+		//! \returns the shard holding the file with 'key'
+		Shard& shard(const std::string& key) const;
+
+	private:
+		//! Allocator providing the pages of all the files
+		std::shared_ptr<Util::PageArena> _arena;
+
 		//! Current in-memory files
-		std::vector<std::shared_ptr<Util::MemoryFile>> _files;
+		mutable std::array<Shard, NrShards> _shards;
 	};
 }}
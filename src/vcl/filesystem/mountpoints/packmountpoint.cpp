@@ -0,0 +1,99 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "packmountpoint.h"
+
+// C++ standard library
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// VCL File System Library
+#include "../readers/bufferfilereader.h"
+#include "../readers/packfilereader.h"
+#include "../util/threadpool.h"
+
+namespace Vcl { namespace FileSystem
+{
+	PackMountPoint::PackMountPoint(std::string name, path mount_path, path volume_path, PackOptions options)
+	: MountPoint{ std::move(name), std::move(mount_path) }
+	, _pack{ std::make_shared<const Util::Pack>(std::move(volume_path)) }
+	, _options{ options }
+	{
+		if (_options.CacheBudget > 0)
+			_cache = std::make_unique<Util::EntryCache>(_options.CacheBudget, _options.MaxCachedSize);
+	}
+
+	PackMountPoint::~PackMountPoint() = default;
+
+	ResolvedEntry PackMountPoint::resolve(const path& entry) const
+	{
+		// Remove the mount path from the entry
+		const auto idx = _pack->findPath(relativePath(entry));
+		if (idx == Util::Pack::npos)
+			return{};
+
+		ResolvedEntry resolved;
+		resolved.Exists = true;
+		resolved.Index = idx;
+		resolved.Status.Size = _pack->entry(idx).Size;
+		resolved.Status.IsDirectory = _pack->isDirectory(idx);
+		return resolved;
+	}
+
+	std::shared_ptr<FileReader> PackMountPoint::createReader(const path& file_name, const ResolvedEntry& entry)
+	{
+		const auto idx = static_cast<size_t>(entry.Index);
+		const auto& pack_entry = _pack->entry(idx);
+		if (!_cache || pack_entry.Size == 0 || pack_entry.Size > _cache->maxEntrySize())
+			return std::make_shared<PackFileReader>(file_name, _pack, idx, workers());
+
+		// Keyed by the content, such that files with identical content share the cached data.
+		// Empty files have no blocks, their first block is the one of the next file.
+		auto content = _cache->get(pack_entry.FirstBlock, [this, &file_name, idx]()
+		{
+			PackFileReader reader{ file_name, _pack, idx, workers() };
+			std::vector<std::byte> data(reader.size());
+			data.resize(reader.readAt(0, data.data(), data.size()));
+			return data;
+		});
+		return std::make_shared<BufferFileReader>(file_name, std::move(content));
+	}
+
+	std::shared_ptr<FileWriter> PackMountPoint::createWriter(const path&)
+	{
+		return{};
+	}
+
+	std::shared_ptr<Util::ThreadPool> PackMountPoint::workers() const
+	{
+		std::call_once(_workersCreated, [this]()
+		{
+			const unsigned int nr_threads = _options.NrWorkers > 0 ? _options.NrWorkers : std::max(1u, std::thread::hardware_concurrency());
+			_workers = std::make_shared<Util::ThreadPool>(nr_threads, 2 * nr_threads);
+		});
+
+		return _workers;
+	}
+}}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <memory>
+#include <mutex>
+
+// VCL File System Library
+#include "../util/entrycache.h"
+#include "../util/pack.h"
+#include "../mountpoint.h"
+
+namespace Vcl { namespace FileSystem
+{
+	namespace Util { class ThreadPool; }
+
+	//! Configuration of a pack mount point
+	struct PackOptions
+	{
+		//! Maximum number of bytes of decompressed files kept in memory, 0 disables the cache
+		size_t CacheBudget{ 0 };
+
+		//! Maximum size of a single file to be cached
+		size_t MaxCachedSize{ 1 << 20 };
+
+		//! Number of threads decoding the blocks of large requests, 0 uses one per hardware thread
+		unsigned int NrWorkers{ 0 };
+	};
+
+	class PackMountPoint : public MountPoint
+	{
+	public:
+		/*!
+		 *	\brief Create a new mount point
+		 *	\param mount_path path to mount the pack to
+		 *	\param volume_path path to a pack on an actual volume to be mounted
+		 *	\param options configuration of caching and decoding
+		 *
+		 *	Create a new mount point that maps a pack on a native volume to a specific mount point.
+		 *	The pack is mapped into memory and its index is used in place. Readers decode the
+		 *	blocks covering each request, requests spanning several blocks are decoded in
+		 *	parallel. Files opened through a cache are decoded once and read from memory afterwards.
+		 *	Files with identical content share their entry in the cache.
+		 *	Packs are created with 'Util::PackWriter' and cannot be written through the mount point.
+		 */
+		PackMountPoint(std::string name, path mount_path, path volume_path, PackOptions options = {});
+		~PackMountPoint();
+
+	public: // Properties
+
+		//! \returns the mounted pack
+		const Util::Pack& pack() const { return *_pack; }
+
+		//! \returns the cache of decompressed files, nullptr if disabled
+		const Util::EntryCache* cache() const { return _cache.get(); }
+
+	protected:
+		ResolvedEntry resolve(const path& entry) const override;
+		std::shared_ptr<FileReader> createReader(const path& file_name, const ResolvedEntry& entry) override;
+		std::shared_ptr<FileWriter> createWriter(const path& file_name) override;
+
+	private:
+		//! \returns the workers decoding blocks, created on first use
+		std::shared_ptr<Util::ThreadPool> workers() const;
+
+	private:
+		//! Mounted pack
+		std::shared_ptr<const Util::Pack> _pack;
+
+		//! Configuration of the mount point
+		PackOptions _options;
+
+		//! Decompressed files
+		std::unique_ptr<Util::EntryCache> _cache;
+
+		//! Guards the creation of the workers
+		mutable std::once_flag _workersCreated;
+
+		//! Workers decoding blocks, shared with the readers
+		mutable std::shared_ptr<Util::ThreadPool> _workers;
+	};
+}}
@@ -24,32 +24,225 @@
  */
 #include "volumemountpoint.h"
 
+// C++ standard library
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+
+// C runtime
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(__linux__)
+// Linux
+#include <fcntl.h>
+#endif
+
  // VCL File System Library
+#include "../readers/mappedfilereader.h"
 #include "../readers/volumefilereader.h"
+#include "../util/iouring.h"
+#include "../writers/volumefilewriter.h"
 
 namespace Vcl { namespace FileSystem
 {
-	VolumeMountPoint::VolumeMountPoint(std::string name, path mount_path, path volume_path)
+	VolumeMountPoint::VolumeMountPoint(std::string name, path mount_path, path volume_path, VolumeAccess access)
 	: MountPoint{ std::move(name), std::move(mount_path) }
 	, _volumePath{ volume_path }
+	, _access{ access }
+	{
+	}
+
+	ResolvedEntry VolumeMountPoint::resolve(const path& entry) const
 	{
+		// Query the file on disk with a single system call
+		const auto volume_path = convertToVolumePath(entry);
+#if defined(_WIN32)
+		struct _stat64 info;
+		if (_wstat64(volume_path.c_str(), &info) != 0)
+			return{};
+
+		const bool is_dir = (info.st_mode & _S_IFDIR) != 0;
+#else
+		struct stat info;
+		if (::stat(volume_path.c_str(), &info) != 0)
+			return{};
+
+		const bool is_dir = S_ISDIR(info.st_mode);
+#endif
+
+		ResolvedEntry resolved;
+		resolved.Exists = true;
+		resolved.Status.Size = static_cast<uint64_t>(info.st_size);
+		resolved.Status.IsDirectory = is_dir;
+		return resolved;
 	}
 
-	std::shared_ptr<FileReader> VolumeMountPoint::createReader(const path& file_name)
+	std::shared_ptr<FileReader> VolumeMountPoint::createReader(const path& file_name, const ResolvedEntry& entry)
 	{
-		return std::make_shared<VolumeFileReader>(file_name, convertToVolumePath(file_name));
+		// The size was queried by 'resolve', the opened file is not queried again
+		if (_access == VolumeAccess::Map)
+		{
+			auto file = std::make_shared<const Util::MappedFile>(convertToVolumePath(file_name), entry.Status.Size);
+			return std::make_shared<MappedFileReader>(file_name, std::move(file));
+		}
+		else
+		{
+			return std::make_shared<VolumeFileReader>(file_name, convertToVolumePath(file_name), entry.Status.Size);
+		}
 	}
 
 	std::shared_ptr<FileWriter> VolumeMountPoint::createWriter(const path& file_name)
 	{
-		return{};
+		auto volume_path = convertToVolumePath(file_name);
+
+		// Create the directories leading to the file
+		if (volume_path.has_parent_path())
+			std::experimental::filesystem::create_directories(volume_path.parent_path());
+
+		return std::make_shared<VolumeFileWriter>(file_name, std::move(volume_path));
+	}
+
+	std::vector<LoadedFile> VolumeMountPoint::loadFiles(const std::vector<path>& files, VolumeBatchIO io) const
+	{
+		std::vector<LoadedFile> results(files.size());
+		if (io == VolumeBatchIO::Ring && Util::IoUring::isSupported())
+			loadFilesRing(files, results);
+		else
+			loadFilesBlocking(files, results);
+
+		return results;
 	}
 
-	bool VolumeMountPoint::exists(const path& entry) const
+	void VolumeMountPoint::loadFilesBlocking(const std::vector<path>& files, std::vector<LoadedFile>& results) const
+	{
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			auto entry = resolve(files[i]);
+			if (!entry)
+			{
+				results[i].Error = ENOENT;
+				continue;
+			}
+			if (entry.Status.IsDirectory)
+			{
+				results[i].Error = EISDIR;
+				continue;
+			}
+
+			try
+			{
+				// The size was queried by 'resolve', the opened file is not queried again
+				VolumeFileReader reader{ files[i], convertToVolumePath(files[i]), entry.Status.Size };
+				results[i].Data.resize(reader.size());
+				results[i].Data.resize(reader.readAt(0, results[i].Data.data(), results[i].Data.size()));
+			}
+			catch (const std::runtime_error&)
+			{
+				results[i].Error = EIO;
+			}
+		}
+	}
+
+#if defined(__linux__)
+	void VolumeMountPoint::loadFilesRing(const std::vector<path>& files, std::vector<LoadedFile>& results) const
+	{
+		Util::IoUring ring{ 256 };
+		const size_t group_size = ring.capacity();
+
+		std::vector<std::string> native_paths(group_size);
+		std::vector<struct statx> infos(group_size);
+		std::vector<int> fds(group_size);
+		std::vector<uint64_t> read_bytes(group_size);
+
+		for (size_t begin = 0; begin < files.size(); begin += group_size)
+		{
+			const size_t end = std::min(files.size(), begin + group_size);
+			auto result = [&results, begin](uint64_t idx) -> LoadedFile& { return results[begin + idx]; };
+
+			// Query the type and size of all the files
+			for (size_t i = begin; i < end; i++)
+			{
+				native_paths[i - begin] = convertToVolumePath(files[i]).native();
+				ring.prepareStatx(native_paths[i - begin].c_str(), &infos[i - begin], i - begin);
+			}
+			ring.submitAndWait([&](uint64_t idx, int res)
+			{
+				if (res < 0)
+					result(idx).Error = -res;
+				else if (S_ISDIR(infos[idx].stx_mode))
+					result(idx).Error = EISDIR;
+			});
+
+			// Open the existing files
+			for (size_t i = begin; i < end; i++)
+			{
+				fds[i - begin] = -1;
+				if (results[i].Error == 0)
+					ring.prepareOpenAt(native_paths[i - begin].c_str(), O_RDONLY | O_CLOEXEC, i - begin);
+			}
+			ring.submitAndWait([&](uint64_t idx, int res)
+			{
+				if (res < 0)
+				{
+					result(idx).Error = -res;
+					return;
+				}
+
+				fds[idx] = res;
+				read_bytes[idx] = 0;
+				result(idx).Data.resize(infos[idx].stx_size);
+			});
+
+			// Read the content, repeating short reads until all the files are complete
+			for (;;)
+			{
+				for (size_t idx = 0; idx < end - begin; idx++)
+				{
+					auto& data = result(idx).Data;
+					if (fds[idx] < 0 || result(idx).Error != 0 || read_bytes[idx] >= data.size())
+						continue;
+
+					const auto size = static_cast<uint32_t>(std::min<uint64_t>(data.size() - read_bytes[idx], 1u << 30));
+					ring.prepareRead(fds[idx], data.data() + read_bytes[idx], size, read_bytes[idx], idx);
+				}
+				if (ring.pending() == 0)
+					break;
+
+				ring.submitAndWait([&](uint64_t idx, int res)
+				{
+					if (res < 0)
+						result(idx).Error = -res;
+					else if (res == 0)
+						result(idx).Data.resize(read_bytes[idx]);
+					else
+						read_bytes[idx] += static_cast<uint64_t>(res);
+				});
+			}
+
+			// Release the file descriptors
+			for (size_t idx = 0; idx < end - begin; idx++)
+			{
+				if (fds[idx] >= 0)
+					ring.prepareClose(fds[idx], idx);
+			}
+			ring.submitAndWait([](uint64_t, int) {});
+
+			// Failed files do not return partial content
+			for (size_t i = begin; i < end; i++)
+			{
+				if (results[i].Error != 0)
+					results[i].Data.clear();
+			}
+		}
+	}
+#else
+	void VolumeMountPoint::loadFilesRing(const std::vector<path>& files, std::vector<LoadedFile>& results) const
 	{
-		// Check if the file exists on disk
-		return std::experimental::filesystem::exists(convertToVolumePath(entry));
+		loadFilesBlocking(files, results);
 	}
+#endif
 
 	VolumeMountPoint::path VolumeMountPoint::convertToVolumePath(const path& virtual_path) const
 	{
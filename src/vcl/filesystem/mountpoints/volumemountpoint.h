@@ -27,11 +27,35 @@
 // VCL configuration
 #include <vcl/config/global.h>
 
+// C++ standard library
+#include <cstddef>
+#include <vector>
+
 // VCL File System Library
 #include "../mountpoint.h"
 
 namespace Vcl { namespace FileSystem
 {
+	//! Method used to access the files of a volume
+	enum class VolumeAccess
+	{
+		//! Read the files through the operating system
+		Read,
+
+		//! Map the files into memory and read from the mapping
+		Map
+	};
+
+	//! Method used to load a batch of files
+	enum class VolumeBatchIO
+	{
+		//! Open and read the files one after the other
+		Blocking,
+
+		//! Submit the operations of all files together using io_uring, if supported
+		Ring
+	};
+
 	class VolumeMountPoint : public MountPoint
 	{
 	public:
@@ -39,24 +63,44 @@ namespace Vcl { namespace FileSystem
 		 *	\brief Create a new mount point
 		 *	\param mount_path path to mount the volume directory to
 		 *	\param volume_path path to a directory on an actual volume to be mounted
+		 *	\param access method used to read the files of the volume
 		 *
-		 *	Create a new mount point that maps a directory from a native volume to a specific mount point
+		 *	Create a new mount point that maps a directory from a native volume to a specific mount point.
+		 *	Mapped files can be accessed through 'FileReader::view' without copying them.
 		 */
-		VolumeMountPoint(std::string name, path mount_path, path volume_path);
+		VolumeMountPoint(std::string name, path mount_path, path volume_path, VolumeAccess access = VolumeAccess::Read);
+
+		/*!
+		 *	\brief Load a batch of entire files
+		 *	\param files paths of the files in the virtual file system
+		 *	\param io method used to access the volume
+		 *	\returns the content of each file in the order of 'files'
+		 *
+		 *	With 'VolumeBatchIO::Ring' the files are processed in groups. For each
+		 *	group, the status queries, opens, reads and closes are each submitted with
+		 *	a single system call. Systems without io_uring load the files one by one.
+		 */
+		std::vector<LoadedFile> loadFiles(const std::vector<path>& files, VolumeBatchIO io = VolumeBatchIO::Ring) const;
 
 	protected:		
-		std::shared_ptr<FileReader> createReader(const path& file_name) override;
+		ResolvedEntry resolve(const path& entry) const override;
+		std::shared_ptr<FileReader> createReader(const path& file_name, const ResolvedEntry& entry) override;
 		std::shared_ptr<FileWriter> createWriter(const path& file_name) override;
-		bool exists(const path& entry) const override;
 
 	private:
 		path convertToVolumePath(const path& virtual_path) const;
 
-	private:
-		//! Name of the mount point
-		std::string _name;
+		//! Load a batch of files one after the other
+		void loadFilesBlocking(const std::vector<path>& files, std::vector<LoadedFile>& results) const;
+
+		//! Load a batch of files using io_uring
+		void loadFilesRing(const std::vector<path>& files, std::vector<LoadedFile>& results) const;
 
+	private:
 		//! Native path to the volume loaded
 		path _volumePath;
+
+		//! Method used to access the files
+		VolumeAccess _access;
 	};
 }}
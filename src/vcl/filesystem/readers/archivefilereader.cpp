@@ -24,27 +24,38 @@
  */
 #include "archivefilereader.h"
 
+// C++ standard library
+#include <algorithm>
+#include <mutex>
+
  // ZipLib
 #include <ZipLib/ZipFile.h>
 
+ // VCL File System Library
+#include "../util/archive.h"
+
 namespace Vcl { namespace FileSystem
 {
-	ArchiveFileReader::ArchiveFileReader(path virtual_path, std::shared_ptr<ZipArchiveEntry> entry)
+	ArchiveFileReader::ArchiveFileReader(path virtual_path, std::shared_ptr<ZipArchiveEntry> entry, std::shared_ptr<Util::ArchiveStream> stream)
 	: FileReader(virtual_path)
+	, _archive(std::move(stream))
 	, _entry(std::move(entry))
 	{
+		std::lock_guard<std::mutex> guard{ _archive->Mutex };
 		_stream = _entry->GetDecompressionStream();
 		_size = _entry->GetSize();
 	}
 
 	void ArchiveFileReader::seek(const uint64_t pos)
 	{
+		std::lock_guard<std::mutex> guard{ _archive->Mutex };
 		_stream->seekg(pos);
 		_curr_pos = pos;
 	}
 
 	uint64_t ArchiveFileReader::read(void* buf, const uint64_t buffer_size)
 	{
+		std::lock_guard<std::mutex> guard{ _archive->Mutex };
 		auto left_to_read = size() - pos();
 		auto read_bytes = std::min<uint64_t>(buffer_size, left_to_read);
 		_stream->read(static_cast<char*>(buf), read_bytes);
@@ -53,9 +64,55 @@ namespace Vcl { namespace FileSystem
 		return read_bytes;
 	}
 
+	uint64_t ArchiveFileReader::readAt(uint64_t offset, void* buf, const uint64_t buffer_size) const
+	{
+		if (offset >= size())
+			return 0;
+
+		// The decompression stream is shared with the sequential interface,
+		// thus, restore its position after reading
+		std::lock_guard<std::mutex> guard{ _archive->Mutex };
+		auto read_bytes = std::min<uint64_t>(buffer_size, size() - offset);
+		_stream->clear();
+		_stream->seekg(offset);
+		_stream->read(static_cast<char*>(buf), read_bytes);
+		_stream->clear();
+		_stream->seekg(_curr_pos);
+
+		return read_bytes;
+	}
+
+	uint64_t ArchiveFileReader::readv(std::vector<ReadRequest>& requests) const
+	{
+		// Process the requests in the order of the file, such that the
+		// decompression stream only needs to move forward
+		const auto order = sortByOffset(requests);
+
+		std::lock_guard<std::mutex> guard{ _archive->Mutex };
+		uint64_t total_bytes = 0;
+		for (auto* request : order)
+		{
+			request->ReadBytes = 0;
+			if (request->Offset >= size())
+				continue;
+
+			auto read_bytes = std::min<uint64_t>(request->Size, size() - request->Offset);
+			_stream->clear();
+			_stream->seekg(request->Offset);
+			_stream->read(static_cast<char*>(request->Buffer), read_bytes);
+
+			request->ReadBytes = read_bytes;
+			total_bytes += read_bytes;
+		}
+		_stream->clear();
+		_stream->seekg(_curr_pos);
+
+		return total_bytes;
+	}
+
 	bool ArchiveFileReader::eof() const
 	{
-		return _stream->eof();
+		return _curr_pos >= _size;
 	}
 
 	uint64_t ArchiveFileReader::size() const
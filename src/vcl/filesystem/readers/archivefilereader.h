@@ -27,6 +27,10 @@
 // VCL configuration
 #include <vcl/config/global.h>
 
+// C++ standard library
+#include <istream>
+#include <memory>
+
 // VCL File System Library
 #include "../filereader.h"
 
@@ -35,19 +39,26 @@ class ZipArchiveEntry;
 
 namespace Vcl { namespace FileSystem
 {
+	namespace Util { struct ArchiveStream; }
+
 	class ArchiveFileReader : public FileReader
 	{
 	public:
-		ArchiveFileReader(path virtual_path, std::shared_ptr<ZipArchiveEntry> entry);
+		ArchiveFileReader(path virtual_path, std::shared_ptr<ZipArchiveEntry> entry, std::shared_ptr<Util::ArchiveStream> stream);
 
 		void     seek(const uint64_t pos) override;
 		uint64_t read(void* buf, const uint64_t size) override;
+		uint64_t readAt(uint64_t offset, void* buf, const uint64_t size) const override;
+		uint64_t readv(std::vector<ReadRequest>& requests) const override;
 
 		bool     eof() const override;
 		uint64_t size() const override;
 		uint64_t pos() const override;
 
 	private:
+		//! Archive of the entry with the lock protecting the stream shared by all its entries. Outlives the entry.
+		std::shared_ptr<Util::ArchiveStream> _archive;
+
 		//! Entry in the archive
 		std::shared_ptr<ZipArchiveEntry> _entry;
 
@@ -0,0 +1,86 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "bufferfilereader.h"
+
+// C++ standard library
+#include <algorithm>
+#include <cstring>
+
+namespace Vcl { namespace FileSystem
+{
+	BufferFileReader::BufferFileReader(path virtual_path, std::shared_ptr<const std::vector<std::byte>> buffer)
+	: FileReader(virtual_path)
+	, _buffer(std::move(buffer))
+	{
+	}
+
+	void BufferFileReader::seek(const uint64_t pos)
+	{
+		_curr_pos = pos;
+	}
+
+	uint64_t BufferFileReader::read(void* buf, const uint64_t buffer_size)
+	{
+		auto read_bytes = readAt(_curr_pos, buf, buffer_size);
+
+		_curr_pos += read_bytes;
+		return read_bytes;
+	}
+
+	uint64_t BufferFileReader::readAt(uint64_t offset, void* buf, const uint64_t buffer_size) const
+	{
+		if (offset >= size())
+			return 0;
+
+		auto read_bytes = std::min<uint64_t>(buffer_size, size() - offset);
+		memcpy(buf, _buffer->data() + offset, read_bytes);
+
+		return read_bytes;
+	}
+
+	FileView BufferFileReader::view(uint64_t offset, uint64_t size) const
+	{
+		if (offset >= this->size())
+			return{};
+
+		size = std::min(size, this->size() - offset);
+		return{ _buffer->data() + offset, size, _buffer };
+	}
+
+	bool BufferFileReader::eof() const
+	{
+		return _curr_pos >= size();
+	}
+
+	uint64_t BufferFileReader::size() const
+	{
+		return _buffer->size();
+	}
+
+	uint64_t BufferFileReader::pos() const
+	{
+		return _curr_pos;
+	}
+}}
@@ -0,0 +1,118 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "inflatefilereader.h"
+
+// C++ standard library
+#include <algorithm>
+
+namespace Vcl { namespace FileSystem
+{
+	InflateFileReader::InflateFileReader
+	(
+		path virtual_path,
+		std::shared_ptr<const Util::MappedFile> archive,
+		uint64_t data_offset,
+		uint64_t compressed_size,
+		uint64_t size,
+		std::shared_ptr<const Util::InflateIndex> index
+	)
+	: FileReader(virtual_path)
+	, _archive(std::move(archive))
+	, _data(_archive->data() + data_offset)
+	, _compressedSize(compressed_size)
+	, _size(size)
+	, _index(std::move(index))
+	, _inflater(_data, _compressedSize)
+	{
+	}
+
+	void InflateFileReader::seek(const uint64_t pos)
+	{
+		_curr_pos = pos;
+	}
+
+	uint64_t InflateFileReader::read(void* buf, const uint64_t buffer_size)
+	{
+		if (_curr_pos >= _size)
+			return 0;
+
+		// Reading the entire file does not need the streaming state
+		if (_curr_pos == 0 && buffer_size >= _size)
+		{
+			_curr_pos = Util::inflateAll(_data, _compressedSize, buf, _size);
+			return _curr_pos;
+		}
+
+		position(_inflater, _curr_pos);
+		auto read_bytes = _inflater.read(buf, std::min(buffer_size, _size - _curr_pos));
+
+		_curr_pos += read_bytes;
+		return read_bytes;
+	}
+
+	uint64_t InflateFileReader::readAt(uint64_t offset, void* buf, const uint64_t buffer_size) const
+	{
+		if (offset >= _size)
+			return 0;
+
+		if (offset == 0 && buffer_size >= _size)
+			return Util::inflateAll(_data, _compressedSize, buf, _size);
+
+		// Independent decompression state, allowing concurrent calls
+		Util::Inflater inflater{ _data, _compressedSize };
+		position(inflater, offset);
+
+		return inflater.read(buf, std::min(buffer_size, _size - offset));
+	}
+
+	void InflateFileReader::position(Util::Inflater& inflater, uint64_t offset) const
+	{
+		if (inflater.position() == offset)
+			return;
+
+		// Restart from the closest checkpoint unless the target is ahead of the current state
+		const Util::InflateIndex::Checkpoint* checkpoint = _index ? &_index->find(offset) : nullptr;
+		const uint64_t restart = checkpoint ? checkpoint->Out : 0;
+		if (offset < inflater.position() || restart > inflater.position())
+			inflater.reset(checkpoint);
+
+		inflater.skip(offset - inflater.position());
+	}
+
+	bool InflateFileReader::eof() const
+	{
+		return _curr_pos >= _size;
+	}
+
+	uint64_t InflateFileReader::size() const
+	{
+		return _size;
+	}
+
+	uint64_t InflateFileReader::pos() const
+	{
+		return _curr_pos;
+	}
+}}
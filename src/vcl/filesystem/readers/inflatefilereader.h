@@ -0,0 +1,104 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <memory>
+
+// VCL File System Library
+#include "../util/inflate.h"
+#include "../util/mappedfile.h"
+#include "../filereader.h"
+
+namespace Vcl { namespace FileSystem
+{
+	/*!
+	 *	\brief Reader decompressing a deflated entry of a memory mapped archive
+	 *
+	 *	Data is inflated straight into the buffers passed to the reader.
+	 *	Requests covering the entire file are decoded in a single pass.
+	 *	Seeking backwards restarts decompressing from the closest checkpoint
+	 *	of the seek index, or from the start of the entry without an index.
+	 */
+	class InflateFileReader : public FileReader
+	{
+	public:
+		/*!
+		 *	\brief Create a new reader
+		 *	\param virtual_path Path of the file within the virtual file system
+		 *	\param archive Memory mapped archive
+		 *	\param data_offset Position of the compressed data in the archive
+		 *	\param compressed_size Size of the compressed data
+		 *	\param size Size of the uncompressed data
+		 *	\param index Checkpoints of the compressed data, may be empty
+		 */
+		InflateFileReader
+		(
+			path virtual_path,
+			std::shared_ptr<const Util::MappedFile> archive,
+			uint64_t data_offset,
+			uint64_t compressed_size,
+			uint64_t size,
+			std::shared_ptr<const Util::InflateIndex> index
+		);
+
+		void     seek(const uint64_t pos) override;
+		uint64_t read(void* buf, const uint64_t size) override;
+		uint64_t readAt(uint64_t offset, void* buf, const uint64_t size) const override;
+
+		bool     eof() const override;
+		uint64_t size() const override;
+		uint64_t pos() const override;
+
+	private:
+		//! Move the decompression of 'inflater' to 'offset'
+		void position(Util::Inflater& inflater, uint64_t offset) const;
+
+	private:
+		//! Memory mapped archive
+		std::shared_ptr<const Util::MappedFile> _archive;
+
+		//! Start of the compressed data
+		const std::byte* _data;
+
+		//! Size of the compressed data
+		uint64_t _compressedSize;
+
+		//! Size of the entire file
+		uint64_t _size;
+
+		//! Checkpoints of the compressed data
+		std::shared_ptr<const Util::InflateIndex> _index;
+
+		//! Decompression state of sequential reads
+		Util::Inflater _inflater;
+
+		//! Current position in the file
+		uint64_t _curr_pos{ 0 };
+	};
+}}
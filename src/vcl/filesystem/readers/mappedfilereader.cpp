@@ -0,0 +1,109 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "mappedfilereader.h"
+
+// C++ standard library
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Vcl { namespace FileSystem
+{
+	namespace
+	{
+		//! \returns 'offset' after checking that the range lies within the mapping
+		uint64_t checkRange(const Util::MappedFile& file, uint64_t offset, uint64_t size)
+		{
+			if (offset > file.size() || size > file.size() - offset)
+				throw std::invalid_argument("Range exceeds the mapped file.");
+
+			return offset;
+		}
+	}
+
+	MappedFileReader::MappedFileReader(path virtual_path, std::shared_ptr<const Util::MappedFile> file)
+	: FileReader(virtual_path)
+	, _file(std::move(file))
+	, _data(_file->data())
+	, _size(_file->size())
+	{
+	}
+
+	MappedFileReader::MappedFileReader(path virtual_path, std::shared_ptr<const Util::MappedFile> file, uint64_t offset, uint64_t size)
+	: FileReader(virtual_path)
+	, _file(std::move(file))
+	, _data(_file->data() + checkRange(*_file, offset, size))
+	, _size(size)
+	{
+	}
+
+	void MappedFileReader::seek(const uint64_t pos)
+	{
+		_curr_pos = pos;
+	}
+
+	uint64_t MappedFileReader::read(void* buf, const uint64_t buffer_size)
+	{
+		auto read_bytes = readAt(_curr_pos, buf, buffer_size);
+
+		_curr_pos += read_bytes;
+		return read_bytes;
+	}
+
+	uint64_t MappedFileReader::readAt(uint64_t offset, void* buf, const uint64_t buffer_size) const
+	{
+		if (offset >= size())
+			return 0;
+
+		auto read_bytes = std::min<uint64_t>(buffer_size, size() - offset);
+		memcpy(buf, _data + offset, read_bytes);
+
+		return read_bytes;
+	}
+
+	FileView MappedFileReader::view(uint64_t offset, uint64_t size) const
+	{
+		if (offset >= this->size())
+			return{};
+
+		size = std::min(size, this->size() - offset);
+		return{ _data + offset, size, _file };
+	}
+
+	bool MappedFileReader::eof() const
+	{
+		return _curr_pos >= size();
+	}
+
+	uint64_t MappedFileReader::size() const
+	{
+		return _size;
+	}
+
+	uint64_t MappedFileReader::pos() const
+	{
+		return _curr_pos;
+	}
+}}
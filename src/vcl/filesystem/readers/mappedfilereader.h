@@ -0,0 +1,83 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <memory>
+
+// VCL File System Library
+#include "../util/mappedfile.h"
+#include "../filereader.h"
+
+namespace Vcl { namespace FileSystem
+{
+	/*!
+	 *	\brief Reader accessing a memory mapped file on a volume
+	 *
+	 *	Views returned by this reader point directly into the mapping.
+	 *	The reader either covers the entire mapped file or a range of it,
+	 *	such as an uncompressed entry of a mapped archive.
+	 */
+	class MappedFileReader : public FileReader
+	{
+	public:
+		MappedFileReader(path virtual_path, std::shared_ptr<const Util::MappedFile> file);
+
+		/*!
+		 *	\brief Create a reader for a part of a mapped file
+		 *	\param virtual_path Path of the file in the virtual file system
+		 *	\param file Mapped file containing the data
+		 *	\param offset Position of the first byte of the data in the mapped file
+		 *	\param size Number of bytes of the data
+		 */
+		MappedFileReader(path virtual_path, std::shared_ptr<const Util::MappedFile> file, uint64_t offset, uint64_t size);
+
+		void     seek(const uint64_t pos) override;
+		uint64_t read(void* buf, const uint64_t size) override;
+		uint64_t readAt(uint64_t offset, void* buf, const uint64_t size) const override;
+
+		FileView view(uint64_t offset, uint64_t size) const override;
+
+		bool     eof() const override;
+		uint64_t size() const override;
+		uint64_t pos() const override;
+
+	private:
+		//! Mapped file resource
+		std::shared_ptr<const Util::MappedFile> _file;
+
+		//! Start of the data in the mapped file
+		const std::byte* _data;
+
+		//! Size of the data
+		uint64_t _size;
+
+		//! Current position in the file buffer
+		uint64_t _curr_pos{ 0 };
+	};
+}}
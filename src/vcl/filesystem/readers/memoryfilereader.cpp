@@ -28,8 +28,9 @@ namespace Vcl { namespace FileSystem
 {
 	MemoryFileReader::MemoryFileReader(path virtual_path, std::shared_ptr<Util::MemoryFile> file)
 	: FileReader(virtual_path)
-	, _file(std::move(file))
+	, _file(file->snapshot())
 	{
+		_size = _file->size();
 	}
 
 	void MemoryFileReader::seek(const uint64_t pos)
@@ -45,6 +46,11 @@ namespace Vcl { namespace FileSystem
 		return bytes_read;
 	}
 
+	uint64_t MemoryFileReader::readAt(uint64_t offset, void* buf, const uint64_t buffer_size) const
+	{
+		return _file->read(offset, buf, buffer_size);
+	}
+
 	bool MemoryFileReader::eof() const
 	{
 		return _curr_pos >= _size;
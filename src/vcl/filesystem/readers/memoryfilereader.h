@@ -36,6 +36,12 @@
 
 namespace Vcl { namespace FileSystem
 {
+	/*!
+	 *	\brief Reader of an in-memory file
+	 *
+	 *	The reader works on a snapshot of the file taken when it is created.
+	 *	Later writes to the file are not visible to the reader.
+	 */
 	class MemoryFileReader : public FileReader
 	{
 	public:
@@ -43,14 +49,15 @@ namespace Vcl { namespace FileSystem
 
 		void     seek(const uint64_t pos) override;
 		uint64_t read(void* buf, const uint64_t size) override;
+		uint64_t readAt(uint64_t offset, void* buf, const uint64_t size) const override;
 
 		bool     eof() const override;
 		uint64_t size() const override;
 		uint64_t pos() const override;
 
 	private:
-		//! Memory file resource
-		std::shared_ptr<Util::MemoryFile> _file;
+		//! Content of the memory file at the time the reader was created
+		std::shared_ptr<const Util::MemoryFileSnapshot> _file;
 
 		//! Size of the entire file
 		uint64_t _size{ 0 };
@@ -0,0 +1,156 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "packfilereader.h"
+
+// C++ standard library
+#include <algorithm>
+#include <cstring>
+
+// VCL File System Library
+#include "../util/threadpool.h"
+
+namespace Vcl { namespace FileSystem
+{
+	PackFileReader::PackFileReader(path virtual_path, std::shared_ptr<const Util::Pack> pack, size_t idx, std::shared_ptr<Util::ThreadPool> workers)
+	: FileReader(virtual_path)
+	, _pack(std::move(pack))
+	, _idx(idx)
+	, _size(_pack->entry(idx).Size)
+	, _workers(std::move(workers))
+	{
+	}
+
+	void PackFileReader::seek(const uint64_t pos)
+	{
+		_curr_pos = pos;
+	}
+
+	uint64_t PackFileReader::read(void* buf, const uint64_t buffer_size)
+	{
+		if (_curr_pos >= _size || buffer_size == 0)
+			return 0;
+
+		const uint64_t block_size = _pack->blockSize();
+		const uint64_t size = std::min(buffer_size, _size - _curr_pos);
+
+		// Requests beyond the current block are decoded like random accesses
+		const uint64_t block = _curr_pos / block_size;
+		if (_curr_pos + size > (block + 1) * block_size)
+		{
+			const auto read_bytes = readAt(_curr_pos, buf, size);
+			_curr_pos += read_bytes;
+			return read_bytes;
+		}
+
+		if (_blockIdx != block)
+		{
+			_block.resize(block_size);
+			_pack->readBlock(_idx, block, _block.data());
+			_blockIdx = block;
+		}
+
+		memcpy(buf, _block.data() + (_curr_pos - block * block_size), size);
+		_curr_pos += size;
+		return size;
+	}
+
+	uint64_t PackFileReader::readAt(uint64_t offset, void* buf, const uint64_t buffer_size) const
+	{
+		if (offset >= _size || buffer_size == 0)
+			return 0;
+
+		const uint64_t block_size = _pack->blockSize();
+		const uint64_t size = std::min(buffer_size, _size - offset);
+		const uint64_t first = offset / block_size;
+		const uint64_t nr_blocks = (offset + size - 1) / block_size - first + 1;
+
+		auto decode = [this, first, offset, buf, size](size_t i)
+		{
+			readBlock(first + i, offset, buf, size);
+		};
+		if (_workers && nr_blocks > 1)
+			_workers->parallelFor(static_cast<size_t>(nr_blocks), decode);
+		else
+		{
+			for (size_t i = 0; i < nr_blocks; i++)
+				decode(i);
+		}
+
+		return size;
+	}
+
+	void PackFileReader::readBlock(uint64_t block, uint64_t offset, void* buf, uint64_t size) const
+	{
+		const uint64_t block_size = _pack->blockSize();
+		const uint64_t block_begin = block * block_size;
+		const uint64_t block_end = std::min(block_begin + block_size, _size);
+		const uint64_t begin = std::max(offset, block_begin);
+		const uint64_t end = std::min(offset + size, block_end);
+		auto target = static_cast<std::byte*>(buf) + (begin - offset);
+
+		if (begin == block_begin && end == block_end)
+		{
+			_pack->readBlock(_idx, block, target);
+			return;
+		}
+
+		std::vector<std::byte> data(block_size);
+		_pack->readBlock(_idx, block, data.data());
+		memcpy(target, data.data() + (begin - block_begin), end - begin);
+	}
+
+	FileView PackFileReader::view(uint64_t offset, uint64_t size) const
+	{
+		if (offset >= _size)
+			return{};
+
+		// Ranges within an uncompressed block are not copied
+		const uint64_t block_size = _pack->blockSize();
+		size = std::min(size, _size - offset);
+		const uint64_t block = offset / block_size;
+		if (size > 0 && (offset + size - 1) / block_size == block)
+		{
+			if (auto data = _pack->storedBlock(_idx, block))
+				return{ data + (offset - block * block_size), size, _pack };
+		}
+
+		return FileReader::view(offset, size);
+	}
+
+	bool PackFileReader::eof() const
+	{
+		return _curr_pos >= _size;
+	}
+
+	uint64_t PackFileReader::size() const
+	{
+		return _size;
+	}
+
+	uint64_t PackFileReader::pos() const
+	{
+		return _curr_pos;
+	}
+}}
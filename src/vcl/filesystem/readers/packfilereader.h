@@ -0,0 +1,100 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// VCL File System Library
+#include "../util/pack.h"
+#include "../filereader.h"
+
+namespace Vcl { namespace FileSystem
+{
+	namespace Util { class ThreadPool; }
+
+	/*!
+	 *	\brief Reader decoding a file stored in a pack
+	 *
+	 *	Only the blocks covering a request are decoded, blocks which are covered
+	 *	entirely are decoded straight into the buffer. Requests spanning several
+	 *	blocks are decoded in parallel by the workers. Sequential reads keep the
+	 *	last decoded block. Views of blocks stored without compression point
+	 *	into the mapped pack.
+	 */
+	class PackFileReader : public FileReader
+	{
+	public:
+		/*!
+		 *	\brief Create a new reader
+		 *	\param virtual_path Path of the file within the virtual file system
+		 *	\param pack Memory mapped pack
+		 *	\param idx Index of the file in the pack
+		 *	\param workers Threads decoding the blocks of large requests, may be empty
+		 */
+		PackFileReader(path virtual_path, std::shared_ptr<const Util::Pack> pack, size_t idx, std::shared_ptr<Util::ThreadPool> workers);
+
+		void     seek(const uint64_t pos) override;
+		uint64_t read(void* buf, const uint64_t size) override;
+		uint64_t readAt(uint64_t offset, void* buf, const uint64_t size) const override;
+
+		FileView view(uint64_t offset, uint64_t size) const override;
+
+		bool     eof() const override;
+		uint64_t size() const override;
+		uint64_t pos() const override;
+
+	private:
+		//! Copy the part of the block 'block' overlapping [offset, offset + size) into 'buf'
+		void readBlock(uint64_t block, uint64_t offset, void* buf, uint64_t size) const;
+
+	private:
+		//! Memory mapped pack
+		std::shared_ptr<const Util::Pack> _pack;
+
+		//! Index of the file in the pack
+		size_t _idx;
+
+		//! Size of the file
+		uint64_t _size;
+
+		//! Threads decoding blocks in parallel
+		std::shared_ptr<Util::ThreadPool> _workers;
+
+		//! Index of the block held by '_block', -1 if empty
+		uint64_t _blockIdx{ ~uint64_t(0) };
+
+		//! Last block decoded by sequential reads
+		std::vector<std::byte> _block;
+
+		//! Current position in the file
+		uint64_t _curr_pos{ 0 };
+	};
+}}
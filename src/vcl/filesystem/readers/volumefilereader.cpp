@@ -24,43 +24,255 @@
  */
 #include "volumefilereader.h"
 
+// C++ standard library
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(_WIN32)
 // Windows
+#ifndef NOMINMAX
+#	define NOMINMAX
+#endif
 #include <windows.h>
+#else
+// POSIX
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
 namespace Vcl { namespace FileSystem
 {
-	uint64_t GetFileSize(std::wstring const &path)
-	{ 
-		WIN32_FIND_DATAW data;
-		HANDLE h = FindFirstFileW(path.c_str(), &data);
-		if (h == INVALID_HANDLE_VALUE)
-			return -1;
+#if defined(_WIN32)
+	namespace
+	{
+		HANDLE openFile(const std::experimental::filesystem::path& file)
+		{
+			HANDLE h = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (h == INVALID_HANDLE_VALUE)
+				throw std::runtime_error(file.string() + " could not be opened.");
+
+			return h;
+		}
+	}
+
+	VolumeFileReader::VolumeFileReader(path virtual_path, path volume_path)
+	: FileReader(virtual_path)
+	, _volumePath(std::move(volume_path))
+	{
+		HANDLE h = openFile(_volumePath);
 
-		FindClose(h);
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(h, &size))
+		{
+			CloseHandle(h);
+			throw std::runtime_error(_volumePath.string() + " could not be queried.");
+		}
 
-		return data.nFileSizeLow | (__int64) data.nFileSizeHigh << 32;
+		_handle = h;
+		_size = static_cast<uint64_t>(size.QuadPart);
+	}
+
+	VolumeFileReader::VolumeFileReader(path virtual_path, path volume_path, uint64_t size)
+	: FileReader(virtual_path)
+	, _volumePath(std::move(volume_path))
+	, _size(size)
+	{
+		_handle = openFile(_volumePath);
+	}
+
+	VolumeFileReader::~VolumeFileReader()
+	{
+		if (_handle)
+			CloseHandle(_handle);
+	}
+
+	uint64_t VolumeFileReader::readAt(uint64_t offset, void* buf, const uint64_t buffer_size) const
+	{
+		if (offset >= _size)
+			return 0;
+
+		const auto size = std::min<uint64_t>(buffer_size, _size - offset);
+
+		uint64_t read_bytes = 0;
+		while (read_bytes < size)
+		{
+			// Read with an explicit offset in order to not depend on the file pointer
+			OVERLAPPED ov = {};
+			ov.Offset = static_cast<DWORD>(offset + read_bytes);
+			ov.OffsetHigh = static_cast<DWORD>((offset + read_bytes) >> 32);
+
+			const DWORD chunk = static_cast<DWORD>(std::min<uint64_t>(size - read_bytes, 1u << 30));
+			DWORD chunk_read = 0;
+			if (!ReadFile(_handle, static_cast<char*>(buf) + read_bytes, chunk, &chunk_read, &ov) || chunk_read == 0)
+				break;
+
+			read_bytes += chunk_read;
+		}
+
+		return read_bytes;
+	}
+
+	uint64_t VolumeFileReader::readv(std::vector<ReadRequest>& requests) const
+	{
+		// Scattered reads require unbuffered I/O on Windows
+		return FileReader::readv(requests);
+	}
+#else
+	namespace
+	{
+		int openFile(const std::experimental::filesystem::path& file)
+		{
+			int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				throw std::runtime_error(file.string() + " could not be opened.");
+
+			return fd;
+		}
 	}
 
 	VolumeFileReader::VolumeFileReader(path virtual_path, path volume_path)
 	: FileReader(virtual_path)
 	, _volumePath(std::move(volume_path))
 	{
-		_size = GetFileSize(_volumePath.wstring());
+		_fd = openFile(_volumePath);
+
+		// Query the size from the open descriptor instead of the path
+		struct stat info;
+		if (::fstat(_fd, &info) != 0)
+		{
+			::close(_fd);
+			throw std::runtime_error(_volumePath.string() + " could not be queried.");
+		}
+
+		_size = static_cast<uint64_t>(info.st_size);
+	}
+
+	VolumeFileReader::VolumeFileReader(path virtual_path, path volume_path, uint64_t size)
+	: FileReader(virtual_path)
+	, _volumePath(std::move(volume_path))
+	, _size(size)
+	{
+		_fd = openFile(_volumePath);
+	}
+
+	VolumeFileReader::~VolumeFileReader()
+	{
+		if (_fd >= 0)
+			::close(_fd);
+	}
+
+	uint64_t VolumeFileReader::readAt(uint64_t offset, void* buf, const uint64_t buffer_size) const
+	{
+		if (offset >= _size)
+			return 0;
+
+		const auto size = std::min<uint64_t>(buffer_size, _size - offset);
+
+		uint64_t read_bytes = 0;
+		while (read_bytes < size)
+		{
+			const auto res = ::pread(_fd, static_cast<char*>(buf) + read_bytes, size - read_bytes, static_cast<off_t>(offset + read_bytes));
+			if (res < 0 && errno == EINTR)
+				continue;
+			if (res <= 0)
+				break;
+
+			read_bytes += static_cast<uint64_t>(res);
+		}
+
+		return read_bytes;
+	}
+
+	uint64_t VolumeFileReader::readv(std::vector<ReadRequest>& requests) const
+	{
+		// Gaps between two ranges up to this size are read into a scratch
+		// buffer instead of issuing a separate system call
+		const uint64_t max_gap = 4096;
+		std::vector<char> gap_buffer;
+
+		// Combine the requests in the order of the file
+		const auto order = sortByOffset(requests);
+		std::vector<iovec> io_vectors;
+		std::vector<ReadRequest*> batch;
+
+		uint64_t total_bytes = 0;
+		size_t next = 0;
+		while (next < order.size())
+		{
+			io_vectors.clear();
+			batch.clear();
+
+			uint64_t batch_begin = 0;
+			uint64_t batch_end = 0;
+			for (; next < order.size() && io_vectors.size() + 2 <= IOV_MAX; next++)
+			{
+				auto* request = order[next];
+				request->ReadBytes = 0;
+
+				// Skip requests outside of the file
+				if (request->Offset >= _size || request->Size == 0)
+					continue;
+				const auto size = std::min<uint64_t>(request->Size, _size - request->Offset);
+
+				if (batch.empty())
+				{
+					batch_begin = request->Offset;
+				}
+				else
+				{
+					// Overlapping ranges and large gaps start a new batch
+					if (request->Offset < batch_end || request->Offset - batch_end > max_gap)
+						break;
+
+					if (request->Offset > batch_end)
+					{
+						gap_buffer.resize(max_gap);
+						io_vectors.push_back({ gap_buffer.data(), static_cast<size_t>(request->Offset - batch_end) });
+					}
+				}
+
+				io_vectors.push_back({ request->Buffer, static_cast<size_t>(size) });
+				batch.push_back(request);
+				batch_end = request->Offset + size;
+			}
+
+			if (batch.empty())
+				continue;
+
+			auto res = ::preadv(_fd, io_vectors.data(), static_cast<int>(io_vectors.size()), static_cast<off_t>(batch_begin));
+			const uint64_t batch_bytes = res > 0 ? static_cast<uint64_t>(res) : 0;
+
+			// Distribute the read bytes and complete short reads individually
+			for (auto* request : batch)
+			{
+				const auto size = std::min<uint64_t>(request->Size, _size - request->Offset);
+				const auto rel_offset = request->Offset - batch_begin;
+				if (batch_bytes > rel_offset)
+					request->ReadBytes = std::min(size, batch_bytes - rel_offset);
+
+				if (request->ReadBytes < size)
+					request->ReadBytes += readAt(request->Offset + request->ReadBytes, static_cast<char*>(request->Buffer) + request->ReadBytes, size - request->ReadBytes);
+
+				total_bytes += request->ReadBytes;
+			}
+		}
 
-		_file.open(_volumePath.c_str(), std::ios::binary);
+		return total_bytes;
 	}
+#endif
 
 	void VolumeFileReader::seek(const uint64_t pos)
 	{
-		_file.seekg(pos);
 		_curr_pos = pos;
 	}
 
 	uint64_t VolumeFileReader::read(void* buf, const uint64_t buffer_size)
 	{
-		auto left_to_read = size() - pos();
-		auto read_bytes = std::min<uint64_t>(buffer_size, left_to_read);
-		_file.read(static_cast<char*>(buf), read_bytes);
+		auto read_bytes = readAt(_curr_pos, buf, buffer_size);
 
 		_curr_pos += read_bytes;
 		return read_bytes;
@@ -68,7 +280,7 @@ namespace Vcl { namespace FileSystem
 
 	bool VolumeFileReader::eof() const
 	{
-		return _file.eof();
+		return _curr_pos >= _size;
 	}
 
 	uint64_t VolumeFileReader::size() const
@@ -27,9 +27,6 @@
 // VCL configuration
 #include <vcl/config/global.h>
 
-// C++ standard library
-#include <fstream>
-
 // VCL File System Library
 #include "../filereader.h"
 
@@ -40,8 +37,24 @@ namespace Vcl { namespace FileSystem
 	public:
 		VolumeFileReader(path virtual_path, path volume_path);
 
+		/*!
+		 *	\brief Open a file with a known size
+		 *	\param virtual_path path of the file in the virtual file system
+		 *	\param volume_path path of the file on the actual volume
+		 *	\param size current size of the file, as queried by 'stat'
+		 *
+		 *	Saves querying the size of the open file again.
+		 */
+		VolumeFileReader(path virtual_path, path volume_path, uint64_t size);
+		VolumeFileReader(const VolumeFileReader&) = delete;
+		~VolumeFileReader();
+
+		VolumeFileReader& operator=(const VolumeFileReader&) = delete;
+
 		void     seek(const uint64_t pos) override;
 		uint64_t read(void* buf, const uint64_t size) override;
+		uint64_t readAt(uint64_t offset, void* buf, const uint64_t size) const override;
+		uint64_t readv(std::vector<ReadRequest>& requests) const override;
 
 		bool     eof() const override;
 		uint64_t size() const override;
@@ -51,8 +64,13 @@ namespace Vcl { namespace FileSystem
 		//! Path of the file on the actual volume
 		path _volumePath;
 
-		//! File pointer
-		std::ifstream _file;
+#if defined(_WIN32)
+		//! Native file handle
+		void* _handle{ nullptr };
+#else
+		//! Native file descriptor
+		int _fd{ -1 };
+#endif
 
 		//! Size of the entire file
 		uint64_t _size{ 0 };
@@ -24,50 +24,359 @@
  */
 #include "archive.h"
 
+// C++ standard library
+#include <algorithm>
+#include <stdexcept>
+
+// VCL File System Library
+#include "hash.h"
+
 // ZipLib
 #include <ZipLib/ZipFile.h>
 
 namespace Vcl { namespace FileSystem { namespace Util
 {
+	namespace
+	{
+		//! Marker of empty slots in the hash table
+		const uint32_t EmptySlot = ~uint32_t(0);
+
+		// Signatures of the zip records
+		const uint32_t LocalFileHeaderSignature = 0x04034b50;
+		const uint32_t CentralDirectorySignature = 0x02014b50;
+		const uint32_t EndOfCentralDirectorySignature = 0x06054b50;
+		const uint32_t Zip64EndOfCentralDirectorySignature = 0x06064b50;
+		const uint32_t Zip64EndOfCentralDirectoryLocatorSignature = 0x07064b50;
+
+		// Sizes of the fixed parts of the zip records
+		const size_t LocalFileHeaderSize = 30;
+		const size_t CentralDirectoryHeaderSize = 46;
+		const size_t EndOfCentralDirectorySize = 22;
+		const size_t Zip64EndOfCentralDirectorySize = 56;
+		const size_t Zip64EndOfCentralDirectoryLocatorSize = 20;
+
+		//! Read a little-endian integer
+		template<typename T>
+		T readLE(const uint8_t* data)
+		{
+			T value = 0;
+			for (size_t i = 0; i < sizeof(T); i++)
+				value |= static_cast<T>(data[i]) << (8 * i);
+			return value;
+		}
+	}
+
+	ArchivePathIterator::path ArchivePathIterator::operator*() const
+	{
+		const auto name = _archive->entryName(_idx);
+		return std::string{ name.data(), name.size() };
+	}
+
 	Archive::Archive(path zip_file)
 	: _file{ zip_file }
 	{
-		_archive = ZipFile::Open(_file.string());
-
-		if (_archive)
-			enumerateFiles();
+		enumerateFiles();
 	}
 
 	bool Archive::entryExists(const path& entry) const 
 	{
-		std::string str;
-		if (entry.has_root_directory())
-			str = entry.string().substr(1);
-		else
-			str = entry.string();
+		return findPath(entry) != npos;
+	}
+
+	size_t Archive::findPath(const path& entry) const
+	{
+		const auto name = toEntryName(entry);
+		if (name.empty())
+			return npos;
+
+		return findEntry(name);
+	}
+
+	std::string Archive::toEntryName(const path& entry)
+	{
+		// Entry names are relative to the root of the archive and use '/' as separator
+		auto name = entry.string();
+		if (path::preferred_separator != '/')
+			std::replace(name.begin(), name.end(), static_cast<char>(path::preferred_separator), '/');
+
+		const auto start = name.find_first_not_of('/');
+		if (start == std::string::npos)
+			return{};
+
+		return name.substr(start);
+	}
+
+	size_t Archive::findEntry(std::string_view name) const
+	{
+		if (_table.empty())
+			return npos;
+
+		const uint32_t hash = hashName(name);
+		const size_t mask = _table.size() - 1;
+		for (size_t slot = hash & mask; _table[slot] != EmptySlot; slot = (slot + 1) & mask)
+		{
+			const auto& entry = _entries[_table[slot]];
+			if (entry.Hash == hash && entryName(_table[slot]) == name)
+				return _table[slot];
+		}
 
-		return _entries.find(str) != _entries.end();
+		return npos;
 	}
 
-	std::shared_ptr<ZipArchiveEntry> Archive::entry(const path& entry) const
+	std::string_view Archive::entryName(size_t idx) const
 	{
-		std::string str;
-		if (entry.has_root_directory())
-			str = entry.string().substr(1);
-		else
-			str = entry.string();
+		const auto& entry = _entries[idx];
+		return std::string_view{ reinterpret_cast<const char*>(_mapping->data()) + entry.NameOffset, entry.NameLength };
+	}
 
-		return _entries.find(str)->second;
+	bool Archive::isDirectory(size_t idx) const
+	{
+		const auto name = entryName(idx);
+		return !name.empty() && name.back() == '/';
+	}
+
+	std::shared_ptr<ArchiveStream> Archive::stream() const
+	{
+		std::lock_guard<std::mutex> guard{ _streamMutex };
+		if (!_stream)
+		{
+			auto stream = std::make_shared<ArchiveStream>();
+			stream->Zip = ZipFile::Open(_file.string());
+			_stream = std::move(stream);
+		}
+
+		return _stream;
+	}
+
+	std::shared_ptr<ZipArchiveEntry> Archive::openEntry(size_t idx, const ArchiveStream& stream) const
+	{
+		if (!stream.Zip)
+			return{};
+
+		const auto name = entryName(idx);
+		return stream.Zip->GetEntry(std::string{ name.data(), name.size() });
+	}
+
+	std::vector<size_t> Archive::update(const std::vector<ArchiveEntry>& entries)
+	{
+		auto mapping = std::make_shared<const MappedFile>(_file);
+		if (_entries.size() + entries.size() >= EmptySlot)
+			throw std::runtime_error(_file.string() + " has too many entries.");
+
+		// Existing entries are searched with their names in the previous mapping
+		std::vector<size_t> indices;
+		indices.reserve(entries.size());
+		for (const auto& entry : entries)
+		{
+			if (entry.NameOffset + entry.NameLength > mapping->size())
+				throw std::runtime_error(_file.string() + " has a corrupt central directory.");
+
+			indices.push_back(findEntry({ reinterpret_cast<const char*>(mapping->data()) + entry.NameOffset, entry.NameLength }));
+		}
+
+		// Allocate before changing the index, such that a failed update leaves it unchanged
+		std::vector<size_t> replaced;
+		replaced.reserve(entries.size());
+		_entries.reserve(_entries.size() + entries.size());
+		resizeTable(_entries.size() + entries.size());
+
+		_mapping = std::move(mapping);
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			if (indices[i] == npos)
+			{
+				addEntry(entries[i]);
+				continue;
+			}
+
+			auto& entry = _entries[indices[i]];
+			const uint32_t hash = entry.Hash;
+			entry = entries[i];
+			entry.Hash = hash;
+			replaced.push_back(indices[i]);
+		}
+
+		// The zip implementation reads the new directory when it is used next,
+		// open readers keep the previous one
+		std::lock_guard<std::mutex> guard{ _streamMutex };
+		_stream.reset();
+
+		return replaced;
+	}
+
+	uint64_t Archive::dataOffset(size_t idx) const
+	{
+		const auto& entry = _entries[idx];
+		const auto& file = _mapping;
+
+		// The local header repeats the name, followed by an extra field which may differ from the central directory
+		const auto header = localHeader(idx, *file);
+		const uint64_t offset = entry.HeaderOffset + LocalFileHeaderSize + readLE<uint16_t>(header + 26) + readLE<uint16_t>(header + 28);
+		if (offset + entry.CompressedSize > file->size())
+			throw std::runtime_error(_file.string() + " has a truncated entry.");
+
+		return offset;
+	}
+
+	bool Archive::isEncrypted(size_t idx) const
+	{
+		const auto header = localHeader(idx, *_mapping);
+		return (readLE<uint16_t>(header + 6) & 0x1) != 0;
+	}
+
+	const uint8_t* Archive::localHeader(size_t idx, const MappedFile& file) const
+	{
+		const auto& entry = _entries[idx];
+		if (entry.HeaderOffset + LocalFileHeaderSize > file.size())
+			throw std::runtime_error(_file.string() + " has a corrupt local file header.");
+
+		const auto header = reinterpret_cast<const uint8_t*>(file.data()) + entry.HeaderOffset;
+		if (readLE<uint32_t>(header) != LocalFileHeaderSignature)
+			throw std::runtime_error(_file.string() + " has a corrupt local file header.");
+
+		return header;
+	}
+
+	size_t Archive::indexMemory() const
+	{
+		return sizeof(Archive) + _entries.capacity() * sizeof(ArchiveEntry) + _table.capacity() * sizeof(uint32_t);
 	}
 
 	void Archive::enumerateFiles()
 	{
-		// Adds all the entries to an internal list
-		auto nr_entries = _archive->GetEntriesCount();
-		for (decltype(nr_entries) e = 0; e < nr_entries; ++e)
+		_mapping = std::make_shared<const MappedFile>(_file);
+		const auto data = reinterpret_cast<const uint8_t*>(_mapping->data());
+		const uint64_t file_size = _mapping->size();
+		if (file_size < EndOfCentralDirectorySize)
+			throw std::runtime_error(_file.string() + " is not a zip archive.");
+
+		// The end of central directory record is followed by a comment of at most 64 KiB
+		const uint64_t search_begin = file_size - std::min<uint64_t>(file_size, EndOfCentralDirectorySize + 0xffff);
+		uint64_t eocd_offset = file_size - EndOfCentralDirectorySize + 1;
+		while (eocd_offset > search_begin && readLE<uint32_t>(data + eocd_offset - 1) != EndOfCentralDirectorySignature)
+			eocd_offset--;
+		if (eocd_offset == search_begin)
+			throw std::runtime_error(_file.string() + " is not a zip archive.");
+		const uint8_t* record = data + --eocd_offset;
+
+		uint64_t nr_entries = readLE<uint16_t>(record + 10);
+		uint64_t dir_size = readLE<uint32_t>(record + 12);
+		uint64_t dir_offset = readLE<uint32_t>(record + 16);
+
+		// Large archives store the location of the central directory in a separate record
+		if ((nr_entries == 0xffff || dir_size == 0xffffffff || dir_offset == 0xffffffff) && eocd_offset >= Zip64EndOfCentralDirectoryLocatorSize)
+		{
+			const uint8_t* locator = data + eocd_offset - Zip64EndOfCentralDirectoryLocatorSize;
+			if (readLE<uint32_t>(locator) == Zip64EndOfCentralDirectoryLocatorSignature)
+			{
+				const uint64_t record_offset = readLE<uint64_t>(locator + 8);
+				if (record_offset > file_size - Zip64EndOfCentralDirectorySize)
+					throw std::runtime_error(_file.string() + " has a corrupt zip64 directory.");
+
+				const uint8_t* zip64_record = data + record_offset;
+				if (readLE<uint32_t>(zip64_record) != Zip64EndOfCentralDirectorySignature)
+					throw std::runtime_error(_file.string() + " has a corrupt zip64 directory.");
+
+				nr_entries = readLE<uint64_t>(zip64_record + 32);
+				dir_size = readLE<uint64_t>(zip64_record + 40);
+				dir_offset = readLE<uint64_t>(zip64_record + 48);
+			}
+		}
+		if (dir_offset > file_size || dir_size > file_size - dir_offset || nr_entries >= EmptySlot)
+			throw std::runtime_error(_file.string() + " has a corrupt central directory.");
+
+		resizeTable(nr_entries);
+		_entries.reserve(nr_entries);
+
+		// Parse the directory in place
+		const uint8_t* header = data + dir_offset;
+		const uint8_t* const end = header + dir_size;
+		for (uint64_t e = 0; e < nr_entries; e++)
+		{
+			if (end - header < static_cast<ptrdiff_t>(CentralDirectoryHeaderSize) || readLE<uint32_t>(header) != CentralDirectorySignature)
+				throw std::runtime_error(_file.string() + " has a corrupt central directory.");
+
+			const uint16_t name_length = readLE<uint16_t>(header + 28);
+			const uint16_t extra_length = readLE<uint16_t>(header + 30);
+			const uint16_t comment_length = readLE<uint16_t>(header + 32);
+			const size_t record_size = CentralDirectoryHeaderSize + name_length + extra_length + comment_length;
+			if (end - header < static_cast<ptrdiff_t>(record_size))
+				throw std::runtime_error(_file.string() + " has a corrupt central directory.");
+
+			ArchiveEntry entry;
+			entry.Method = readLE<uint16_t>(header + 10);
+			entry.Crc32 = readLE<uint32_t>(header + 16);
+			entry.CompressedSize = readLE<uint32_t>(header + 20);
+			entry.Size = readLE<uint32_t>(header + 24);
+			entry.HeaderOffset = readLE<uint32_t>(header + 42);
+			entry.NameOffset = static_cast<uint64_t>(header + CentralDirectoryHeaderSize - data);
+			entry.NameLength = name_length;
+
+			// Values not fitting into 32 bits are stored in the zip64 extra field
+			const uint8_t* extra = header + CentralDirectoryHeaderSize + name_length;
+			const uint8_t* const extra_end = extra + extra_length;
+			while (extra_end - extra >= 4)
+			{
+				const uint16_t id = readLE<uint16_t>(extra);
+				const uint16_t size = readLE<uint16_t>(extra + 2);
+				const uint8_t* field = extra + 4;
+				const uint8_t* const field_end = field + std::min<ptrdiff_t>(size, extra_end - field);
+				if (id == 0x0001)
+				{
+					for (uint64_t* value : { &entry.Size, &entry.CompressedSize, &entry.HeaderOffset })
+					{
+						if (*value == 0xffffffff && field_end - field >= 8)
+						{
+							*value = readLE<uint64_t>(field);
+							field += 8;
+						}
+					}
+				}
+
+				extra = field_end;
+			}
+
+			addEntry(entry);
+
+			header += record_size;
+		}
+	}
+
+	void Archive::addEntry(ArchiveEntry entry)
+	{
+		const std::string_view name{ reinterpret_cast<const char*>(_mapping->data()) + entry.NameOffset, entry.NameLength };
+		entry.Hash = hashName(name);
+
+		// Keep the first of multiple entries with the same name
+		const size_t mask = _table.size() - 1;
+		size_t slot = entry.Hash & mask;
+		for (; _table[slot] != EmptySlot; slot = (slot + 1) & mask)
+		{
+			if (_entries[_table[slot]].Hash == entry.Hash && entryName(_table[slot]) == name)
+				return;
+		}
+
+		_table[slot] = static_cast<uint32_t>(_entries.size());
+		_entries.push_back(entry);
+	}
+
+	void Archive::resizeTable(size_t nr_entries)
+	{
+		// Keep the load factor at most one half
+		size_t table_size = 16;
+		while (table_size < 2 * nr_entries)
+			table_size *= 2;
+		if (table_size <= _table.size())
+			return;
+
+		_table.assign(table_size, EmptySlot);
+		const size_t mask = table_size - 1;
+		for (size_t idx = 0; idx < _entries.size(); idx++)
 		{
-			auto entry = _archive->GetEntry(static_cast<int>(e));
-			_entries.emplace(entry->GetFullName(), entry);
+			size_t slot = _entries[idx].Hash & mask;
+			while (_table[slot] != EmptySlot)
+				slot = (slot + 1) & mask;
+			_table[slot] = static_cast<uint32_t>(idx);
 		}
 	}
 }}}
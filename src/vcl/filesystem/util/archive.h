@@ -28,45 +28,115 @@
 #include <vcl/config/global.h>
 
 // C++ Standard Library
-#include <filesystem>
+#include <cstdint>
+#include <experimental/filesystem>
+#include <iterator>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// VCL File System Library
+#include "mappedfile.h"
 
 // Forward declaration
 class ZipArchive;
 class ZipArchiveEntry;
 
-namespace std
+namespace Vcl { namespace FileSystem { namespace Util
 {
-	template<>
-	struct hash<std::experimental::filesystem::path>
+	class Archive;
+
+	//! Properties of a single file in an archive, as listed in the central directory
+	struct ArchiveEntry
 	{
-		size_t operator()(const std::experimental::filesystem::path& x) const
-		{
-			return std::experimental::filesystem::hash_value(x);
-		}
+		//! Compression method of entries stored without compression
+		static const uint16_t Stored = 0;
+
+		//! Compression method of deflated entries
+		static const uint16_t Deflated = 8;
+
+		//! Offset of the local file header in the archive
+		uint64_t HeaderOffset{ 0 };
+
+		//! Size of the stored data
+		uint64_t CompressedSize{ 0 };
+
+		//! Size of the uncompressed data
+		uint64_t Size{ 0 };
+
+		//! Offset of the name in the archive file
+		uint64_t NameOffset{ 0 };
+
+		//! Hash of the name
+		uint32_t Hash{ 0 };
+
+		//! Checksum of the uncompressed data
+		uint32_t Crc32{ 0 };
+
+		//! Length of the name
+		uint16_t NameLength{ 0 };
+
+		//! Compression method (0: stored, 8: deflated)
+		uint16_t Method{ 0 };
 	};
-}
 
-namespace Vcl { namespace FileSystem { namespace Util
-{
-	class ArchivePathIterator : public std::unordered_map<std::experimental::filesystem::path, std::shared_ptr<ZipArchiveEntry>>::const_iterator
+	//! Archive opened by the zip implementation, shared with the readers of its entries
+	struct ArchiveStream
+	{
+		//! Archive of the zip implementation, nullptr if it could not be opened
+		std::shared_ptr<ZipArchive> Zip;
+
+		//! Lock serializing the accesses to the stream of the archive, which is shared by all entries
+		std::mutex Mutex;
+	};
+
+	//! Iterator over the paths of all entries of an archive
+	class ArchivePathIterator
 	{
 		using path = std::experimental::filesystem::path;
-		using ArchiveIterator = std::unordered_map<path, std::shared_ptr<ZipArchiveEntry>>::const_iterator;
 
 	public:
-		ArchivePathIterator(ArchiveIterator s) : ArchiveIterator{ s } {};
-		path* const operator->() { return (path* const)&(ArchiveIterator::operator->()->first); }
-		const path operator*() { return ArchiveIterator::operator*().first; }
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = path;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const path*;
+		using reference = path;
+
+		ArchivePathIterator(const Archive* archive, size_t idx) : _archive{ archive }, _idx{ idx } {}
+
+		path operator*() const;
+		ArchivePathIterator& operator++() { ++_idx; return *this; }
+
+		bool operator==(const ArchivePathIterator& rhs) const { return _idx == rhs._idx; }
+		bool operator!=(const ArchivePathIterator& rhs) const { return _idx != rhs._idx; }
+
+	private:
+		const Archive* _archive;
+		size_t _idx;
 	};
 
+	/*!
+	 *	\brief Index of a zip archive
+	 *
+	 *	The archive is mapped into memory when it is opened and the central
+	 *	directory is parsed in place into a compact index: an array of entries
+	 *	and an open addressing hash table of entry indices. Names are not copied,
+	 *	the entries refer to the names in the mapped central directory. Entry
+	 *	objects of the zip implementation are only created once the content of
+	 *	an entry is read through 'openEntry'. Entries appended to the file are
+	 *	added to the index by 'update' without parsing the directory again.
+	 */
 	class Archive
 	{
 	protected:
 		using path = std::experimental::filesystem::path;
 
 	public:
+		//! Index returned by 'findEntry' if an entry does not exist
+		static const size_t npos = ~size_t(0);
+
 		Archive(path zip_file);
 
 		/*!
@@ -77,26 +147,128 @@ namespace Vcl { namespace FileSystem { namespace Util
 		bool entryExists(const path& entry) const;
 
 		/*!
-		 *	\brief Access a specific entry of the archive
-		 *	\param entry_path Path to the entry relative to the archive
-		 *	\returns the pointer to the entry
+		 *	\brief Search an entry of the archive
+		 *	\param name Name of the entry relative to the archive, using '/' as separator
+		 *	\returns the index of the entry, 'npos' if the entry does not exist
+		 */
+		size_t findEntry(std::string_view name) const;
+
+		/*!
+		 *	\brief Search an entry of the archive
+		 *	\param entry Path of the entry relative to the archive
+		 *	\returns the index of the entry, 'npos' if the entry does not exist
+		 */
+		size_t findPath(const path& entry) const;
+
+		/*!
+		 *	\brief Convert a path relative to the archive to an entry name
+		 *	\param entry Path of the entry relative to the archive
+		 *	\returns the name using '/' as separator without leading separators, empty for the root
 		 */
-		std::shared_ptr<ZipArchiveEntry> entry(const path& entry_path) const;
+		static std::string toEntryName(const path& entry);
 
-		ArchivePathIterator beginPaths() const { return{ _entries.cbegin() }; }
-		ArchivePathIterator endPaths() const { return{ _entries.cend() }; }
+		//! \returns the properties of the entry 'idx'
+		const ArchiveEntry& entry(size_t idx) const { return _entries[idx]; }
+
+		//! \returns the name of the entry 'idx'
+		std::string_view entryName(size_t idx) const;
+
+		//! \returns true if the entry 'idx' is a directory
+		bool isDirectory(size_t idx) const;
+
+		/*!
+		 *	\brief Access the zip implementation reading the entries
+		 *	\returns the archive of the zip implementation and the lock of its stream
+		 *
+		 *	The zip implementation reads the archive when it is accessed first.
+		 *	Readers of entries keep the returned object, it stays valid after
+		 *	the archive is updated or destroyed.
+		 */
+		std::shared_ptr<ArchiveStream> stream() const;
+
+		/*!
+		 *	\brief Access the decompression interface of an entry
+		 *	\param idx Index of the entry
+		 *	\param stream Zip implementation returned by 'stream'
+		 *	\returns the entry object of the zip implementation
+		 */
+		std::shared_ptr<ZipArchiveEntry> openEntry(size_t idx, const ArchiveStream& stream) const;
+
+		/*!
+		 *	\brief Update the index after entries were added to the archive file
+		 *	\param entries Entries referring to their names in the new central directory
+		 *	\returns the indices of the entries which were replaced
+		 *
+		 *	The archive file is mapped again. Entries with the name of an existing
+		 *	entry replace it and keep its index, other entries are added to the end.
+		 *	Entries which are not replaced need to keep their names at the same
+		 *	location in the file. Readers opened before keep the previous mapping.
+		 *	Must not be called concurrently with other methods.
+		 */
+		std::vector<size_t> update(const std::vector<ArchiveEntry>& entries);
+
+		//! \returns the archive file mapped into memory
+		std::shared_ptr<const MappedFile> mapping() const { return _mapping; }
+
+		/*!
+		 *	\brief Locate the data of an entry in the archive file
+		 *	\param idx Index of the entry
+		 *	\returns the offset of the first byte of the stored data
+		 */
+		uint64_t dataOffset(size_t idx) const;
+
+		/*!
+		 *	\brief Check if the data of an entry is encrypted
+		 *	\param idx Index of the entry
+		 *
+		 *	Encrypted entries cannot be accessed through the mapping.
+		 */
+		bool isEncrypted(size_t idx) const;
+
+		ArchivePathIterator beginPaths() const { return{ this, 0 }; }
+		ArchivePathIterator endPaths() const { return{ this, _entries.size() }; }
+
+	public: // Properties
+
+		//! \returns the path of the archive on the volume
+		const path& filePath() const { return _file; }
+
+		//! \returns the number of entries in the archive
+		size_t nrEntries() const { return _entries.size(); }
+
+		//! \returns the number of bytes used by the index
+		size_t indexMemory() const;
 
 	private:
+		//! Read the central directory of the archive
 		void enumerateFiles();
 
+		//! \returns the local file header of the entry 'idx' in the mapping
+		const uint8_t* localHeader(size_t idx, const MappedFile& file) const;
+
+		//! Add an entry with a name in the mapped archive to the index
+		void addEntry(ArchiveEntry entry);
+
+		//! Resize the hash table for a load factor of at most one half with 'nr_entries'
+		void resizeTable(size_t nr_entries);
+
 	private:
 		//! Path to the on volume archive
 		path _file;
 
-		//! Implementation of archive
-		std::shared_ptr<ZipArchive> _archive;
+		//! Entries in the order of the central directory
+		std::vector<ArchiveEntry> _entries;
+
+		//! Open addressing hash table of indices into '_entries'
+		std::vector<uint32_t> _table;
+
+		//! Implementation of archive, opened on first use
+		mutable std::shared_ptr<ArchiveStream> _stream;
+
+		//! Guard opening the archive implementation
+		mutable std::mutex _streamMutex;
 
-		//! Cache of files in the archive
-		std::unordered_map<path, std::shared_ptr<ZipArchiveEntry>> _entries;
+		//! Archive file mapped into memory, holding the names of the entries
+		std::shared_ptr<const MappedFile> _mapping;
 	};
 }}}
@@ -0,0 +1,696 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "archivewriter.h"
+
+// C++ standard library
+#include <algorithm>
+#include <ctime>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+// VCL File System Library
+#include "threadpool.h"
+
+// zlib
+#include <ZipLib/extlibs/zlib/zlib.h>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	namespace
+	{
+		// Signatures of the zip records
+		const uint32_t LocalFileHeaderSignature = 0x04034b50;
+		const uint32_t CentralDirectorySignature = 0x02014b50;
+		const uint32_t EndOfCentralDirectorySignature = 0x06054b50;
+		const uint32_t Zip64EndOfCentralDirectorySignature = 0x06064b50;
+		const uint32_t Zip64EndOfCentralDirectoryLocatorSignature = 0x07064b50;
+		const uint32_t DataDescriptorSignature = 0x08074b50;
+
+		// Sizes of the fixed parts of the zip records
+		const size_t CentralDirectoryHeaderSize = 46;
+
+		//! Marker of values stored in the zip64 extra field
+		const uint32_t Zip64Marker = 0xffffffff;
+
+		//! Version 2.0, required for deflate
+		const uint16_t VersionDeflate = 20;
+
+		//! Version 4.5, required for zip64
+		const uint16_t VersionZip64 = 45;
+
+		//! General purpose flag indicating UTF-8 encoded names
+		const uint16_t FlagUtf8 = 0x0800;
+
+		//! Size of the deflate window
+		const size_t WindowSize = 32768;
+
+		//! Append a little-endian integer
+		template<typename T>
+		void appendLE(std::vector<uint8_t>& buffer, T value)
+		{
+			for (size_t i = 0; i < sizeof(T); i++)
+				buffer.push_back(static_cast<uint8_t>((value >> (8 * i)) & 0xff));
+		}
+
+		//! Read a little-endian integer
+		template<typename T>
+		T readLE(const uint8_t* data)
+		{
+			T value = 0;
+			for (size_t i = 0; i < sizeof(T); i++)
+				value |= static_cast<T>(data[i]) << (8 * i);
+			return value;
+		}
+
+		//! Overwrite a little-endian integer
+		template<typename T>
+		void storeLE(uint8_t* data, T value)
+		{
+			for (size_t i = 0; i < sizeof(T); i++)
+				data[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xff);
+		}
+
+		//! \returns the size of a directory record including its variable fields
+		size_t directoryRecordSize(const uint8_t* record)
+		{
+			return CentralDirectoryHeaderSize + readLE<uint16_t>(record + 28) + readLE<uint16_t>(record + 30) + readLE<uint16_t>(record + 32);
+		}
+
+		//! Change the location of the local header stored in a directory record
+		void patchHeaderOffset(uint8_t* record, uint64_t offset)
+		{
+			if (readLE<uint32_t>(record + 42) != Zip64Marker)
+			{
+				if (offset >= Zip64Marker)
+					throw std::runtime_error("Entry cannot be moved beyond 4 GiB.");
+
+				storeLE<uint32_t>(record + 42, static_cast<uint32_t>(offset));
+				return;
+			}
+
+			// The offset follows the sizes in the zip64 extra field if they are stored there as well
+			uint8_t* extra = record + CentralDirectoryHeaderSize + readLE<uint16_t>(record + 28);
+			uint8_t* const extra_end = extra + readLE<uint16_t>(record + 30);
+			while (extra_end - extra >= 4)
+			{
+				const uint16_t id = readLE<uint16_t>(extra);
+				uint8_t* field = extra + 4;
+				uint8_t* const field_end = field + std::min<ptrdiff_t>(readLE<uint16_t>(extra + 2), extra_end - field);
+				if (id == 0x0001)
+				{
+					if (readLE<uint32_t>(record + 24) == Zip64Marker)
+						field += 8;
+					if (readLE<uint32_t>(record + 20) == Zip64Marker)
+						field += 8;
+					if (field_end - field < 8)
+						break;
+
+					storeLE<uint64_t>(field, offset);
+					return;
+				}
+
+				extra = field_end;
+			}
+
+			throw std::runtime_error("Entry has a corrupt zip64 extra field.");
+		}
+
+		//! \returns the current local time in MS-DOS format (date in the upper 16 bits)
+		uint32_t currentDosTime()
+		{
+			const std::time_t now = std::time(nullptr);
+			std::tm local{};
+#if defined(_WIN32)
+			localtime_s(&local, &now);
+#else
+			localtime_r(&now, &local);
+#endif
+			const uint32_t date = (std::max(local.tm_year - 80, 0) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday;
+			const uint32_t time = (local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2);
+			return (date << 16) | time;
+		}
+
+		//! Deflate a block of an entry, continuing the stream of the preceding blocks
+		std::vector<uint8_t> deflateBlock(const std::vector<uint8_t>& input, const std::vector<uint8_t>& dictionary, int level, bool final)
+		{
+			z_stream stream{};
+			if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				throw std::runtime_error("Unable to initialize zlib.");
+			if (!dictionary.empty())
+				deflateSetDictionary(&stream, dictionary.data(), static_cast<uInt>(dictionary.size()));
+
+			// The bound does not include the marker of the sync flush
+			std::vector<uint8_t> output(deflateBound(&stream, static_cast<uLong>(input.size())) + 16);
+			stream.next_in = const_cast<Bytef*>(input.data());
+			stream.avail_in = static_cast<uInt>(input.size());
+			stream.next_out = output.data();
+			stream.avail_out = static_cast<uInt>(output.size());
+
+			// Non-final blocks end on a byte boundary, allowing to append the next block
+			const int flush = final ? Z_FINISH : Z_SYNC_FLUSH;
+			for (;;)
+			{
+				const int ret = deflate(&stream, flush);
+				if (ret == Z_STREAM_ERROR)
+				{
+					deflateEnd(&stream);
+					throw std::runtime_error("Unable to compress data.");
+				}
+				if (final ? ret == Z_STREAM_END : stream.avail_out > 0)
+					break;
+
+				const size_t used = output.size() - stream.avail_out;
+				output.resize(output.size() + 65536);
+				stream.next_out = output.data() + used;
+				stream.avail_out = static_cast<uInt>(output.size() - used);
+			}
+
+			output.resize(output.size() - stream.avail_out);
+			deflateEnd(&stream);
+
+			return output;
+		}
+	}
+
+	//! State of an entry shared by its writer and the compressing workers
+	class ArchiveWriter::Entry
+	{
+	public:
+		Entry(std::string name) : Name{ std::move(name) } {}
+
+		//! Name of the entry
+		std::string Name;
+
+		//! Data collected for the next block
+		std::vector<uint8_t> Pending;
+
+		//! Last part of the data passed to the workers, the dictionary of the next block
+		std::vector<uint8_t> Window;
+
+		//! True once the entry was closed by its writer
+		bool Closed{ false };
+
+		//! Lock protecting the compressed blocks
+		std::mutex Mutex;
+
+		//! Compressed blocks in the order of the data
+		std::vector<Block> Blocks;
+
+		//! Number of blocks compressed so far
+		size_t NrCompressed{ 0 };
+
+		//! True once the last block was passed to the workers
+		bool Final{ false };
+	};
+
+	ArchiveWriter::ArchiveWriter(path zip_file, unsigned int nr_workers, int level, size_t block_size)
+	: _file{ std::move(zip_file) }
+	, _level{ level }
+	, _blockSize{ block_size }
+	, _dosTime{ currentDosTime() }
+	{
+		open(std::ios::trunc, 0, nr_workers);
+	}
+
+	ArchiveWriter::ArchiveWriter(const Archive& archive, unsigned int nr_workers, int level, size_t block_size)
+	: _file{ archive.filePath() }
+	, _level{ level }
+	, _blockSize{ block_size }
+	, _dosTime{ currentDosTime() }
+	, _base{ archive.mapping() }
+	{
+		// Directory records of the current entries, names are resolved once the new directory is written
+		_baseRecords.reserve(archive.nrEntries());
+		for (size_t idx = 0; idx < archive.nrEntries(); idx++)
+			_baseRecords.push_back(archive.entry(idx).NameOffset - CentralDirectoryHeaderSize);
+
+		// Append behind the end of the archive, keeping the previous directory intact
+		open(std::ios::in, _base->size(), nr_workers);
+	}
+
+	void ArchiveWriter::open(std::ios::openmode mode, uint64_t offset, unsigned int nr_workers)
+	{
+		if (_level < -1 || _level > 9)
+			throw std::invalid_argument("Compression level must be between -1 and 9.");
+		if (_blockSize < 4096 || _blockSize > (64 << 20))
+			throw std::invalid_argument("Block size must be between 4 KiB and 64 MiB.");
+
+		_stream.open(_file.string(), std::ios::binary | std::ios::out | mode);
+		if (!_stream.is_open())
+			throw std::runtime_error(_file.string() + " could not be " + (offset > 0 ? "opened." : "created."));
+		_stream.seekp(offset);
+		_offset = offset;
+
+		const unsigned int nr_threads = nr_workers > 0 ? nr_workers : std::max(1u, std::thread::hardware_concurrency());
+		_workers = std::make_unique<ThreadPool>(nr_threads, 2 * nr_threads);
+	}
+
+	ArchiveWriter::~ArchiveWriter()
+	{
+		try
+		{
+			finalize();
+		}
+		catch (...)
+		{
+			// Errors can only be reported by calling 'finalize' explicitly
+		}
+	}
+
+	std::shared_ptr<ArchiveWriter::Entry> ArchiveWriter::createEntry(std::string name)
+	{
+		if (name.empty() || name.size() > 0xffff)
+			throw std::invalid_argument("Invalid entry name '" + name + "'.");
+
+		std::lock_guard<std::mutex> guard{ _stateMutex };
+		if (_finalized)
+			throw std::logic_error(_file.string() + " is already finalized.");
+
+		_openEntries++;
+		return std::make_shared<Entry>(std::move(name));
+	}
+
+	void ArchiveWriter::write(const std::shared_ptr<Entry>& entry, const void* data, uint64_t size)
+	{
+		if (entry->Closed)
+			throw std::logic_error("Entry '" + entry->Name + "' is closed.");
+
+		// Full blocks are passed on only once more data follows, the last block of an entry is compressed differently
+		auto bytes = static_cast<const uint8_t*>(data);
+		while (size > 0)
+		{
+			if (entry->Pending.size() == _blockSize)
+				dispatch(entry, false);
+
+			const auto chunk = static_cast<size_t>(std::min<uint64_t>(size, _blockSize - entry->Pending.size()));
+			entry->Pending.insert(entry->Pending.end(), bytes, bytes + chunk);
+			bytes += chunk;
+			size -= chunk;
+		}
+	}
+
+	void ArchiveWriter::close(const std::shared_ptr<Entry>& entry)
+	{
+		if (entry->Closed)
+			return;
+
+		entry->Closed = true;
+		{
+			std::lock_guard<std::mutex> guard{ _stateMutex };
+			_openEntries--;
+			_pendingEntries++;
+		}
+
+		dispatch(entry, true);
+	}
+
+	void ArchiveWriter::finalize()
+	{
+		{
+			std::unique_lock<std::mutex> lock{ _stateMutex };
+			if (_finalized)
+				return;
+			if (_openEntries > 0)
+				throw std::logic_error(_file.string() + " has open entries.");
+
+			_entryCommitted.wait(lock, [this]() { return _pendingEntries == 0; });
+			_finalized = true;
+		}
+
+		std::exception_ptr error;
+		{
+			std::lock_guard<std::mutex> guard{ _stateMutex };
+			error = _error;
+		}
+
+		if (!error)
+		{
+			try
+			{
+				writeDirectory();
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+		}
+
+		// A failed update leaves the archive as it was
+		if (error && _base)
+		{
+			std::lock_guard<std::mutex> guard{ _fileMutex };
+			_stream.close();
+			std::error_code ec;
+			std::experimental::filesystem::resize_file(_file, _base->size(), ec);
+		}
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	void ArchiveWriter::copyEntry(const Archive& archive, size_t idx)
+	{
+		{
+			std::lock_guard<std::mutex> guard{ _stateMutex };
+			if (_finalized)
+				throw std::logic_error(_file.string() + " is already finalized.");
+		}
+
+		const auto& source = archive.entry(idx);
+		auto mapping = archive.mapping();
+		const auto data = reinterpret_cast<const uint8_t*>(mapping->data());
+
+		// Entries written as streams are followed by a data descriptor
+		uint64_t end = archive.dataOffset(idx) + source.CompressedSize;
+		if (readLE<uint16_t>(data + source.HeaderOffset + 6) & 0x8)
+		{
+			const bool zip64 = source.CompressedSize >= Zip64Marker || source.Size >= Zip64Marker;
+			const bool signature = end + 4 <= mapping->size() && readLE<uint32_t>(data + end) == DataDescriptorSignature;
+			end += (signature ? 4 : 0) + (zip64 ? 20 : 12);
+			if (end > mapping->size())
+				throw std::runtime_error(archive.filePath().string() + " has a truncated entry.");
+		}
+
+		const auto name = archive.entryName(idx);
+		Record record{ std::string{ name.data(), name.size() }, source, data + source.NameOffset - CentralDirectoryHeaderSize };
+
+		std::lock_guard<std::mutex> guard{ _fileMutex };
+		record.Entry.HeaderOffset = _offset;
+		_stream.write(reinterpret_cast<const char*>(data + source.HeaderOffset), end - source.HeaderOffset);
+		if (!_stream)
+			throw std::runtime_error(_file.string() + " could not be written.");
+		_offset += end - source.HeaderOffset;
+
+		if (_sources.empty() || _sources.back() != mapping)
+			_sources.push_back(std::move(mapping));
+		addRecord(std::move(record));
+	}
+
+	size_t ArchiveWriter::nrEntries() const
+	{
+		std::lock_guard<std::mutex> guard{ _fileMutex };
+		return _records.size();
+	}
+
+	bool ArchiveWriter::isFinalized() const
+	{
+		std::lock_guard<std::mutex> guard{ _stateMutex };
+		return _finalized;
+	}
+
+	std::vector<ArchiveEntry> ArchiveWriter::writtenEntries() const
+	{
+		std::lock_guard<std::mutex> guard{ _fileMutex };
+
+		std::vector<ArchiveEntry> entries;
+		entries.reserve(_records.size());
+		for (const auto& record : _records)
+			entries.push_back(record.Entry);
+
+		return entries;
+	}
+
+	void ArchiveWriter::dispatch(const std::shared_ptr<Entry>& entry, bool final)
+	{
+		std::vector<uint8_t> input;
+		input.swap(entry->Pending);
+		auto dictionary = entry->Window;
+
+		// Keep the end of the data as dictionary of the next block
+		if (!final)
+		{
+			if (input.size() >= WindowSize)
+				entry->Window.assign(input.end() - WindowSize, input.end());
+			else
+			{
+				entry->Window.insert(entry->Window.end(), input.begin(), input.end());
+				if (entry->Window.size() > WindowSize)
+					entry->Window.erase(entry->Window.begin(), entry->Window.end() - WindowSize);
+			}
+			entry->Pending.reserve(_blockSize);
+		}
+
+		size_t idx;
+		{
+			std::lock_guard<std::mutex> guard{ entry->Mutex };
+			idx = entry->Blocks.size();
+			entry->Blocks.emplace_back();
+			entry->Final = final;
+		}
+
+		const int level = _level;
+		_workers->enqueue([this, entry, idx, final, level, input = std::move(input), dictionary = std::move(dictionary)]() mutable
+		{
+			Block block;
+			try
+			{
+				block.Crc = static_cast<uint32_t>(crc32(0, input.data(), static_cast<uInt>(input.size())));
+				block.Size = input.size();
+				block.Data = level == 0 ? std::move(input) : deflateBlock(input, dictionary, level, final);
+			}
+			catch (...)
+			{
+				setError(std::current_exception());
+			}
+
+			complete(entry, idx, std::move(block));
+		});
+	}
+
+	void ArchiveWriter::complete(const std::shared_ptr<Entry>& entry, size_t idx, Block block)
+	{
+		bool done;
+		{
+			std::lock_guard<std::mutex> guard{ entry->Mutex };
+			entry->Blocks[idx] = std::move(block);
+			done = ++entry->NrCompressed == entry->Blocks.size() && entry->Final;
+		}
+		if (!done)
+			return;
+
+		try
+		{
+			commit(*entry);
+		}
+		catch (...)
+		{
+			setError(std::current_exception());
+		}
+
+		// Notify under the lock, 'finalize' may destroy the writer once it is woken up
+		std::lock_guard<std::mutex> guard{ _stateMutex };
+		_pendingEntries--;
+		_entryCommitted.notify_all();
+	}
+
+	void ArchiveWriter::commit(Entry& entry)
+	{
+		uint32_t crc = 0;
+		uint64_t size = 0;
+		uint64_t compressed_size = 0;
+		for (const auto& block : entry.Blocks)
+		{
+			crc = static_cast<uint32_t>(crc32_combine(crc, block.Crc, static_cast<z_off_t>(block.Size)));
+			size += block.Size;
+			compressed_size += block.Data.size();
+		}
+
+		const uint16_t method = _level == 0 ? 0 : 8;
+		const bool zip64 = size >= Zip64Marker || compressed_size >= Zip64Marker;
+
+		std::vector<uint8_t> header;
+		header.reserve(30 + entry.Name.size() + 20);
+		appendLE<uint32_t>(header, LocalFileHeaderSignature);
+		appendLE<uint16_t>(header, zip64 ? VersionZip64 : VersionDeflate);
+		appendLE<uint16_t>(header, FlagUtf8);
+		appendLE<uint16_t>(header, method);
+		appendLE<uint32_t>(header, _dosTime);
+		appendLE<uint32_t>(header, crc);
+		appendLE<uint32_t>(header, zip64 ? Zip64Marker : static_cast<uint32_t>(compressed_size));
+		appendLE<uint32_t>(header, zip64 ? Zip64Marker : static_cast<uint32_t>(size));
+		appendLE<uint16_t>(header, static_cast<uint16_t>(entry.Name.size()));
+		appendLE<uint16_t>(header, zip64 ? 20 : 0);
+		header.insert(header.end(), entry.Name.begin(), entry.Name.end());
+		if (zip64)
+		{
+			appendLE<uint16_t>(header, 0x0001);
+			appendLE<uint16_t>(header, 16);
+			appendLE<uint64_t>(header, size);
+			appendLE<uint64_t>(header, compressed_size);
+		}
+
+		std::lock_guard<std::mutex> guard{ _fileMutex };
+		const uint64_t offset = _offset;
+		_stream.write(reinterpret_cast<const char*>(header.data()), header.size());
+		for (const auto& block : entry.Blocks)
+			_stream.write(reinterpret_cast<const char*>(block.Data.data()), block.Data.size());
+		if (!_stream)
+			throw std::runtime_error(_file.string() + " could not be written.");
+		_offset += header.size() + compressed_size;
+
+		Record record{ entry.Name, {} };
+		record.Entry.HeaderOffset = offset;
+		record.Entry.CompressedSize = compressed_size;
+		record.Entry.Size = size;
+		record.Entry.Crc32 = crc;
+		record.Entry.NameLength = static_cast<uint16_t>(entry.Name.size());
+		record.Entry.Method = method;
+		addRecord(std::move(record));
+
+		// Release the compressed data
+		entry.Blocks.clear();
+		entry.Blocks.shrink_to_fit();
+	}
+
+	void ArchiveWriter::addRecord(Record record)
+	{
+		// Later entries replace earlier ones with the same name
+		auto record_it = _recordIndex.find(record.Name);
+		if (record_it != _recordIndex.end())
+			_records[record_it->second] = std::move(record);
+		else
+		{
+			_recordIndex.emplace(record.Name, _records.size());
+			_records.emplace_back(std::move(record));
+		}
+	}
+
+	void ArchiveWriter::writeDirectory()
+	{
+		std::lock_guard<std::mutex> guard{ _fileMutex };
+
+		const uint64_t dir_offset = _offset;
+		std::vector<uint8_t> directory;
+		uint64_t nr_entries = 0;
+
+		// Entries of the updated archive are listed first, unless they were replaced
+		for (uint64_t offset : _baseRecords)
+		{
+			const auto record = reinterpret_cast<const uint8_t*>(_base->data()) + offset;
+			const std::string name{ reinterpret_cast<const char*>(record) + CentralDirectoryHeaderSize, readLE<uint16_t>(record + 28) };
+			if (_recordIndex.find(name) != _recordIndex.end())
+				continue;
+
+			directory.insert(directory.end(), record, record + directoryRecordSize(record));
+			nr_entries++;
+		}
+
+		for (auto& record : _records)
+		{
+			record.Entry.NameOffset = dir_offset + directory.size() + CentralDirectoryHeaderSize;
+			nr_entries++;
+
+			// Copied entries keep their record with the new location
+			if (record.Directory)
+			{
+				const size_t begin = directory.size();
+				directory.insert(directory.end(), record.Directory, record.Directory + directoryRecordSize(record.Directory));
+				patchHeaderOffset(directory.data() + begin, record.Entry.HeaderOffset);
+				continue;
+			}
+
+			const auto& entry = record.Entry;
+
+			// Values not fitting into 32 bits are moved to the zip64 extra field
+			std::vector<uint64_t> zip64_values;
+			for (uint64_t value : { entry.Size, entry.CompressedSize, entry.HeaderOffset })
+			{
+				if (value >= Zip64Marker)
+					zip64_values.push_back(value);
+			}
+			const auto extra_size = static_cast<uint16_t>(zip64_values.empty() ? 0 : 4 + 8 * zip64_values.size());
+			auto field = [](uint64_t value) { return value >= Zip64Marker ? Zip64Marker : static_cast<uint32_t>(value); };
+
+			appendLE<uint32_t>(directory, CentralDirectorySignature);
+			appendLE<uint16_t>(directory, VersionZip64);
+			appendLE<uint16_t>(directory, zip64_values.empty() ? VersionDeflate : VersionZip64);
+			appendLE<uint16_t>(directory, FlagUtf8);
+			appendLE<uint16_t>(directory, entry.Method);
+			appendLE<uint32_t>(directory, _dosTime);
+			appendLE<uint32_t>(directory, entry.Crc32);
+			appendLE<uint32_t>(directory, field(entry.CompressedSize));
+			appendLE<uint32_t>(directory, field(entry.Size));
+			appendLE<uint16_t>(directory, static_cast<uint16_t>(record.Name.size()));
+			appendLE<uint16_t>(directory, extra_size);
+			appendLE<uint16_t>(directory, 0);
+			appendLE<uint16_t>(directory, 0);
+			appendLE<uint16_t>(directory, 0);
+			appendLE<uint32_t>(directory, 0);
+			appendLE<uint32_t>(directory, field(entry.HeaderOffset));
+			directory.insert(directory.end(), record.Name.begin(), record.Name.end());
+			if (!zip64_values.empty())
+			{
+				appendLE<uint16_t>(directory, 0x0001);
+				appendLE<uint16_t>(directory, static_cast<uint16_t>(8 * zip64_values.size()));
+				for (uint64_t value : zip64_values)
+					appendLE<uint64_t>(directory, value);
+			}
+		}
+		const uint64_t dir_size = directory.size();
+
+		// Large archives store the location of the central directory in a separate record
+		if (nr_entries >= 0xffff || dir_size >= Zip64Marker || dir_offset >= Zip64Marker)
+		{
+			const uint64_t record_offset = dir_offset + dir_size;
+			appendLE<uint32_t>(directory, Zip64EndOfCentralDirectorySignature);
+			appendLE<uint64_t>(directory, 44);
+			appendLE<uint16_t>(directory, VersionZip64);
+			appendLE<uint16_t>(directory, VersionZip64);
+			appendLE<uint32_t>(directory, 0);
+			appendLE<uint32_t>(directory, 0);
+			appendLE<uint64_t>(directory, nr_entries);
+			appendLE<uint64_t>(directory, nr_entries);
+			appendLE<uint64_t>(directory, dir_size);
+			appendLE<uint64_t>(directory, dir_offset);
+
+			appendLE<uint32_t>(directory, Zip64EndOfCentralDirectoryLocatorSignature);
+			appendLE<uint32_t>(directory, 0);
+			appendLE<uint64_t>(directory, record_offset);
+			appendLE<uint32_t>(directory, 1);
+		}
+
+		appendLE<uint32_t>(directory, EndOfCentralDirectorySignature);
+		appendLE<uint16_t>(directory, 0);
+		appendLE<uint16_t>(directory, 0);
+		appendLE<uint16_t>(directory, static_cast<uint16_t>(std::min<uint64_t>(nr_entries, 0xffff)));
+		appendLE<uint16_t>(directory, static_cast<uint16_t>(std::min<uint64_t>(nr_entries, 0xffff)));
+		appendLE<uint32_t>(directory, static_cast<uint32_t>(std::min<uint64_t>(dir_size, Zip64Marker)));
+		appendLE<uint32_t>(directory, static_cast<uint32_t>(std::min<uint64_t>(dir_offset, Zip64Marker)));
+		appendLE<uint16_t>(directory, 0);
+
+		_stream.write(reinterpret_cast<const char*>(directory.data()), directory.size());
+		_stream.close();
+		if (!_stream)
+			throw std::runtime_error(_file.string() + " could not be written.");
+	}
+
+	void ArchiveWriter::setError(std::exception_ptr error)
+	{
+		std::lock_guard<std::mutex> guard{ _stateMutex };
+		if (!_error)
+			_error = error;
+	}
+}}}
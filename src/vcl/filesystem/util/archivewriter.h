@@ -0,0 +1,275 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <experimental/filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// VCL File System Library
+#include "archive.h"
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	class ThreadPool;
+
+	/*!
+	 *	\brief Writer creating a new zip archive
+	 *
+	 *	Entries are written as streams. Their data is split into blocks which
+	 *	are compressed in parallel by a pool of workers, similar to pigz. Each
+	 *	block is deflated independently, using the preceding 32 KiB of the entry
+	 *	as dictionary, and ends with a sync flush so that the compressed blocks
+	 *	form a single deflate stream. Closing an entry does not wait for its
+	 *	compression. Entries are appended to the archive in the order in which
+	 *	their compression completes. The central directory is written by 'finalize'.
+	 *
+	 *	The compressed data of an entry is kept in memory until the entry is
+	 *	closed and all of its blocks are compressed. Different entries can be
+	 *	written from different threads at the same time. A single entry must
+	 *	only be used by one thread at a time.
+	 *
+	 *	Existing archives are updated by appending the new entries behind the
+	 *	previous end of the archive and writing a new central directory, which
+	 *	lists the previous entries unless they were replaced. The previous data
+	 *	is not modified, thus mappings of the archive stay valid.
+	 */
+	class ArchiveWriter
+	{
+	protected:
+		using path = std::experimental::filesystem::path;
+
+	public:
+		//! Entry being written
+		class Entry;
+
+		/*!
+		 *	\brief Create a new archive, replacing an existing file
+		 *	\param zip_file Path of the archive on the volume
+		 *	\param nr_workers Number of threads compressing blocks, 0 uses one per hardware thread
+		 *	\param level zlib compression level (-1 to 9), 0 stores the entries without compression
+		 *	\param block_size Size of the independently compressed blocks (4 KiB to 64 MiB)
+		 */
+		ArchiveWriter(path zip_file, unsigned int nr_workers, int level = -1, size_t block_size = 128 << 10);
+
+		/*!
+		 *	\brief Append entries to an existing archive
+		 *	\param archive Archive to update
+		 *	\param nr_workers Number of threads compressing blocks, 0 uses one per hardware thread
+		 *	\param level zlib compression level (-1 to 9), 0 stores the entries without compression
+		 *	\param block_size Size of the independently compressed blocks (4 KiB to 64 MiB)
+		 *
+		 *	If the update fails, the archive is truncated to its previous size.
+		 */
+		ArchiveWriter(const Archive& archive, unsigned int nr_workers, int level = -1, size_t block_size = 128 << 10);
+		ArchiveWriter(const ArchiveWriter&) = delete;
+
+		//! Finalize the archive if it was not done explicitly. Errors are only reported by 'finalize'.
+		~ArchiveWriter();
+
+		ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+		/*!
+		 *	\brief Start a new entry
+		 *	\param name Name of the entry relative to the archive, using '/' as separator
+		 *	\returns the handle of the entry
+		 *
+		 *	An entry with the same name as an earlier one replaces it.
+		 */
+		std::shared_ptr<Entry> createEntry(std::string name);
+
+		/*!
+		 *	\brief Append data to an entry
+		 *	\param entry Entry created by this writer
+		 *	\param data Data to write
+		 *	\param size Number of bytes to write
+		 */
+		void write(const std::shared_ptr<Entry>& entry, const void* data, uint64_t size);
+
+		/*!
+		 *	\brief Complete an entry
+		 *	\param entry Entry created by this writer
+		 *
+		 *	The remaining data is compressed in the background. Closing an entry twice has no effect.
+		 */
+		void close(const std::shared_ptr<Entry>& entry);
+
+		/*!
+		 *	\brief Copy an entry of another archive without decompressing it
+		 *	\param archive Archive containing the entry
+		 *	\param idx Index of the entry in 'archive'
+		 *
+		 *	The local header, the data and the directory record are copied unchanged,
+		 *	except for the location of the entry.
+		 */
+		void copyEntry(const Archive& archive, size_t idx);
+
+		/*!
+		 *	\brief Complete the archive
+		 *
+		 *	Waits for the compression of all closed entries and writes the central
+		 *	directory. All the entries need to be closed. Errors of the compression
+		 *	and of writing the archive are reported here, a failed update truncates
+		 *	the archive to its previous size. Finalizing the archive twice has no effect.
+		 */
+		void finalize();
+
+	public: // Properties
+
+		//! \returns the path of the archive on the volume
+		const path& filePath() const { return _file; }
+
+		//! \returns the number of entries written so far
+		size_t nrEntries() const;
+
+		//! \returns true once 'finalize' passed the check of the open entries, even if writing the archive failed
+		bool isFinalized() const;
+
+		/*!
+		 *	\brief Access the entries added to the archive
+		 *	\returns the entries written or copied, referring to their names in the new central directory
+		 *
+		 *	The name offsets are only valid once the archive is finalized.
+		 */
+		std::vector<ArchiveEntry> writtenEntries() const;
+
+	private:
+		//! Compressed part of an entry
+		struct Block
+		{
+			//! Compressed data
+			std::vector<uint8_t> Data;
+
+			//! Checksum of the uncompressed data
+			uint32_t Crc{ 0 };
+
+			//! Size of the uncompressed data
+			uint64_t Size{ 0 };
+		};
+
+		//! Entry of the central directory
+		struct Record
+		{
+			//! Name of the entry
+			std::string Name;
+
+			//! Location and properties of the entry
+			ArchiveEntry Entry;
+
+			//! Directory record of a copied entry, nullptr for entries compressed by the writer
+			const uint8_t* Directory{ nullptr };
+		};
+
+		//! Open the output and start the workers
+		void open(std::ios::openmode mode, uint64_t offset, unsigned int nr_workers);
+
+		//! Pass the collected data of an entry to the workers
+		void dispatch(const std::shared_ptr<Entry>& entry, bool final);
+
+		//! Store a compressed block, appends the entry to the archive once it is complete
+		void complete(const std::shared_ptr<Entry>& entry, size_t idx, Block block);
+
+		//! Write a complete entry to the archive
+		void commit(Entry& entry);
+
+		//! Add a record to the directory, replacing an earlier record with the same name
+		void addRecord(Record record);
+
+		//! Write the central directory and the end records
+		void writeDirectory();
+
+		//! Remember the first error of a background task
+		void setError(std::exception_ptr error);
+
+	private:
+		//! Path of the archive on the volume
+		path _file;
+
+		//! Compression level, 0 for stored entries
+		int _level;
+
+		//! Size of the blocks compressed independently
+		size_t _blockSize;
+
+		//! Modification time of all the entries in MS-DOS format
+		uint32_t _dosTime{ 0 };
+
+		//! Lock serializing the writes to the archive and protecting the directory
+		mutable std::mutex _fileMutex;
+
+		//! Output stream of the archive
+		std::ofstream _stream;
+
+		//! Position of the next entry in the archive
+		uint64_t _offset{ 0 };
+
+		//! Entries of the central directory
+		std::vector<Record> _records;
+
+		//! Indices of the records by name
+		std::unordered_map<std::string, size_t> _recordIndex;
+
+		//! Archive being updated, nullptr for new archives
+		std::shared_ptr<const MappedFile> _base;
+
+		//! Offsets of the directory records of the entries in the archive being updated
+		std::vector<uint64_t> _baseRecords;
+
+		//! Archives entries were copied from, keeping their directory records valid
+		std::vector<std::shared_ptr<const MappedFile>> _sources;
+
+		//! Lock protecting the state of the writer
+		mutable std::mutex _stateMutex;
+
+		//! Signals that an entry was written to the archive
+		std::condition_variable _entryCommitted;
+
+		//! Number of entries which are not closed yet
+		size_t _openEntries{ 0 };
+
+		//! Number of closed entries waiting for their compression
+		size_t _pendingEntries{ 0 };
+
+		//! First error of a background task
+		std::exception_ptr _error;
+
+		//! True once the central directory was written
+		bool _finalized{ false };
+
+		//! Workers compressing the blocks. Destroyed first to complete pending tasks.
+		std::unique_ptr<ThreadPool> _workers;
+	};
+}}}
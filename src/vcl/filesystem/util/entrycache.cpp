@@ -0,0 +1,161 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "entrycache.h"
+
+// C++ standard library
+#include <algorithm>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	EntryCache::EntryCache(size_t budget, size_t max_entry_size)
+	: _budget{ budget }
+	, _maxEntrySize{ std::min(max_entry_size, budget) }
+	{
+	}
+
+	EntryCache::Content EntryCache::get(uint64_t key, const Loader& load)
+	{
+		std::promise<Content> promise;
+		{
+			std::unique_lock<std::mutex> guard{ _mutex };
+			auto entry_it = _entries.find(key);
+			if (entry_it != _entries.end())
+			{
+				_hits++;
+				_usage.splice(_usage.begin(), _usage, entry_it->second.Usage);
+				auto data = entry_it->second.Data;
+				guard.unlock();
+
+				// Wait for a concurrent load to complete
+				return data.get();
+			}
+
+			// Register the pending load, later requests wait for it
+			_misses++;
+			_usage.push_front(key);
+
+			Entry entry;
+			entry.Data = promise.get_future().share();
+			entry.Usage = _usage.begin();
+			_entries.emplace(key, std::move(entry));
+		}
+
+		Content content;
+		try
+		{
+			content = std::make_shared<const std::vector<std::byte>>(load());
+		}
+		catch (...)
+		{
+			// Failed loads are not cached
+			{
+				std::lock_guard<std::mutex> guard{ _mutex };
+				auto entry_it = _entries.find(key);
+				_usage.erase(entry_it->second.Usage);
+				_entries.erase(entry_it);
+			}
+
+			promise.set_exception(std::current_exception());
+			throw;
+		}
+		promise.set_value(content);
+
+		std::lock_guard<std::mutex> guard{ _mutex };
+		auto entry_it = _entries.find(key);
+		if (entry_it != _entries.end())
+		{
+			if (content->size() > _maxEntrySize)
+			{
+				// Only the waiting requests share large files
+				_usage.erase(entry_it->second.Usage);
+				_entries.erase(entry_it);
+			}
+			else
+			{
+				entry_it->second.Size = content->size();
+				entry_it->second.Loaded = true;
+				_size += content->size();
+				evict();
+			}
+		}
+
+		return content;
+	}
+
+	void EntryCache::erase(uint64_t key)
+	{
+		std::lock_guard<std::mutex> guard{ _mutex };
+
+		auto entry_it = _entries.find(key);
+		if (entry_it == _entries.end() || !entry_it->second.Loaded)
+			return;
+
+		_size -= entry_it->second.Size;
+		_usage.erase(entry_it->second.Usage);
+		_entries.erase(entry_it);
+	}
+
+	void EntryCache::clear()
+	{
+		std::lock_guard<std::mutex> guard{ _mutex };
+
+		// Files still loading are kept, their size is not accounted yet
+		for (auto entry_it = _entries.begin(); entry_it != _entries.end();)
+		{
+			if (entry_it->second.Loaded)
+			{
+				_size -= entry_it->second.Size;
+				_usage.erase(entry_it->second.Usage);
+				entry_it = _entries.erase(entry_it);
+			}
+			else
+				++entry_it;
+		}
+	}
+
+	size_t EntryCache::size() const
+	{
+		std::lock_guard<std::mutex> guard{ _mutex };
+		return _size;
+	}
+
+	void EntryCache::evict()
+	{
+		auto usage_it = _usage.end();
+		while (_size > _budget && usage_it != _usage.begin())
+		{
+			--usage_it;
+
+			// Files still loading are skipped
+			auto entry_it = _entries.find(*usage_it);
+			if (!entry_it->second.Loaded)
+				continue;
+
+			_size -= entry_it->second.Size;
+			_entries.erase(entry_it);
+			usage_it = _usage.erase(usage_it);
+		}
+	}
+}}}
@@ -0,0 +1,147 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	/*!
+	 *	\brief Cache of entirely loaded files with a limited size
+	 *
+	 *	The least recently used files are evicted once the cached content
+	 *	exceeds the byte budget. Evicted content stays valid as long as it
+	 *	is referenced. Concurrent requests of a file missing in the cache
+	 *	wait for a single load. All methods are thread-safe.
+	 */
+	class EntryCache
+	{
+	public:
+		//! Content of a cached file
+		using Content = std::shared_ptr<const std::vector<std::byte>>;
+
+		//! Function loading the content of a file
+		using Loader = std::function<std::vector<std::byte>()>;
+
+	public:
+		/*!
+		 *	\brief Create a new cache
+		 *	\param budget Maximum number of bytes held by the cache
+		 *	\param max_entry_size Maximum size of a single file to be cached
+		 */
+		EntryCache(size_t budget, size_t max_entry_size);
+
+		/*!
+		 *	\brief Access the content of a file
+		 *	\param key Identifier of the file
+		 *	\param load Function loading the file if it is not cached
+		 *	\returns the content of the file
+		 *
+		 *	Exceptions thrown by 'load' are passed to all waiting callers.
+		 */
+		Content get(uint64_t key, const Loader& load);
+
+		//! Remove a file from the cache, files still loading are kept
+		void erase(uint64_t key);
+
+		//! Remove all files from the cache
+		void clear();
+
+	public: // Properties
+
+		//! \returns the maximum number of bytes held by the cache
+		size_t budget() const { return _budget; }
+
+		//! \returns the maximum size of a single cached file
+		size_t maxEntrySize() const { return _maxEntrySize; }
+
+		//! \returns the number of bytes currently held by the cache
+		size_t size() const;
+
+		//! \returns the number of requests served from the cache, including requests waiting for a load
+		uint64_t hits() const { return _hits; }
+
+		//! \returns the number of requests which needed to load the file
+		uint64_t misses() const { return _misses; }
+
+	private:
+		//! Cached file
+		struct Entry
+		{
+			//! Content, available once the file is loaded
+			std::shared_future<Content> Data;
+
+			//! Number of bytes of the content
+			size_t Size{ 0 };
+
+			//! True once the content is available
+			bool Loaded{ false };
+
+			//! Position in the usage list
+			std::list<uint64_t>::iterator Usage;
+		};
+
+		//! Remove the least recently used files until the budget is met
+		void evict();
+
+	private:
+		//! Maximum number of bytes held by the cache
+		size_t _budget;
+
+		//! Maximum size of a single cached file
+		size_t _maxEntrySize;
+
+		//! Lock protecting the cached files
+		mutable std::mutex _mutex;
+
+		//! Cached files
+		std::unordered_map<uint64_t, Entry> _entries;
+
+		//! Keys of the cached files, most recently used first
+		std::list<uint64_t> _usage;
+
+		//! Number of bytes held by the cache
+		size_t _size{ 0 };
+
+		//! Number of requests served from the cache
+		std::atomic<uint64_t> _hits{ 0 };
+
+		//! Number of requests which needed to load the file
+		std::atomic<uint64_t> _misses{ 0 };
+	};
+}}}
@@ -0,0 +1,258 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "inflate.h"
+
+// C++ standard library
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// zlib
+#include <ZipLib/extlibs/zlib/zlib.h>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	namespace
+	{
+		//! Largest chunk of data zlib processes in one call
+		const uint64_t MaxChunk = 1u << 30;
+	}
+
+	InflateIndex::InflateIndex(const std::byte* data, uint64_t size, uint64_t span)
+	: _span{ span }
+	{
+		// Resuming at the start of the stream does not require any state
+		_checkpoints.emplace_back();
+
+		z_stream stream{};
+		if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+			throw std::runtime_error("Unable to initialize zlib.");
+
+		// Decompress into a circular window, stopping at the end of each block
+		std::vector<uint8_t> window(WindowSize);
+		uint64_t total_in = 0;
+		uint64_t total_out = 0;
+		uint64_t last = 0;
+		int ret = Z_OK;
+		do
+		{
+			if (stream.avail_in == 0)
+			{
+				stream.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(data + total_in));
+				stream.avail_in = static_cast<uInt>(std::min(size - total_in, MaxChunk));
+			}
+			if (stream.avail_out == 0)
+			{
+				stream.next_out = window.data();
+				stream.avail_out = static_cast<uInt>(window.size());
+			}
+
+			const uInt avail_in = stream.avail_in;
+			const uInt avail_out = stream.avail_out;
+			ret = inflate(&stream, Z_BLOCK);
+			total_in += avail_in - stream.avail_in;
+			total_out += avail_out - stream.avail_out;
+			// Output space is always available, thus missing progress means the input is exhausted
+			if (ret != Z_OK && ret != Z_STREAM_END)
+			{
+				inflateEnd(&stream);
+				throw std::runtime_error("Corrupt deflate stream.");
+			}
+
+			// Record a checkpoint at the end of a block which is not the last
+			if ((stream.data_type & 128) && !(stream.data_type & 64) && total_out - last >= span)
+			{
+				Checkpoint checkpoint;
+				checkpoint.Out = total_out;
+				checkpoint.In = total_in;
+				checkpoint.Bits = stream.data_type & 7;
+
+				// Restore the order of the circular window
+				const size_t left = stream.avail_out;
+				checkpoint.Window.resize(WindowSize);
+				if (left > 0)
+					memcpy(checkpoint.Window.data(), window.data() + WindowSize - left, left);
+				if (left < WindowSize)
+					memcpy(checkpoint.Window.data() + left, window.data(), WindowSize - left);
+
+				_checkpoints.emplace_back(std::move(checkpoint));
+				last = total_out;
+			}
+		} while (ret != Z_STREAM_END);
+
+		inflateEnd(&stream);
+		_size = total_out;
+	}
+
+	const InflateIndex::Checkpoint& InflateIndex::find(uint64_t offset) const
+	{
+		auto checkpoint = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), offset, [](uint64_t offset, const Checkpoint& checkpoint)
+		{
+			return offset < checkpoint.Out;
+		});
+
+		return *(checkpoint - 1);
+	}
+
+	uint64_t inflateAll(const std::byte* data, uint64_t size, void* buffer, uint64_t buffer_size)
+	{
+		z_stream stream{};
+		if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+			throw std::runtime_error("Unable to initialize zlib.");
+
+		auto out = static_cast<Bytef*>(buffer);
+		uint64_t total_in = 0;
+		uint64_t total_out = 0;
+		int ret = Z_OK;
+		while (ret != Z_STREAM_END && total_out < buffer_size)
+		{
+			if (stream.avail_in == 0)
+			{
+				stream.next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(data + total_in));
+				stream.avail_in = static_cast<uInt>(std::min(size - total_in, MaxChunk));
+				total_in += stream.avail_in;
+			}
+
+			const auto chunk = static_cast<uInt>(std::min(buffer_size - total_out, MaxChunk));
+			stream.next_out = out + total_out;
+			stream.avail_out = chunk;
+
+			// Z_FINISH lets zlib decode without its window if the stream ends in this chunk
+			const uInt avail_in = stream.avail_in;
+			ret = inflate(&stream, Z_FINISH);
+			const uInt produced = chunk - stream.avail_out;
+			total_out += produced;
+
+			if (ret != Z_STREAM_END && ret != Z_OK && ret != Z_BUF_ERROR)
+			{
+				inflateEnd(&stream);
+				throw std::runtime_error("Corrupt deflate stream.");
+			}
+			if (ret != Z_STREAM_END && produced == 0 && avail_in == stream.avail_in && total_in == size)
+			{
+				inflateEnd(&stream);
+				throw std::runtime_error("Truncated deflate stream.");
+			}
+		}
+
+		inflateEnd(&stream);
+		return total_out;
+	}
+
+	Inflater::Inflater(const std::byte* data, uint64_t size)
+	: _data{ data }
+	, _size{ size }
+	, _stream{ std::make_unique<z_stream>() }
+	{
+		if (inflateInit2(_stream.get(), -MAX_WBITS) != Z_OK)
+			throw std::runtime_error("Unable to initialize zlib.");
+	}
+
+	Inflater::~Inflater()
+	{
+		inflateEnd(_stream.get());
+	}
+
+	void Inflater::reset(const InflateIndex::Checkpoint* checkpoint)
+	{
+		inflateReset(_stream.get());
+		_stream->avail_in = 0;
+		_finished = false;
+
+		if (!checkpoint || checkpoint->Out == 0)
+		{
+			_next = 0;
+			_position = 0;
+			return;
+		}
+
+		// Continue with the bits of the last byte belonging to the next block
+		_next = checkpoint->In;
+		_position = checkpoint->Out;
+		if (checkpoint->Bits > 0)
+		{
+			const int value = static_cast<int>(_data[checkpoint->In - 1]) >> (8 - checkpoint->Bits);
+			inflatePrime(_stream.get(), checkpoint->Bits, value);
+		}
+		inflateSetDictionary(_stream.get(), checkpoint->Window.data(), static_cast<uInt>(checkpoint->Window.size()));
+	}
+
+	uint64_t Inflater::read(void* buffer, uint64_t size)
+	{
+		auto out = static_cast<Bytef*>(buffer);
+		uint64_t read_bytes = 0;
+		while (read_bytes < size && !_finished)
+		{
+			feed();
+
+			const auto chunk = static_cast<uInt>(std::min(size - read_bytes, MaxChunk));
+			_stream->next_out = out + read_bytes;
+			_stream->avail_out = chunk;
+
+			const uInt avail_in = _stream->avail_in;
+			const int ret = inflate(_stream.get(), Z_NO_FLUSH);
+			const uInt produced = chunk - _stream->avail_out;
+			read_bytes += produced;
+
+			if (ret == Z_STREAM_END)
+				_finished = true;
+			else if (ret != Z_OK && ret != Z_BUF_ERROR)
+				throw std::runtime_error("Corrupt deflate stream.");
+			else if (produced == 0 && avail_in == _stream->avail_in && _next == _size)
+				throw std::runtime_error("Truncated deflate stream.");
+		}
+
+		_position += read_bytes;
+		return read_bytes;
+	}
+
+	uint64_t Inflater::skip(uint64_t size)
+	{
+		uint8_t scratch[16384];
+
+		uint64_t skipped = 0;
+		while (skipped < size)
+		{
+			const auto read_bytes = read(scratch, std::min<uint64_t>(sizeof(scratch), size - skipped));
+			if (read_bytes == 0)
+				break;
+
+			skipped += read_bytes;
+		}
+
+		return skipped;
+	}
+
+	void Inflater::feed()
+	{
+		if (_stream->avail_in > 0 || _next == _size)
+			return;
+
+		const auto chunk = std::min(_size - _next, MaxChunk);
+		_stream->next_in = reinterpret_cast<Bytef*>(const_cast<std::byte*>(_data + _next));
+		_stream->avail_in = static_cast<uInt>(chunk);
+		_next += chunk;
+	}
+}}}
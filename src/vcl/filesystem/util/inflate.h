@@ -0,0 +1,183 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Forward declaration
+struct z_stream_s;
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	/*!
+	 *	\brief Points to resume decompressing a deflate stream
+	 *
+	 *	Each checkpoint stores the state required to start inflating at a
+	 *	block boundary: the position in the compressed and uncompressed
+	 *	data, the bits of the boundary byte and the preceding 32 KiB window.
+	 */
+	class InflateIndex
+	{
+	public:
+		//! Size of the deflate window
+		static const size_t WindowSize = 32768;
+
+		//! State to resume decompressing from
+		struct Checkpoint
+		{
+			//! Position in the uncompressed data
+			uint64_t Out{ 0 };
+
+			//! Position in the compressed data
+			uint64_t In{ 0 };
+
+			//! Number of bits of the byte before 'In' belonging to the next block
+			int Bits{ 0 };
+
+			//! Uncompressed data preceding 'Out'
+			std::vector<uint8_t> Window;
+		};
+
+	public:
+		/*!
+		 *	\brief Build the index by decompressing the entire stream once
+		 *	\param data Raw deflate stream
+		 *	\param size Number of bytes of the deflate stream
+		 *	\param span Minimum distance of checkpoints in the uncompressed data
+		 */
+		InflateIndex(const std::byte* data, uint64_t size, uint64_t span);
+
+		//! \returns the last checkpoint before 'offset'
+		const Checkpoint& find(uint64_t offset) const;
+
+	public: // Properties
+
+		//! \returns the minimum distance of checkpoints
+		uint64_t span() const { return _span; }
+
+		//! \returns the number of checkpoints
+		size_t nrCheckpoints() const { return _checkpoints.size(); }
+
+		//! \returns the size of the uncompressed data
+		uint64_t uncompressedSize() const { return _size; }
+
+	private:
+		//! Minimum distance of checkpoints
+		uint64_t _span;
+
+		//! Size of the uncompressed data
+		uint64_t _size{ 0 };
+
+		//! Checkpoints ordered by their position, the first is at the start of the stream
+		std::vector<Checkpoint> _checkpoints;
+	};
+
+	/*!
+	 *	\brief Decompress an entire raw deflate stream at once
+	 *	\param data Raw deflate stream
+	 *	\param size Number of bytes of the deflate stream
+	 *	\param buffer Buffer to write the data to
+	 *	\param buffer_size Size of 'buffer', the size of the uncompressed data at most
+	 *	\returns the number of bytes written
+	 *
+	 *	The data is written directly to the buffer. zlib skips maintaining
+	 *	its window when the entire output fits, avoiding any extra copy.
+	 */
+	uint64_t inflateAll(const std::byte* data, uint64_t size, void* buffer, uint64_t buffer_size);
+
+	/*!
+	 *	\brief Decompress a raw deflate stream held in memory
+	 */
+	class Inflater
+	{
+	public:
+		/*!
+		 *	\brief Prepare decompressing a stream
+		 *	\param data Raw deflate stream
+		 *	\param size Number of bytes of the deflate stream
+		 */
+		Inflater(const std::byte* data, uint64_t size);
+		Inflater(const Inflater&) = delete;
+		~Inflater();
+
+		Inflater& operator=(const Inflater&) = delete;
+
+		/*!
+		 *	\brief Restart decompressing
+		 *	\param checkpoint Point to resume from, nullptr to start from the beginning
+		 */
+		void reset(const InflateIndex::Checkpoint* checkpoint = nullptr);
+
+		/*!
+		 *	\brief Decompress the next part of the stream
+		 *	\param buffer Buffer to write the data to
+		 *	\param size Number of bytes to decompress
+		 *	\returns the number of bytes written, less than 'size' at the end of the stream
+		 */
+		uint64_t read(void* buffer, uint64_t size);
+
+		/*!
+		 *	\brief Discard the next part of the stream
+		 *	\param size Number of bytes to skip
+		 *	\returns the number of bytes skipped
+		 */
+		uint64_t skip(uint64_t size);
+
+	public: // Properties
+
+		//! \returns the position in the uncompressed data
+		uint64_t position() const { return _position; }
+
+	private:
+		//! Pass the next part of the compressed data to the stream
+		void feed();
+
+	private:
+		//! Compressed data
+		const std::byte* _data;
+
+		//! Size of the compressed data
+		uint64_t _size;
+
+		//! Position of the next byte passed to the stream
+		uint64_t _next{ 0 };
+
+		//! Position in the uncompressed data
+		uint64_t _position{ 0 };
+
+		//! True if the end of the stream was reached
+		bool _finished{ false };
+
+		//! State of zlib
+		std::unique_ptr<z_stream_s> _stream;
+	};
+}}}
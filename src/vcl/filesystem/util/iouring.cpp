@@ -0,0 +1,271 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "iouring.h"
+
+// C++ standard library
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+// Linux
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+#if defined(__linux__)
+	IoUring::IoUring(unsigned int entries)
+	{
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+		if (_fd < 0)
+			throw std::runtime_error("io_uring could not be created: " + std::string(strerror(errno)));
+
+		_entries = params.sq_entries;
+
+		// Map the rings shared with the kernel
+		_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+		_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_mmap)
+			_sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+
+		_sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+		if (_sqRing == MAP_FAILED)
+		{
+			close(_fd);
+			throw std::runtime_error("io_uring submission queue could not be mapped.");
+		}
+
+		_cqRing = single_mmap ? _sqRing : mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+		if (_cqRing == MAP_FAILED)
+		{
+			munmap(_sqRing, _sqRingSize);
+			close(_fd);
+			throw std::runtime_error("io_uring completion queue could not be mapped.");
+		}
+
+		_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		void* sqes = mmap(nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+		if (sqes == MAP_FAILED)
+		{
+			if (_cqRing != _sqRing)
+				munmap(_cqRing, _cqRingSize);
+			munmap(_sqRing, _sqRingSize);
+			close(_fd);
+			throw std::runtime_error("io_uring submission entries could not be mapped.");
+		}
+		_sqes = static_cast<io_uring_sqe*>(sqes);
+
+		auto* sq = static_cast<char*>(_sqRing);
+		_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+		_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+		_sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+		_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+		auto* cq = static_cast<char*>(_cqRing);
+		_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+		_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+		_cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+		_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+	}
+
+	IoUring::~IoUring()
+	{
+		munmap(_sqes, _sqesSize);
+		if (_cqRing != _sqRing)
+			munmap(_cqRing, _cqRingSize);
+		munmap(_sqRing, _sqRingSize);
+		close(_fd);
+	}
+
+	bool IoUring::isSupported()
+	{
+		static const bool supported = []()
+		{
+			io_uring_params params;
+			memset(&params, 0, sizeof(params));
+			int fd = static_cast<int>(syscall(__NR_io_uring_setup, 1, &params));
+			if (fd < 0)
+				return false;
+
+			// Operations on paths were added in Linux 5.6, together with the probe of the supported operations
+			const unsigned nr_ops = 256;
+			std::vector<uint8_t> buffer(sizeof(io_uring_probe) + nr_ops * sizeof(io_uring_probe_op), 0);
+			auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+			const bool probed = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, nr_ops) == 0;
+			close(fd);
+			if (!probed)
+				return false;
+
+			for (unsigned op : { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE })
+			{
+				if (op >= probe->ops_len || (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0)
+					return false;
+			}
+
+			return true;
+		}();
+
+		return supported;
+	}
+
+	io_uring_sqe* IoUring::nextEntry()
+	{
+		if (_pending == _entries)
+			return nullptr;
+
+		// Only this thread produces entries, the kernel consumes them on submission
+		const unsigned tail = *_sqTail + _pending;
+		const unsigned idx = tail & *_sqMask;
+		io_uring_sqe* sqe = &_sqes[idx];
+		memset(sqe, 0, sizeof(io_uring_sqe));
+		_sqArray[idx] = idx;
+		_pending++;
+
+		return sqe;
+	}
+
+	bool IoUring::prepareStatx(const char* file, struct statx* info, uint64_t user_data)
+	{
+		auto* sqe = nextEntry();
+		if (!sqe)
+			return false;
+
+		sqe->opcode = IORING_OP_STATX;
+		sqe->fd = AT_FDCWD;
+		sqe->addr = reinterpret_cast<uint64_t>(file);
+		sqe->len = STATX_TYPE | STATX_SIZE;
+		sqe->off = reinterpret_cast<uint64_t>(info);
+		sqe->statx_flags = AT_STATX_SYNC_AS_STAT;
+		sqe->user_data = user_data;
+		return true;
+	}
+
+	bool IoUring::prepareOpenAt(const char* file, int flags, uint64_t user_data)
+	{
+		auto* sqe = nextEntry();
+		if (!sqe)
+			return false;
+
+		sqe->opcode = IORING_OP_OPENAT;
+		sqe->fd = AT_FDCWD;
+		sqe->addr = reinterpret_cast<uint64_t>(file);
+		sqe->open_flags = static_cast<uint32_t>(flags);
+		sqe->user_data = user_data;
+		return true;
+	}
+
+	bool IoUring::prepareRead(int fd, void* buf, uint32_t size, uint64_t offset, uint64_t user_data)
+	{
+		auto* sqe = nextEntry();
+		if (!sqe)
+			return false;
+
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = fd;
+		sqe->addr = reinterpret_cast<uint64_t>(buf);
+		sqe->len = size;
+		sqe->off = offset;
+		sqe->user_data = user_data;
+		return true;
+	}
+
+	bool IoUring::prepareClose(int fd, uint64_t user_data)
+	{
+		auto* sqe = nextEntry();
+		if (!sqe)
+			return false;
+
+		sqe->opcode = IORING_OP_CLOSE;
+		sqe->fd = fd;
+		sqe->user_data = user_data;
+		return true;
+	}
+
+	void IoUring::submitAndWait(const std::function<void(uint64_t user_data, int result)>& on_completion)
+	{
+		// Publish the prepared entries to the kernel
+		const unsigned to_submit = _pending;
+		__atomic_store_n(_sqTail, *_sqTail + to_submit, __ATOMIC_RELEASE);
+		_pending = 0;
+
+		unsigned submitted = 0;
+		unsigned completed = 0;
+		while (completed < to_submit)
+		{
+			// Submit the remaining entries and wait for the outstanding completions
+			const auto res = syscall(__NR_io_uring_enter, _fd, to_submit - submitted, to_submit - completed, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if (res < 0 && errno != EINTR)
+				throw std::runtime_error("io_uring submission failed: " + std::string(strerror(errno)));
+			if (res > 0)
+				submitted += static_cast<unsigned>(res);
+
+			unsigned head = *_cqHead;
+			const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+			while (head != tail)
+			{
+				const io_uring_cqe& cqe = _cqes[head & *_cqMask];
+				on_completion(cqe.user_data, cqe.res);
+
+				head++;
+				completed++;
+			}
+			__atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+		}
+	}
+#else
+	IoUring::IoUring(unsigned int entries)
+	{
+		throw std::runtime_error("io_uring is not supported on this platform.");
+	}
+
+	IoUring::~IoUring()
+	{
+	}
+
+	bool IoUring::isSupported()
+	{
+		return false;
+	}
+
+	io_uring_sqe* IoUring::nextEntry() { return nullptr; }
+	bool IoUring::prepareStatx(const char*, struct statx*, uint64_t) { return false; }
+	bool IoUring::prepareOpenAt(const char*, int, uint64_t) { return false; }
+	bool IoUring::prepareRead(int, void*, uint32_t, uint64_t, uint64_t) { return false; }
+	bool IoUring::prepareClose(int, uint64_t) { return false; }
+	void IoUring::submitAndWait(const std::function<void(uint64_t, int)>&) {}
+#endif
+}}}
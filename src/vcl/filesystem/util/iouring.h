@@ -0,0 +1,128 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ Standard Library
+#include <cstdint>
+#include <functional>
+
+// Forward declaration
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct statx;
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	/*!
+	 *	\brief Minimal Linux io_uring instance based on the raw system calls
+	 *
+	 *	Operations are first prepared in the submission queue and then
+	 *	submitted together with a single system call. Only available
+	 *	on Linux kernels supporting io_uring (5.6 and later).
+	 */
+	class IoUring
+	{
+	public:
+		/*!
+		 *	\brief Create a new ring
+		 *	\param entries Number of operations which can be submitted at once
+		 */
+		IoUring(unsigned int entries);
+		IoUring(const IoUring&) = delete;
+		~IoUring();
+
+		IoUring& operator=(const IoUring&) = delete;
+
+		//! \returns true if the system supports io_uring with all the operations of this class
+		static bool isSupported();
+
+		//! \returns the number of operations which can be prepared before submitting
+		unsigned int capacity() const { return _entries; }
+
+		//! \returns the number of prepared, but not yet submitted operations
+		unsigned int pending() const { return _pending; }
+
+		//! Query the size and type of a file
+		bool prepareStatx(const char* file, struct statx* info, uint64_t user_data);
+
+		//! Open a file relative to the current working directory
+		bool prepareOpenAt(const char* file, int flags, uint64_t user_data);
+
+		//! Read from an open file
+		bool prepareRead(int fd, void* buf, uint32_t size, uint64_t offset, uint64_t user_data);
+
+		//! Close an open file
+		bool prepareClose(int fd, uint64_t user_data);
+
+		/*!
+		 *	\brief Submit all prepared operations and wait for their completion
+		 *	\param on_completion Called with the user data and the result of each operation
+		 *
+		 *	Results follow the kernel convention: negative values are error codes.
+		 */
+		void submitAndWait(const std::function<void(uint64_t user_data, int result)>& on_completion);
+
+	private:
+		//! \returns the next free submission entry, nullptr if the queue is full
+		io_uring_sqe* nextEntry();
+
+	private:
+		//! Descriptor of the ring
+		int _fd{ -1 };
+
+		//! Number of submission entries
+		unsigned int _entries{ 0 };
+
+		//! Number of prepared operations
+		unsigned int _pending{ 0 };
+
+		//! Mapped submission queue ring
+		void* _sqRing{ nullptr };
+		size_t _sqRingSize{ 0 };
+
+		//! Mapped completion queue ring
+		void* _cqRing{ nullptr };
+		size_t _cqRingSize{ 0 };
+
+		//! Mapped submission queue entries
+		io_uring_sqe* _sqes{ nullptr };
+		size_t _sqesSize{ 0 };
+
+		//! Submission queue pointers
+		unsigned* _sqHead{ nullptr };
+		unsigned* _sqTail{ nullptr };
+		unsigned* _sqMask{ nullptr };
+		unsigned* _sqArray{ nullptr };
+
+		//! Completion queue pointers
+		unsigned* _cqHead{ nullptr };
+		unsigned* _cqTail{ nullptr };
+		unsigned* _cqMask{ nullptr };
+		io_uring_cqe* _cqes{ nullptr };
+	};
+}}}
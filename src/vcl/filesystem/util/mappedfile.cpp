@@ -0,0 +1,178 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "mappedfile.h"
+
+// C++ standard library
+#include <stdexcept>
+
+#if defined(_WIN32)
+// Windows
+#ifndef NOMINMAX
+#	define NOMINMAX
+#endif
+#include <windows.h>
+#else
+// POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+#if defined(_WIN32)
+	namespace
+	{
+		HANDLE openFile(const std::experimental::filesystem::path& file)
+		{
+			// Mapped archives are appended to and replaced while they are mapped
+			const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+			HANDLE h = CreateFileW(file.c_str(), GENERIC_READ, share, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (h == INVALID_HANDLE_VALUE)
+				throw std::runtime_error(file.string() + " could not be opened.");
+
+			return h;
+		}
+	}
+
+	MappedFile::MappedFile(path file)
+	: _file{ std::move(file) }
+	{
+		HANDLE h = openFile(_file);
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(h, &size))
+		{
+			CloseHandle(h);
+			throw std::runtime_error(_file.string() + " could not be queried.");
+		}
+		_size = static_cast<uint64_t>(size.QuadPart);
+
+		map(h);
+	}
+
+	MappedFile::MappedFile(path file, uint64_t size)
+	: _file{ std::move(file) }
+	, _size{ size }
+	{
+		map(openFile(_file));
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (_data)
+			UnmapViewOfFile(_data);
+		if (_mappingHandle)
+			CloseHandle(_mappingHandle);
+		if (_fileHandle)
+			CloseHandle(_fileHandle);
+	}
+
+	void MappedFile::map(void* handle)
+	{
+		_fileHandle = handle;
+
+		// Empty files cannot be mapped
+		if (_size == 0)
+			return;
+
+		_mappingHandle = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!_mappingHandle)
+		{
+			CloseHandle(handle);
+			throw std::runtime_error(_file.string() + " could not be mapped.");
+		}
+
+		_data = static_cast<const std::byte*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, static_cast<SIZE_T>(_size)));
+		if (!_data)
+		{
+			CloseHandle(_mappingHandle);
+			CloseHandle(handle);
+			throw std::runtime_error(_file.string() + " could not be mapped.");
+		}
+	}
+#else
+	namespace
+	{
+		int openFile(const std::experimental::filesystem::path& file)
+		{
+			int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				throw std::runtime_error(file.string() + " could not be opened.");
+
+			return fd;
+		}
+	}
+
+	MappedFile::MappedFile(path file)
+	: _file{ std::move(file) }
+	{
+		int fd = openFile(_file);
+
+		struct stat info;
+		if (::fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			throw std::runtime_error(_file.string() + " could not be queried.");
+		}
+		_size = static_cast<uint64_t>(info.st_size);
+
+		map(fd);
+	}
+
+	MappedFile::MappedFile(path file, uint64_t size)
+	: _file{ std::move(file) }
+	, _size{ size }
+	{
+		map(openFile(_file));
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (_data)
+			::munmap(const_cast<std::byte*>(_data), _size);
+	}
+
+	void MappedFile::map(int fd)
+	{
+		// Empty files cannot be mapped
+		if (_size > 0)
+		{
+			void* mem = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+			if (mem == MAP_FAILED)
+			{
+				::close(fd);
+				throw std::runtime_error(_file.string() + " could not be mapped.");
+			}
+
+			_data = static_cast<const std::byte*>(mem);
+		}
+
+		// The mapping stays valid after closing the descriptor
+		::close(fd);
+	}
+#endif
+}}}
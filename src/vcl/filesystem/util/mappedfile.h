@@ -0,0 +1,99 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ Standard Library
+#include <cstddef>
+#include <cstdint>
+#include <experimental/filesystem>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	/*!
+	 *	\brief Read-only memory mapping of an entire file on a volume
+	 */
+	class MappedFile
+	{
+	protected:
+		using path = std::experimental::filesystem::path;
+
+	public:
+		MappedFile(path file);
+
+		/*!
+		 *	\brief Map a file with a known size
+		 *	\param file Path to the file on the volume
+		 *	\param size Current size of the file, as queried by 'stat'
+		 *
+		 *	Saves querying the size of the open file again.
+		 */
+		MappedFile(path file, uint64_t size);
+		MappedFile(const MappedFile&) = delete;
+		~MappedFile();
+
+		MappedFile& operator=(const MappedFile&) = delete;
+
+	public: // Properties
+
+		//! \returns the path of the mapped file
+		const path& filePath() const { return _file; }
+
+		//! \returns the start of the mapped file content
+		const std::byte* data() const { return _data; }
+
+		//! \returns the size of the mapped file in bytes
+		uint64_t size() const { return _size; }
+
+	private:
+#if defined(_WIN32)
+		//! Map '_size' bytes of the open file 'handle', which is owned afterwards
+		void map(void* handle);
+#else
+		//! Map '_size' bytes of the open file 'fd' and close it
+		void map(int fd);
+#endif
+
+	private:
+		//! Path to the file on the volume
+		path _file;
+
+		//! Start of the mapped memory
+		const std::byte* _data{ nullptr };
+
+		//! Size of the mapped memory
+		uint64_t _size{ 0 };
+
+#if defined(_WIN32)
+		//! Native handle of the file
+		void* _fileHandle{ nullptr };
+
+		//! Native handle of the file mapping
+		void* _mappingHandle{ nullptr };
+#endif
+	};
+}}}
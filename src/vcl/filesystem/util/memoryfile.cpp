@@ -26,33 +26,67 @@
 
 // C++ standard library
 #include <algorithm>
+#include <cstring>
 
 namespace Vcl { namespace FileSystem { namespace Util
 {
-	MemoryFile::MemoryFile(path rel_path)
-	: _relPath(rel_path)
+	MemoryFileSnapshot::MemoryFileSnapshot(std::shared_ptr<PageArena> arena)
+	: _arena(std::move(arena))
+	{
+	}
+
+	MemoryFileSnapshot::MemoryFileSnapshot(const MemoryFileSnapshot& other)
+	: _arena(other._arena)
+	, _size(other._size)
+	, _nrPages(other._nrPages)
+	, _chunks(other._chunks)
 	{
+		for (auto chunk : _chunks)
+			chunk->References.fetch_add(1, std::memory_order_relaxed);
 	}
 
-	size_t MemoryFile::read(size_t offset, void* buffer, size_t size)
+	MemoryFileSnapshot::~MemoryFileSnapshot()
+	{
+		for (auto chunk : _chunks)
+			releaseChunk(chunk);
+	}
+
+	void MemoryFileSnapshot::releaseChunk(PageChunk* chunk) const
+	{
+		if (chunk->References.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		for (auto page : chunk->Pages)
+		{
+			if (page)
+				_arena->release(page);
+		}
+		delete chunk;
+	}
+
+	size_t MemoryFileSnapshot::read(size_t offset, void* buffer, size_t size) const
 	{
 		// Check validity of offset
 		if (offset >= _size)
 			return 0;
 
+		// Do not read beyond the end of the content
+		size = std::min(size, _size - offset);
+
 		// Determine the start page
-		auto page_idx = offset / size;
-		auto page_offset = offset - size * page_idx;
+		const size_t page_size = _arena->pageSize();
+		auto page_idx = offset / page_size;
+		auto page_offset = offset - page_size * page_idx;
 
 		size_t read_bytes = 0;
-		while (read_bytes < size && page_idx < _pages.size())
+		while (read_bytes < size && page_idx < _nrPages)
 		{
 			// Bytes to read in this page
-			size_t bytes_to_read = sizeof(MemoryPage::Memory) - page_offset;
+			size_t bytes_to_read = page_size - page_offset;
 			bytes_to_read = std::min(bytes_to_read, size - read_bytes);
 
 			// Copy the content
-			memcpy(static_cast<uint8_t*>(buffer) + read_bytes, _pages[page_idx]->Memory + page_offset, bytes_to_read);
+			memcpy(static_cast<uint8_t*>(buffer) + read_bytes, page(page_idx)->Memory + page_offset, bytes_to_read);
 
 			read_bytes += bytes_to_read;
 			page_offset = 0;
@@ -62,44 +96,140 @@ namespace Vcl { namespace FileSystem { namespace Util
 		return read_bytes;
 	}
 
+	MemoryFile::MemoryFile(path rel_path, std::shared_ptr<PageArena> arena)
+	: _relPath(rel_path)
+	, _arena(arena ? std::move(arena) : PageArena::defaultArena())
+	, _content(std::make_shared<MemoryFileSnapshot>(_arena))
+	{
+	}
+
+	size_t MemoryFile::size() const
+	{
+		std::shared_lock<std::shared_mutex> guard{ _mutex };
+		return _content->size();
+	}
+
+	size_t MemoryFile::nrPages() const
+	{
+		std::shared_lock<std::shared_mutex> guard{ _mutex };
+		return _content->nrPages();
+	}
+
+	std::shared_ptr<const MemoryFileSnapshot> MemoryFile::snapshot() const
+	{
+		std::lock_guard<std::shared_mutex> guard{ _mutex };
+		_shared = true;
+		return _content;
+	}
+
+	size_t MemoryFile::read(size_t offset, void* buffer, size_t size) const
+	{
+		// Writers modify the content in place unless it was handed out as snapshot
+		std::shared_lock<std::shared_mutex> guard{ _mutex };
+		return _content->read(offset, buffer, size);
+	}
+
 	void MemoryFile::write(size_t offset, void* buffer, size_t size)
 	{
-		// Allocate additional pages if necessary
-		if (offset + size >= _size)
+		std::lock_guard<std::shared_mutex> guard{ _mutex };
+
+		// Continue on a new version sharing the pages if the current one is visible to readers
+		if (_shared)
 		{
-			_size = offset + size;
+			_content = std::make_shared<MemoryFileSnapshot>(*_content);
+			_shared = false;
+		}
 
-			auto nr_pages = (_size + (sizeof(MemoryPage::Memory) - 1)) / sizeof(MemoryPage::Memory);
-			if (nr_pages > _pages.size())
-			{
-				// Current page count
-				auto cnt = _pages.size();
-				_pages.resize(nr_pages);
+		auto& content = *_content;
+		const size_t page_size = _arena->pageSize();
 
-				std::generate(_pages.begin() + cnt, _pages.end(), []()
+		// Allocate additional pages if necessary
+		if (offset + size > content._size)
+		{
+			const size_t old_size = content._size;
+			const size_t nr_pages = (offset + size + (page_size - 1)) / page_size;
+			while (content._nrPages < nr_pages)
+			{
+				const size_t chunk_idx = content._nrPages / MemoryFileSnapshot::PagesPerChunk;
+				if (chunk_idx == content._chunks.size())
 				{
-					return std::make_unique<MemoryPage>();
-				});
+					auto chunk = std::make_unique<MemoryFileSnapshot::PageChunk>();
+					content._chunks.push_back(chunk.get());
+					chunk.release();
+				}
+
+				writableChunk(chunk_idx)->Pages[content._nrPages % MemoryFileSnapshot::PagesPerChunk] = _arena->allocate();
+				content._nrPages++;
+			}
+			content._size = offset + size;
+
+			// Pages are recycled, thus clear the gap between the old end and the written range
+			for (size_t pos = old_size; pos < offset;)
+			{
+				const size_t page_offset = pos % page_size;
+				const size_t bytes = std::min(page_size - page_offset, offset - pos);
+				memset(writablePage(pos / page_size) + page_offset, 0, bytes);
+				pos += bytes;
 			}
 		}
 
 		// Determine the start page
-		auto page_idx = offset / size;
-		auto page_offset = offset - size * page_idx;
+		auto page_idx = offset / page_size;
+		auto page_offset = offset - page_size * page_idx;
 
 		size_t written_bytes = 0;
 		while (written_bytes < size)
 		{
 			// Bytes to read in this page
-			size_t bytes_to_write = sizeof(MemoryPage::Memory) - page_offset;
+			size_t bytes_to_write = page_size - page_offset;
 			bytes_to_write = std::min(bytes_to_write, size - written_bytes);
 
 			// Copy the content
-			memcpy(_pages[page_idx]->Memory + page_offset, static_cast<uint8_t*>(buffer) + written_bytes, bytes_to_write);
+			memcpy(writablePage(page_idx) + page_offset, static_cast<uint8_t*>(buffer) + written_bytes, bytes_to_write);
 
 			written_bytes += bytes_to_write;
 			page_offset = 0;
 			page_idx++;
 		}
 	}
+
+	MemoryFileSnapshot::PageChunk* MemoryFile::writableChunk(size_t idx)
+	{
+		auto& chunk = _content->_chunks[idx];
+
+		// Like pages, chunks only gain references while holding the lock
+		if (chunk->References.load(std::memory_order_acquire) > 1)
+		{
+			auto copy = std::make_unique<MemoryFileSnapshot::PageChunk>();
+			for (size_t i = 0; i < MemoryFileSnapshot::PagesPerChunk; i++)
+			{
+				if (auto page = chunk->Pages[i])
+				{
+					PageArena::retain(page);
+					copy->Pages[i] = page;
+				}
+			}
+			_content->releaseChunk(chunk);
+			chunk = copy.release();
+		}
+
+		return chunk;
+	}
+
+	std::byte* MemoryFile::writablePage(size_t idx)
+	{
+		auto& page = writableChunk(idx / MemoryFileSnapshot::PagesPerChunk)->Pages[idx % MemoryFileSnapshot::PagesPerChunk];
+
+		// New references are only added while holding the lock, thus a
+		// page with a single reference is exclusively owned by this file.
+		if (page->References.load(std::memory_order_acquire) > 1)
+		{
+			auto copy = _arena->allocate();
+			memcpy(copy->Memory, page->Memory, _arena->pageSize());
+			_arena->release(page);
+			page = copy;
+		}
+
+		return page->Memory;
+	}
 }}}
@@ -28,15 +28,90 @@
 #include <vcl/config/global.h>
 
 // C++ Standard Library
-#include <filesystem>
+#include <atomic>
+#include <experimental/filesystem>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+// VCL File System Library
+#include "pagearena.h"
 
 namespace Vcl { namespace FileSystem { namespace Util
 {
-	struct MemoryPage
+	/*!
+	 *	\brief Immutable version of the content of a memory file
+	 *
+	 *	Snapshots share their pages with the file and with other snapshots.
+	 *	The page table is split into chunks of 'PagesPerChunk' pages, which
+	 *	are shared the same way. Chunks and pages are only copied once the
+	 *	file modifies them.
+	 */
+	class MemoryFileSnapshot
 	{
-		uint8_t Memory[512];
+		friend class MemoryFile;
+
+	public:
+		//! Number of pages referenced by a single chunk of the page table
+		static const size_t PagesPerChunk = 64;
+
+	public:
+		MemoryFileSnapshot(std::shared_ptr<PageArena> arena);
+
+		//! Create a copy sharing the pages of 'other'
+		MemoryFileSnapshot(const MemoryFileSnapshot& other);
+		~MemoryFileSnapshot();
+
+		MemoryFileSnapshot& operator=(const MemoryFileSnapshot&) = delete;
+
+		/*!
+		 *	\brief Read from the snapshot
+		 *	\param offset Position in the file to start reading from
+		 *	\param buffer Buffer to write the data to
+		 *	\param size Number of bytes to read
+		 *	\returns the number of bytes read
+		 */
+		size_t read(size_t offset, void* buffer, size_t size) const;
+
+	public: // Properties
+
+		//! \returns the size of the content in bytes
+		size_t size() const { return _size; }
+
+		//! \returns the number of pages holding the content
+		size_t nrPages() const { return _nrPages; }
+
+	private:
+		//! Part of the page table, shared between versions of a file
+		struct PageChunk
+		{
+			//! Number of versions referring to the chunk
+			std::atomic<uint32_t> References{ 1 };
+
+			//! Pages of the chunk, nullptr beyond the end of the content
+			PageArena::Page* Pages[PagesPerChunk] = {};
+		};
+
+		//! \returns the page 'idx' of the content
+		PageArena::Page* page(size_t idx) const { return _chunks[idx / PagesPerChunk]->Pages[idx % PagesPerChunk]; }
+
+		//! Remove a reference to 'chunk'. Its pages are released with the last reference.
+		void releaseChunk(PageChunk* chunk) const;
+
+	private:
+		//! Allocator owning the pages
+		std::shared_ptr<PageArena> _arena;
+
+		//! Size of the content
+		size_t _size{ 0 };
+
+		//! Number of pages holding the content
+		size_t _nrPages{ 0 };
+
+		//! Chunks of the page table
+		std::vector<PageChunk*> _chunks;
 	};
 
 	class MemoryFile
@@ -45,24 +120,86 @@ namespace Vcl { namespace FileSystem { namespace Util
 		using path = std::experimental::filesystem::path;
 		
 	public:
-		MemoryFile(path rel_path);
+		/*!
+		 *	\brief Create a new empty memory file
+		 *	\param rel_path Path of the file relative to the mount point
+		 *	\param arena Allocator providing the pages of the file. The process-wide 'PageArena::defaultArena' is used if none is given.
+		 */
+		MemoryFile(path rel_path, std::shared_ptr<PageArena> arena = {});
+		MemoryFile(const MemoryFile&) = delete;
 
-		size_t read(size_t offset, void* buffer, size_t size);
+		MemoryFile& operator=(const MemoryFile&) = delete;
+
+		/*!
+		 *	\brief Read from the memory file
+		 *	\param offset Position in the file to start reading from
+		 *	\param buffer Buffer to write the data to
+		 *	\param size Number of bytes to read
+		 *	\returns the number of bytes read
+		 *
+		 *	Reading does not modify the file and can be done from multiple threads at once.
+		 *	Reads wait for concurrent writes. Unlike a snapshot, a read does not cause
+		 *	the next write to copy any part of the content.
+		 */
+		size_t read(size_t offset, void* buffer, size_t size) const;
+
+		/*!
+		 *	\brief Write to the memory file
+		 *	\param offset Position in the file to start writing to
+		 *	\param buffer Data to write
+		 *	\param size Number of bytes to write
+		 *
+		 *	The file grows if the written range extends beyond its end.
+		 *	Pages shared with a snapshot are copied before they are modified. The
+		 *	first write after taking a snapshot copies the list of chunks, beyond
+		 *	that only the chunks of the page table and the pages being modified.
+		 */
 		void write(size_t offset, void* buffer, size_t size);
 
+		/*!
+		 *	\brief Access the current content of the file
+		 *	\returns a snapshot unaffected by later writes
+		 *
+		 *	Taking a snapshot does not copy any content. Holding it does not
+		 *	block writers, they copy only the pages they modify.
+		 */
+		std::shared_ptr<const MemoryFileSnapshot> snapshot() const;
+
 	public: // Properties
 
 		//! \returns the path of the file relative to the mount point
 		const path& relativePath() const { return _relPath; }
 
+		//! \returns the size of the content in bytes
+		size_t size() const;
+
+		//! \returns the size of a single page of the file
+		size_t pageSize() const { return _arena->pageSize(); }
+
+		//! \returns the number of pages allocated for the file
+		size_t nrPages() const;
+
+	private:
+		//! \returns chunk 'idx' of the current page table, copied if it is shared
+		MemoryFileSnapshot::PageChunk* writableChunk(size_t idx);
+
+		//! \returns page 'idx' of the current content, copied if it is shared
+		std::byte* writablePage(size_t idx);
+
 	private:
 		//! Relative path of the memory file
 		path _relPath;
 
-		//! Size of the content
-		size_t _size{ 0 };
+		//! Lock serializing writers and the creation of snapshots, shared by reads
+		mutable std::shared_mutex _mutex;
+
+		//! Allocator owning the pages
+		std::shared_ptr<PageArena> _arena;
+
+		//! Current content. Shared with readers once a snapshot is taken.
+		std::shared_ptr<MemoryFileSnapshot> _content;
 
-		//! List of memory blobs making the memory file
-		std::vector<std::unique_ptr<MemoryPage>> _pages;
+		//! True if '_content' was handed out as snapshot and must not be modified anymore
+		mutable bool _shared{ false };
 	};
 }}}
@@ -0,0 +1,175 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "pack.h"
+
+// C++ standard library
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// VCL File System Library
+#include "archive.h"
+#include "hash.h"
+
+// zlib
+#include <ZipLib/extlibs/zlib/zlib.h>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	namespace
+	{
+		//! Identifier at the start of every pack
+		const char PackMagic[8] = { 'V', 'C', 'L', 'P', 'A', 'C', 'K', '\0' };
+
+		//! \returns true if the section [offset, offset + size) is aligned and lies within the file
+		bool validSection(uint64_t offset, uint64_t size, uint64_t alignment, uint64_t file_size)
+		{
+			return offset % alignment == 0 && offset <= file_size && size <= file_size - offset;
+		}
+	}
+
+	Pack::Pack(path pack_file)
+	: _file{ std::move(pack_file) }
+	, _mapping{ std::make_shared<const MappedFile>(_file) }
+	{
+		const auto data = _mapping->data();
+		const uint64_t file_size = _mapping->size();
+		if (file_size < PageSize)
+			throw std::runtime_error(_file.string() + " is not a pack.");
+
+		_header = reinterpret_cast<const PackHeader*>(data);
+		if (memcmp(_header->Magic, PackMagic, sizeof(PackMagic)) != 0)
+			throw std::runtime_error(_file.string() + " is not a pack.");
+		if (_header->Version != Version)
+			throw std::runtime_error(_file.string() + " has an unsupported version.");
+
+		// Only the layout of the index is checked, entries and blocks are validated when they are used
+		const auto& header = *_header;
+		const bool valid =
+			header.BlockSize > 0 && (header.BlockSize & (header.BlockSize - 1)) == 0 &&
+			header.TableSize >= 2 * header.NrEntries && (header.TableSize & (header.TableSize - 1)) == 0 &&
+			header.NrEntries < EmptySlot && header.TableSize <= file_size && header.NrBlocks < file_size &&
+			validSection(header.EntriesOffset, header.NrEntries * sizeof(PackEntry), alignof(PackEntry), file_size) &&
+			validSection(header.TableOffset, header.TableSize * sizeof(uint32_t), alignof(uint32_t), file_size) &&
+			validSection(header.BlocksOffset, (header.NrBlocks + 1) * sizeof(uint64_t), alignof(uint64_t), file_size) &&
+			validSection(header.NamesOffset, header.NamesSize, 1, file_size) &&
+			validSection(header.DataOffset, 0, PageSize, file_size);
+		if (!valid)
+			throw std::runtime_error(_file.string() + " has a corrupt index.");
+
+		_entries = reinterpret_cast<const PackEntry*>(data + header.EntriesOffset);
+		_table = reinterpret_cast<const uint32_t*>(data + header.TableOffset);
+		_blocks = reinterpret_cast<const uint64_t*>(data + header.BlocksOffset);
+		_names = reinterpret_cast<const char*>(data + header.NamesOffset);
+		_data = data + header.DataOffset;
+	}
+
+	size_t Pack::findPath(const path& entry) const
+	{
+		// Directories are stored without trailing separator
+		auto name = Archive::toEntryName(entry);
+		while (!name.empty() && name.back() == '/')
+			name.pop_back();
+		if (name.empty())
+			return npos;
+
+		return findEntry(name);
+	}
+
+	size_t Pack::findEntry(std::string_view name) const
+	{
+		const uint32_t hash = hashName(name);
+		const size_t mask = static_cast<size_t>(_header->TableSize - 1);
+		for (size_t slot = hash & mask, probes = 0; _table[slot] != EmptySlot && probes <= mask; slot = (slot + 1) & mask, probes++)
+		{
+			const size_t idx = _table[slot];
+			if (idx >= nrEntries())
+				throw std::runtime_error(_file.string() + " has a corrupt index.");
+			if (_entries[idx].Hash == hash && entryName(idx) == name)
+				return idx;
+		}
+
+		return npos;
+	}
+
+	std::string_view Pack::entryName(size_t idx) const
+	{
+		const auto& entry = _entries[idx];
+		if (static_cast<uint64_t>(entry.NameOffset) + entry.NameLength > _header->NamesSize)
+			throw std::runtime_error(_file.string() + " has a corrupt entry name.");
+
+		return std::string_view{ _names + entry.NameOffset, entry.NameLength };
+	}
+
+	uint64_t Pack::nrBlocks(size_t idx) const
+	{
+		const uint64_t size = _entries[idx].Size;
+		return size / blockSize() + (size % blockSize() != 0 ? 1 : 0);
+	}
+
+	const std::byte* Pack::blockData(size_t idx, uint64_t block, uint64_t& compressed_size, uint64_t& size) const
+	{
+		const auto& entry = _entries[idx];
+		const uint64_t nr_blocks = nrBlocks(idx);
+		if (block >= nr_blocks || nr_blocks > _header->NrBlocks || entry.FirstBlock > _header->NrBlocks - nr_blocks)
+			throw std::runtime_error(_file.string() + " has a corrupt entry.");
+
+		const uint64_t begin = _blocks[entry.FirstBlock + block];
+		const uint64_t end = _blocks[entry.FirstBlock + block + 1];
+		if (begin > end || end > _mapping->size() - _header->DataOffset)
+			throw std::runtime_error(_file.string() + " has a corrupt block.");
+
+		compressed_size = end - begin;
+		size = std::min<uint64_t>(blockSize(), entry.Size - block * blockSize());
+		return _data + begin;
+	}
+
+	uint64_t Pack::readBlock(size_t idx, uint64_t block, void* buffer) const
+	{
+		uint64_t compressed_size, size;
+		const auto data = blockData(idx, block, compressed_size, size);
+
+		// Blocks which do not shrink are stored as they are
+		if (compressed_size == size)
+		{
+			memcpy(buffer, data, size);
+			return size;
+		}
+
+		uLongf decoded_size = static_cast<uLongf>(size);
+		const int ret = uncompress(static_cast<Bytef*>(buffer), &decoded_size, reinterpret_cast<const Bytef*>(data), static_cast<uLong>(compressed_size));
+		if (ret != Z_OK || decoded_size != size)
+			throw std::runtime_error(_file.string() + " has a corrupt block.");
+
+		return size;
+	}
+
+	const std::byte* Pack::storedBlock(size_t idx, uint64_t block) const
+	{
+		uint64_t compressed_size, size;
+		const auto data = blockData(idx, block, compressed_size, size);
+		return compressed_size == size ? data : nullptr;
+	}
+}}}
@@ -0,0 +1,241 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ Standard Library
+#include <cstddef>
+#include <cstdint>
+#include <experimental/filesystem>
+#include <memory>
+#include <string_view>
+
+// VCL File System Library
+#include "mappedfile.h"
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	/*!
+	 *	\brief Header at the start of a pack file
+	 *
+	 *	The header occupies the first page of the file. All offsets are relative
+	 *	to the start of the file. Values are stored in little-endian byte order
+	 *	and are read directly from the mapping, which requires a little-endian host.
+	 */
+	struct PackHeader
+	{
+		//! Identifies the file as pack, "VCLPACK" followed by a zero
+		char Magic[8];
+
+		//! Version of the format
+		uint32_t Version;
+
+		//! Uncompressed size of the blocks, only the last block of a file may be smaller
+		uint32_t BlockSize;
+
+		//! Number of entries
+		uint64_t NrEntries;
+
+		//! Number of blocks of all the entries
+		uint64_t NrBlocks;
+
+		//! Number of slots of the hash table, a power of two
+		uint64_t TableSize;
+
+		//! Offset of the array of entries
+		uint64_t EntriesOffset;
+
+		//! Offset of the hash table of entry indices
+		uint64_t TableOffset;
+
+		//! Offset of the block offsets, 'NrBlocks' + 1 values relative to 'DataOffset'
+		uint64_t BlocksOffset;
+
+		//! Offset of the entry names
+		uint64_t NamesOffset;
+
+		//! Number of bytes of the entry names
+		uint64_t NamesSize;
+
+		//! Offset of the compressed blocks
+		uint64_t DataOffset;
+	};
+	static_assert(sizeof(PackHeader) == 88, "Pack header must not contain padding");
+
+	//! File or directory stored in a pack
+	struct PackEntry
+	{
+		//! Flag marking directories
+		static const uint16_t Directory = 0x1;
+
+		//! Size of the uncompressed data
+		uint64_t Size;
+
+		//! Index of the first block of the data, entries with identical content share their blocks
+		uint64_t FirstBlock;
+
+		//! Offset of the name relative to the start of the names
+		uint32_t NameOffset;
+
+		//! Hash of the name
+		uint32_t Hash;
+
+		//! Length of the name
+		uint16_t NameLength;
+
+		//! Properties of the entry
+		uint16_t Flags;
+
+		//! Unused, always zero
+		uint32_t Reserved;
+	};
+	static_assert(sizeof(PackEntry) == 32, "Pack entry must not contain padding");
+
+	/*!
+	 *	\brief Memory mapped pack file
+	 *
+	 *	Packs store files in fixed-size blocks which are compressed independently
+	 *	with zlib. Blocks which do not shrink are stored uncompressed. The index
+	 *	consists of an array of entries, an open addressing hash table of entry
+	 *	indices built with the pack, and the offsets of all blocks. The index is
+	 *	used directly from the mapping, thus opening a pack only validates the
+	 *	header. Looking up an entry or the block containing a position has
+	 *	constant cost, and blocks can be decoded in any order and in parallel.
+	 *
+	 *	Files with identical content refer to the same blocks, their content is
+	 *	only stored once.
+	 *
+	 *	Entry names are relative to the root of the pack and use '/' as separator.
+	 *	Directories are stored as entries without data and without trailing '/'.
+	 */
+	class Pack
+	{
+	protected:
+		using path = std::experimental::filesystem::path;
+
+	public:
+		//! Index returned by 'findEntry' if an entry does not exist
+		static const size_t npos = ~size_t(0);
+
+		//! Current version of the format
+		static const uint32_t Version = 1;
+
+		//! Alignment of the header and the sections of the file
+		static const uint64_t PageSize = 4096;
+
+		//! Marker of empty slots in the hash table
+		static const uint32_t EmptySlot = ~uint32_t(0);
+
+		Pack(path pack_file);
+
+		/*!
+		 *	\brief Search an entry of the pack
+		 *	\param name Name of the entry relative to the pack, using '/' as separator
+		 *	\returns the index of the entry, 'npos' if the entry does not exist
+		 */
+		size_t findEntry(std::string_view name) const;
+
+		/*!
+		 *	\brief Search an entry of the pack
+		 *	\param entry Path of the entry relative to the pack
+		 *	\returns the index of the entry, 'npos' if the entry does not exist
+		 */
+		size_t findPath(const path& entry) const;
+
+		//! \returns the properties of the entry 'idx'
+		const PackEntry& entry(size_t idx) const { return _entries[idx]; }
+
+		//! \returns the name of the entry 'idx'
+		std::string_view entryName(size_t idx) const;
+
+		//! \returns true if the entry 'idx' is a directory
+		bool isDirectory(size_t idx) const { return (_entries[idx].Flags & PackEntry::Directory) != 0; }
+
+		//! \returns the number of blocks of the entry 'idx'
+		uint64_t nrBlocks(size_t idx) const;
+
+		/*!
+		 *	\brief Decode a block of an entry
+		 *	\param idx Index of the entry
+		 *	\param block Index of the block within the entry
+		 *	\param buffer Buffer receiving the uncompressed block, at least 'blockSize' bytes
+		 *	\returns the number of uncompressed bytes of the block
+		 */
+		uint64_t readBlock(size_t idx, uint64_t block, void* buffer) const;
+
+		/*!
+		 *	\brief Access a block stored without compression
+		 *	\param idx Index of the entry
+		 *	\param block Index of the block within the entry
+		 *	\returns the data of the block in the mapping, nullptr if the block is compressed
+		 */
+		const std::byte* storedBlock(size_t idx, uint64_t block) const;
+
+		//! \returns the pack file mapped into memory
+		std::shared_ptr<const MappedFile> mapping() const { return _mapping; }
+
+	public: // Properties
+
+		//! \returns the path of the pack on the volume
+		const path& filePath() const { return _file; }
+
+		//! \returns the number of entries in the pack
+		size_t nrEntries() const { return static_cast<size_t>(_header->NrEntries); }
+
+		//! \returns the uncompressed size of the blocks
+		uint32_t blockSize() const { return _header->BlockSize; }
+
+	private:
+		//! Locate the compressed data of a block
+		const std::byte* blockData(size_t idx, uint64_t block, uint64_t& compressed_size, uint64_t& size) const;
+
+	private:
+		//! Path to the pack on the volume
+		path _file;
+
+		//! Pack file mapped into memory
+		std::shared_ptr<const MappedFile> _mapping;
+
+		//! Header in the mapping
+		const PackHeader* _header{ nullptr };
+
+		//! Entries in the mapping
+		const PackEntry* _entries{ nullptr };
+
+		//! Hash table in the mapping
+		const uint32_t* _table{ nullptr };
+
+		//! Block offsets in the mapping
+		const uint64_t* _blocks{ nullptr };
+
+		//! Entry names in the mapping
+		const char* _names{ nullptr };
+
+		//! Compressed data in the mapping
+		const std::byte* _data{ nullptr };
+	};
+}}}
@@ -0,0 +1,357 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "packwriter.h"
+
+// C++ standard library
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+// VCL File System Library
+#include "hash.h"
+#include "threadpool.h"
+
+// zlib
+#include <ZipLib/extlibs/zlib/zlib.h>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	namespace
+	{
+		//! Write a plain structure or array
+		void writeData(std::ofstream& stream, const void* data, size_t size)
+		{
+			stream.write(static_cast<const char*>(data), size);
+		}
+
+		//! Pad the stream with zeros up to a multiple of 'alignment'
+		uint64_t align(std::ofstream& stream, uint64_t offset, uint64_t alignment)
+		{
+			const uint64_t aligned = (offset + alignment - 1) / alignment * alignment;
+			const std::vector<char> padding(static_cast<size_t>(aligned - offset), 0);
+			writeData(stream, padding.data(), padding.size());
+			return aligned;
+		}
+
+		//! Compress a block, blocks which do not shrink are stored as they are
+		std::vector<uint8_t> compressBlock(std::vector<uint8_t> input, int level)
+		{
+			if (level == 0)
+				return input;
+
+			std::vector<uint8_t> output(compressBound(static_cast<uLong>(input.size())));
+			uLongf size = static_cast<uLongf>(output.size());
+			if (compress2(output.data(), &size, input.data(), static_cast<uLong>(input.size()), level) != Z_OK)
+				throw std::runtime_error("Unable to compress data.");
+			if (size >= input.size())
+				return input;
+
+			output.resize(size);
+			return output;
+		}
+
+		//! \returns the CRC-32 of 'size' bytes
+		uint32_t checksum(const uint8_t* data, uint64_t size)
+		{
+			uLong crc = crc32(0, Z_NULL, 0);
+			for (uint64_t pos = 0; pos < size; pos += 1 << 30)
+				crc = crc32(crc, data + pos, static_cast<uInt>(std::min<uint64_t>(1 << 30, size - pos)));
+
+			return static_cast<uint32_t>(crc);
+		}
+	}
+
+	PackWriter::PackWriter(path pack_file, unsigned int nr_workers, uint32_t block_size, int level)
+	: _file{ std::move(pack_file) }
+	, _blockSize{ block_size }
+	, _level{ level }
+	{
+		if (level < -1 || level > 9)
+			throw std::invalid_argument("Compression level must be between -1 and 9.");
+		if (block_size < 4096 || block_size > (16 << 20) || (block_size & (block_size - 1)) != 0)
+			throw std::invalid_argument("Block size must be a power of two between 4 KiB and 16 MiB.");
+
+		_stream.open(_file.string(), std::ios::binary | std::ios::trunc);
+		if (!_stream.is_open())
+			throw std::runtime_error(_file.string() + " could not be created.");
+
+		// The header is written last, the data starts on the second page
+		const std::vector<char> header_page(Pack::PageSize, 0);
+		writeData(_stream, header_page.data(), header_page.size());
+
+		const unsigned int nr_threads = nr_workers > 0 ? nr_workers : std::max(1u, std::thread::hardware_concurrency());
+		_workers = std::make_unique<ThreadPool>(nr_threads, 2 * nr_threads);
+	}
+
+	PackWriter::~PackWriter()
+	{
+		try
+		{
+			finalize();
+		}
+		catch (...)
+		{
+			// Errors can only be reported by calling 'finalize' explicitly
+		}
+	}
+
+	void PackWriter::addFile(std::string name, const void* data, uint64_t size)
+	{
+		auto& entry = addEntry(std::move(name), size, 0);
+		entry.FirstBlock = _nrBlocks;
+		if (size == 0)
+			return;
+
+		// Files with the same content share their blocks
+		auto bytes = static_cast<const uint8_t*>(data);
+		const uint32_t crc = checksum(bytes, size);
+		const uint64_t first_block = findContent(bytes, size, crc);
+		if (first_block != Pack::npos)
+		{
+			entry.FirstBlock = first_block;
+			_nrDuplicates++;
+			_duplicateSize += size;
+			return;
+		}
+		_contents.emplace(std::make_pair(size, crc), _nrBlocks);
+
+		for (uint64_t pos = 0; pos < size; pos += _blockSize)
+		{
+			const uint64_t block = _nrBlocks++;
+			std::vector<uint8_t> input(bytes + pos, bytes + pos + std::min<uint64_t>(_blockSize, size - pos));
+
+			const int level = _level;
+			_workers->enqueue([this, block, level, input = std::move(input)]() mutable
+			{
+				std::vector<uint8_t> output;
+				try
+				{
+					output = compressBlock(std::move(input), level);
+				}
+				catch (...)
+				{
+					setError(std::current_exception());
+				}
+
+				complete(block, std::move(output));
+			});
+		}
+	}
+
+	void PackWriter::addDirectory(std::string name)
+	{
+		auto& entry = addEntry(std::move(name), 0, PackEntry::Directory);
+		entry.FirstBlock = _nrBlocks;
+	}
+
+	void PackWriter::finalize()
+	{
+		if (_finalized)
+			return;
+		_finalized = true;
+
+		std::exception_ptr error;
+		{
+			std::unique_lock<std::mutex> lock{ _blockMutex };
+			_blockWritten.wait(lock, [this]() { return _nextBlock == _nrBlocks; });
+			error = _error;
+		}
+
+		// Failed packs are left without header
+		if (!error)
+		{
+			try
+			{
+				writeIndex();
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+		}
+		_stream.close();
+
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	PackEntry& PackWriter::addEntry(std::string name, uint64_t size, uint16_t flags)
+	{
+		if (_finalized)
+			throw std::logic_error(_file.string() + " is already finalized.");
+		if (name.empty() || name.size() > 0xffff || name.front() == '/' || name.back() == '/')
+			throw std::invalid_argument("Invalid entry name '" + name + "'.");
+		if (_entries.size() + 1 >= Pack::EmptySlot || _names.size() + name.size() > 0xffffffff)
+			throw std::runtime_error(_file.string() + " has too many entries.");
+		if (!_usedNames.insert(name).second)
+			throw std::invalid_argument("Entry '" + name + "' already exists.");
+
+		PackEntry entry{};
+		entry.Size = size;
+		entry.NameOffset = static_cast<uint32_t>(_names.size());
+		entry.Hash = hashName(name);
+		entry.NameLength = static_cast<uint16_t>(name.size());
+		entry.Flags = flags;
+		_names += name;
+
+		_entries.push_back(entry);
+		return _entries.back();
+	}
+
+	uint64_t PackWriter::findContent(const uint8_t* data, uint64_t size, uint32_t crc)
+	{
+		const auto candidates = _contents.equal_range(std::make_pair(size, crc));
+		for (auto content_it = candidates.first; content_it != candidates.second; ++content_it)
+		{
+			if (equalContent(content_it->second, data, size))
+				return content_it->second;
+		}
+
+		return Pack::npos;
+	}
+
+	bool PackWriter::equalContent(uint64_t first_block, const uint8_t* data, uint64_t size)
+	{
+		const uint64_t nr_blocks = (size + _blockSize - 1) / _blockSize;
+
+		std::vector<uint64_t> offsets;
+		{
+			std::unique_lock<std::mutex> lock{ _blockMutex };
+			_blockWritten.wait(lock, [&]() { return _nextBlock >= first_block + nr_blocks; });
+
+			// Blocks which failed to compress were not written
+			if (_error)
+				return false;
+
+			offsets.assign(_blockOffsets.begin() + first_block, _blockOffsets.begin() + first_block + nr_blocks);
+			offsets.push_back(first_block + nr_blocks < _blockOffsets.size() ? _blockOffsets[first_block + nr_blocks] : _dataSize);
+			_stream.flush();
+		}
+
+		std::ifstream input{ _file.string(), std::ios::binary };
+		std::vector<uint8_t> stored;
+		std::vector<uint8_t> block(_blockSize);
+		for (uint64_t b = 0; b < nr_blocks; b++)
+		{
+			const uint64_t block_size = std::min<uint64_t>(_blockSize, size - b * _blockSize);
+			stored.resize(static_cast<size_t>(offsets[b + 1] - offsets[b]));
+			input.seekg(Pack::PageSize + offsets[b]);
+			input.read(reinterpret_cast<char*>(stored.data()), stored.size());
+			if (!input)
+				throw std::runtime_error(_file.string() + " could not be read.");
+
+			// Blocks which do not shrink are stored as they are
+			const uint8_t* content = stored.data();
+			if (stored.size() != block_size)
+			{
+				uLongf decoded_size = static_cast<uLongf>(block_size);
+				if (uncompress(block.data(), &decoded_size, stored.data(), static_cast<uLong>(stored.size())) != Z_OK || decoded_size != block_size)
+					throw std::runtime_error(_file.string() + " could not be read.");
+				content = block.data();
+			}
+
+			if (memcmp(content, data + b * _blockSize, static_cast<size_t>(block_size)) != 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	void PackWriter::complete(uint64_t block, std::vector<uint8_t> data)
+	{
+		std::lock_guard<std::mutex> guard{ _blockMutex };
+		_completedBlocks.emplace(block, std::move(data));
+
+		// Blocks are written in order, such that the blocks of a file are consecutive
+		for (auto block_it = _completedBlocks.begin(); block_it != _completedBlocks.end() && block_it->first == _nextBlock; block_it = _completedBlocks.erase(block_it))
+		{
+			_blockOffsets.push_back(_dataSize);
+			writeData(_stream, block_it->second.data(), block_it->second.size());
+			_dataSize += block_it->second.size();
+			_nextBlock++;
+		}
+		_blockWritten.notify_all();
+	}
+
+	void PackWriter::writeIndex()
+	{
+		_blockOffsets.push_back(_dataSize);
+
+		// Hash table with a load factor of at most one half
+		uint64_t table_size = 16;
+		while (table_size < 2 * _entries.size())
+			table_size *= 2;
+		std::vector<uint32_t> table(table_size, Pack::EmptySlot);
+		const uint64_t mask = table_size - 1;
+		for (size_t idx = 0; idx < _entries.size(); idx++)
+		{
+			uint64_t slot = _entries[idx].Hash & mask;
+			while (table[slot] != Pack::EmptySlot)
+				slot = (slot + 1) & mask;
+			table[slot] = static_cast<uint32_t>(idx);
+		}
+
+		// The index starts on a new page behind the data
+		PackHeader header{};
+		memcpy(header.Magic, "VCLPACK", 8);
+		header.Version = Pack::Version;
+		header.BlockSize = _blockSize;
+		header.NrEntries = _entries.size();
+		header.NrBlocks = _nrBlocks;
+		header.TableSize = table_size;
+		header.DataOffset = Pack::PageSize;
+
+		uint64_t offset = align(_stream, header.DataOffset + _dataSize, Pack::PageSize);
+		header.EntriesOffset = offset;
+		writeData(_stream, _entries.data(), _entries.size() * sizeof(PackEntry));
+		offset += _entries.size() * sizeof(PackEntry);
+
+		header.TableOffset = offset;
+		writeData(_stream, table.data(), table.size() * sizeof(uint32_t));
+		offset = align(_stream, offset + table.size() * sizeof(uint32_t), alignof(uint64_t));
+
+		header.BlocksOffset = offset;
+		writeData(_stream, _blockOffsets.data(), _blockOffsets.size() * sizeof(uint64_t));
+		offset += _blockOffsets.size() * sizeof(uint64_t);
+
+		header.NamesOffset = offset;
+		header.NamesSize = _names.size();
+		writeData(_stream, _names.data(), _names.size());
+
+		_stream.seekp(0);
+		writeData(_stream, &header, sizeof(header));
+		_stream.flush();
+		if (!_stream)
+			throw std::runtime_error(_file.string() + " could not be written.");
+	}
+
+	void PackWriter::setError(std::exception_ptr error)
+	{
+		std::lock_guard<std::mutex> guard{ _blockMutex };
+		if (!_error)
+			_error = error;
+	}
+}}}
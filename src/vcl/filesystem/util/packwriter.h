@@ -0,0 +1,205 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <experimental/filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <unordered_set>
+#include <vector>
+
+// VCL File System Library
+#include "pack.h"
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	class ThreadPool;
+
+	/*!
+	 *	\brief Writer creating a new pack
+	 *
+	 *	The data of the files is split into blocks which are compressed in
+	 *	parallel by a pool of workers and written in the order of the files.
+	 *	The index is written behind the data by 'finalize', followed by the
+	 *	header at the start of the file. Files are added from a single thread.
+	 *
+	 *	Content is stored once: a file with the same size and checksum as a
+	 *	file added before is compared with the written blocks of that file.
+	 *	If the content is identical, the new entry refers to the same blocks.
+	 */
+	class PackWriter
+	{
+	protected:
+		using path = std::experimental::filesystem::path;
+
+	public:
+		/*!
+		 *	\brief Create a new pack, replacing an existing file
+		 *	\param pack_file Path of the pack on the volume
+		 *	\param nr_workers Number of threads compressing blocks, 0 uses one per hardware thread
+		 *	\param block_size Uncompressed size of the blocks, a power of two (4 KiB to 16 MiB)
+		 *	\param level zlib compression level (-1 to 9), 0 stores the blocks without compression
+		 */
+		PackWriter(path pack_file, unsigned int nr_workers, uint32_t block_size = 64 << 10, int level = -1);
+		PackWriter(const PackWriter&) = delete;
+
+		//! Finalize the pack if it was not done explicitly. Errors are only reported by 'finalize'.
+		~PackWriter();
+
+		PackWriter& operator=(const PackWriter&) = delete;
+
+		/*!
+		 *	\brief Add a file to the pack
+		 *	\param name Name of the file relative to the pack, using '/' as separator
+		 *	\param data Content of the file
+		 *	\param size Number of bytes of the content
+		 *
+		 *	The content is copied, the call returns once all blocks are queued for compression.
+		 *	Content which was added before is not stored again. Comparing it waits until the
+		 *	blocks of the earlier file are written.
+		 */
+		void addFile(std::string name, const void* data, uint64_t size);
+
+		/*!
+		 *	\brief Add a directory to the pack
+		 *	\param name Name of the directory relative to the pack, without trailing separator
+		 */
+		void addDirectory(std::string name);
+
+		/*!
+		 *	\brief Complete the pack
+		 *
+		 *	Waits for the compression of all blocks and writes the index and the
+		 *	header. Errors of the compression and of writing the pack are reported
+		 *	here. Finalizing the pack twice has no effect.
+		 */
+		void finalize();
+
+	public: // Properties
+
+		//! \returns the path of the pack on the volume
+		const path& filePath() const { return _file; }
+
+		//! \returns the number of entries added so far
+		size_t nrEntries() const { return _entries.size(); }
+
+		//! \returns the number of files sharing the content of an earlier file
+		size_t nrDuplicates() const { return _nrDuplicates; }
+
+		//! \returns the number of uncompressed bytes which were not stored again
+		uint64_t duplicateSize() const { return _duplicateSize; }
+
+	private:
+		//! Register a new entry
+		PackEntry& addEntry(std::string name, uint64_t size, uint16_t flags);
+
+		//! \returns the first block of earlier content equal to 'data', 'Pack::npos' if there is none
+		uint64_t findContent(const uint8_t* data, uint64_t size, uint32_t crc);
+
+		//! Compare content with the blocks starting at 'first_block' once they are written
+		bool equalContent(uint64_t first_block, const uint8_t* data, uint64_t size);
+
+		//! Write a compressed block once all its predecessors are written
+		void complete(uint64_t block, std::vector<uint8_t> data);
+
+		//! Write the index and the header
+		void writeIndex();
+
+		//! Remember the first error of a background task
+		void setError(std::exception_ptr error);
+
+	private:
+		//! Path of the pack on the volume
+		path _file;
+
+		//! Uncompressed size of the blocks
+		uint32_t _blockSize;
+
+		//! Compression level, 0 for stored blocks
+		int _level;
+
+		//! Output stream of the pack
+		std::ofstream _stream;
+
+		//! Entries in the order they were added
+		std::vector<PackEntry> _entries;
+
+		//! Names of all entries
+		std::string _names;
+
+		//! Names already used, to reject duplicates
+		std::unordered_set<std::string> _usedNames;
+
+		//! First blocks of the stored content by size and checksum
+		std::multimap<std::pair<uint64_t, uint32_t>, uint64_t> _contents;
+
+		//! Number of files referring to the content of an earlier file
+		size_t _nrDuplicates{ 0 };
+
+		//! Number of bytes of files referring to the content of an earlier file
+		uint64_t _duplicateSize{ 0 };
+
+		//! Number of blocks queued for compression
+		uint64_t _nrBlocks{ 0 };
+
+		//! Lock protecting the written blocks and the error
+		std::mutex _blockMutex;
+
+		//! Signals that a block was written
+		std::condition_variable _blockWritten;
+
+		//! Index of the next block to be written
+		uint64_t _nextBlock{ 0 };
+
+		//! Compressed blocks waiting for their predecessors
+		std::map<uint64_t, std::vector<uint8_t>> _completedBlocks;
+
+		//! Offsets of the written blocks relative to the start of the data
+		std::vector<uint64_t> _blockOffsets;
+
+		//! Number of bytes of written blocks
+		uint64_t _dataSize{ 0 };
+
+		//! First error of a background task
+		std::exception_ptr _error;
+
+		//! True once the index was written
+		bool _finalized{ false };
+
+		//! Workers compressing the blocks. Destroyed first to complete pending tasks.
+		std::unique_ptr<ThreadPool> _workers;
+	};
+}}}
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "pagearena.h"
+
+// C++ standard library
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+
+#if defined(_WIN32)
+// Windows
+#ifndef NOMINMAX
+#	define NOMINMAX
+#endif
+#include <windows.h>
+#else
+// POSIX
+#include <sys/mman.h>
+#endif
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	PageArena::PageArena(size_t page_size, bool huge_pages)
+	: _pageSize{ page_size }
+	, _hugePages{ huge_pages }
+	{
+		if (page_size < MinPageSize || page_size > MaxPageSize || (page_size & (page_size - 1)) != 0)
+			throw std::invalid_argument("Page size must be a power of two between 4 KiB and 2 MiB.");
+
+		// Slabs are a multiple of the huge page size in order to allow backing them with huge pages
+		_slabSize = std::max<size_t>(16 * page_size, 2 << 20);
+	}
+
+	PageArena::~PageArena()
+	{
+		for (void* slab : _slabs)
+		{
+#if defined(_WIN32)
+			VirtualFree(slab, 0, MEM_RELEASE);
+#else
+			munmap(slab, _slabSize);
+#endif
+		}
+	}
+
+	PageArena::Page* PageArena::allocate()
+	{
+		Page* page = nullptr;
+		{
+			std::lock_guard<std::mutex> guard{ _mutex };
+			if (!_freePages.empty())
+			{
+				page = _freePages.back();
+				_freePages.pop_back();
+			}
+			else
+			{
+				if (_remainingPages == 0)
+					allocateSlab();
+
+				_pages.emplace_back(_nextPage);
+				page = &_pages.back();
+				_nextPage += _pageSize;
+				_remainingPages--;
+			}
+		}
+
+		page->References.store(1, std::memory_order_relaxed);
+		return page;
+	}
+
+	void PageArena::release(Page* page)
+	{
+		// Make the writes of all the owners visible before the page is reused
+		if (page->References.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+
+		std::lock_guard<std::mutex> guard{ _mutex };
+		_freePages.push_back(page);
+	}
+
+	std::shared_ptr<PageArena> PageArena::defaultArena()
+	{
+		static const auto arena = std::make_shared<PageArena>();
+		return arena;
+	}
+
+	size_t PageArena::nrSlabs() const
+	{
+		std::lock_guard<std::mutex> guard{ _mutex };
+		return _slabs.size();
+	}
+
+	size_t PageArena::nrFreePages() const
+	{
+		std::lock_guard<std::mutex> guard{ _mutex };
+		return _freePages.size();
+	}
+
+	void PageArena::allocateSlab()
+	{
+#if defined(_WIN32)
+		void* slab = VirtualAlloc(nullptr, _slabSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		if (!slab)
+			throw std::bad_alloc();
+#else
+		void* slab = mmap(nullptr, _slabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (slab == MAP_FAILED)
+			throw std::bad_alloc();
+
+#	if defined(MADV_HUGEPAGE)
+		if (_hugePages)
+			madvise(slab, _slabSize, MADV_HUGEPAGE);
+#	endif
+#endif
+
+		_slabs.push_back(slab);
+		_nextPage = static_cast<std::byte*>(slab);
+		_remainingPages = _slabSize / _pageSize;
+	}
+}}}
@@ -0,0 +1,149 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	/*!
+	 *	\brief Allocator handing out fixed-size pages from large slabs
+	 *
+	 *	Slabs are requested directly from the operating system and are only
+	 *	returned on destruction. Pages are reference counted, in order to allow
+	 *	sharing them between multiple versions of a file. Released pages are kept
+	 *	in a free list and reused by later allocations. All methods are thread-safe.
+	 */
+	class PageArena
+	{
+	public:
+		//! Descriptor of a single page
+		struct Page
+		{
+			Page(std::byte* memory) : Memory{ memory } {}
+
+			//! Content of the page
+			std::byte* Memory;
+
+			//! Number of owners of the page
+			std::atomic<uint32_t> References{ 0 };
+		};
+
+	public:
+		//! Page size used if nothing else is specified
+		static const size_t DefaultPageSize = 4096;
+
+		//! Smallest supported page size
+		static const size_t MinPageSize = 4096;
+
+		//! Largest supported page size
+		static const size_t MaxPageSize = 2 << 20;
+
+		/*!
+		 *	\brief Create a new arena
+		 *	\param page_size Size of a single page. Power of two between 4 KiB and 2 MiB.
+		 *	\param huge_pages Ask the operating system to back the slabs with huge pages (Linux only)
+		 */
+		PageArena(size_t page_size = DefaultPageSize, bool huge_pages = false);
+		PageArena(const PageArena&) = delete;
+		~PageArena();
+
+		PageArena& operator=(const PageArena&) = delete;
+
+		//! \returns a new page of 'pageSize' bytes with a single reference. The content is undefined.
+		Page* allocate();
+
+		//! Add an owner to 'page'
+		static void retain(Page* page) { page->References.fetch_add(1, std::memory_order_relaxed); }
+
+		//! Remove an owner from 'page'. The page is returned to the arena with the last owner.
+		void release(Page* page);
+
+		/*!
+		 *	\brief Access the arena shared by the whole process
+		 *	\returns an arena with the default page size, created on first use
+		 *
+		 *	Used by memory files created without an arena of their own, such
+		 *	that small standalone files do not each reserve a slab.
+		 */
+		static std::shared_ptr<PageArena> defaultArena();
+
+	public: // Properties
+
+		//! \returns the size of a single page
+		size_t pageSize() const { return _pageSize; }
+
+		//! \returns the size of a single slab
+		size_t slabSize() const { return _slabSize; }
+
+		//! \returns the number of slabs requested from the operating system
+		size_t nrSlabs() const;
+
+		//! \returns the number of pages in the free list
+		size_t nrFreePages() const;
+
+	private:
+		//! Request a new slab from the operating system
+		void allocateSlab();
+
+	private:
+		//! Size of a single page
+		size_t _pageSize;
+
+		//! Size of a single slab
+		size_t _slabSize;
+
+		//! Back the slabs with huge pages
+		bool _hugePages;
+
+		//! Lock protecting the slabs and the free list
+		mutable std::mutex _mutex;
+
+		//! Slabs allocated from the operating system
+		std::vector<void*> _slabs;
+
+		//! Descriptors of all the pages handed out so far
+		std::deque<Page> _pages;
+
+		//! Released pages
+		std::vector<Page*> _freePages;
+
+		//! Next unused page in the current slab
+		std::byte* _nextPage{ nullptr };
+
+		//! Number of unused pages in the current slab
+		size_t _remainingPages{ 0 };
+	};
+}}}
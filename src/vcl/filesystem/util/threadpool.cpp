@@ -0,0 +1,133 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "threadpool.h"
+
+// C++ standard library
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	ThreadPool::ThreadPool(unsigned int nr_threads, size_t max_queued)
+	: _maxQueued{ std::max<size_t>(max_queued, 1) }
+	{
+		nr_threads = std::max(nr_threads, 1u);
+		_threads.reserve(nr_threads);
+		for (unsigned int t = 0; t < nr_threads; t++)
+			_threads.emplace_back([this]() { run(); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard{ _queueMutex };
+			_stop = true;
+		}
+		_tasksAvailable.notify_all();
+
+		for (auto& thread : _threads)
+			thread.join();
+	}
+
+	void ThreadPool::enqueue(std::function<void()> task)
+	{
+		{
+			std::unique_lock<std::mutex> lock{ _queueMutex };
+			_spaceAvailable.wait(lock, [this]() { return _tasks.size() < _maxQueued; });
+			_tasks.emplace_back(std::move(task));
+		}
+		_tasksAvailable.notify_one();
+	}
+
+	void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func)
+	{
+		// Shared with the helper tasks, which may only start after the call returned
+		struct State
+		{
+			std::atomic<size_t> Next{ 0 };
+			size_t Done{ 0 };
+			std::mutex Mutex;
+			std::condition_variable Finished;
+			std::exception_ptr Error;
+		};
+		auto state = std::make_shared<State>();
+
+		// 'func' is only used while items are left, thus before the caller returns
+		auto work = [state, count, &func]()
+		{
+			for (size_t i = state->Next++; i < count; i = state->Next++)
+			{
+				std::exception_ptr error;
+				try
+				{
+					func(i);
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+
+				std::lock_guard<std::mutex> guard{ state->Mutex };
+				if (error && !state->Error)
+					state->Error = error;
+				if (++state->Done == count)
+					state->Finished.notify_all();
+			}
+		};
+
+		const size_t nr_helpers = std::min(_threads.size(), count > 0 ? count - 1 : 0);
+		for (size_t h = 0; h < nr_helpers; h++)
+			enqueue(work);
+		work();
+
+		std::unique_lock<std::mutex> lock{ state->Mutex };
+		state->Finished.wait(lock, [&]() { return state->Done == count; });
+		if (state->Error)
+			std::rethrow_exception(state->Error);
+	}
+
+	void ThreadPool::run()
+	{
+		for (;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock{ _queueMutex };
+				_tasksAvailable.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+
+				// Only stop once all the pending tasks are executed
+				if (_tasks.empty())
+					return;
+
+				task = std::move(_tasks.front());
+				_tasks.pop_front();
+			}
+			_spaceAvailable.notify_one();
+
+			task();
+		}
+	}
+}}}
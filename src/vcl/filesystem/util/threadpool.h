@@ -0,0 +1,113 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ Standard Library
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Vcl { namespace FileSystem { namespace Util
+{
+	/*!
+	 *	\brief Fixed set of worker threads executing queued tasks
+	 *
+	 *	The number of queued tasks is bounded. Enqueuing a task into a full
+	 *	queue blocks the caller until a worker picks up a task. Tasks still
+	 *	queued on destruction are executed before the workers are joined.
+	 */
+	class ThreadPool
+	{
+	public:
+		/*!
+		 *	\brief Start the worker threads
+		 *	\param nr_threads Number of worker threads
+		 *	\param max_queued Maximum number of tasks waiting for execution
+		 */
+		ThreadPool(unsigned int nr_threads, size_t max_queued);
+		ThreadPool(const ThreadPool&) = delete;
+		~ThreadPool();
+
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/*!
+		 *	\brief Queue a new task
+		 *	\param task Function to be executed by one of the workers
+		 */
+		void enqueue(std::function<void()> task);
+
+		/*!
+		 *	\brief Process a range of items in parallel
+		 *	\param count Number of items
+		 *	\param func Function processing a single item
+		 *
+		 *	The calling thread processes items as well, thus the call makes progress
+		 *	even if all workers are busy. Returns once all items are processed.
+		 *	The first exception thrown by 'func' is passed to the caller.
+		 */
+		void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+	public: // Properties
+
+		//! \returns the number of worker threads
+		size_t nrThreads() const { return _threads.size(); }
+
+		//! \returns the maximum number of queued tasks
+		size_t maxQueued() const { return _maxQueued; }
+
+	private:
+		//! Main loop of the worker threads
+		void run();
+
+	private:
+		//! Worker threads
+		std::vector<std::thread> _threads;
+
+		//! Tasks waiting for execution
+		std::deque<std::function<void()>> _tasks;
+
+		//! Maximum number of tasks in the queue
+		size_t _maxQueued;
+
+		//! Lock protecting the queue
+		std::mutex _queueMutex;
+
+		//! Signals that tasks were added to the queue
+		std::condition_variable _tasksAvailable;
+
+		//! Signals that tasks were removed from the queue
+		std::condition_variable _spaceAvailable;
+
+		//! Indicates that the workers should terminate
+		bool _stop{ false };
+	};
+}}}
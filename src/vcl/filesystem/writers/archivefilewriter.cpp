@@ -0,0 +1,72 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "archivefilewriter.h"
+
+// C++ standard library
+#include <stdexcept>
+
+namespace Vcl { namespace FileSystem
+{
+	ArchiveFileWriter::ArchiveFileWriter(path virtual_path, std::shared_ptr<Util::ArchiveWriter> archive, std::string entry_name)
+	: FileWriter(virtual_path)
+	, _archive(std::move(archive))
+	, _entry(_archive->createEntry(std::move(entry_name)))
+	{
+	}
+
+	ArchiveFileWriter::~ArchiveFileWriter()
+	{
+		try
+		{
+			close();
+		}
+		catch (...)
+		{
+			// Errors can only be reported by calling 'close' explicitly
+		}
+	}
+
+	void ArchiveFileWriter::seek(const uint64_t pos)
+	{
+		if (pos != _curr_pos)
+			throw std::logic_error(virtualPath().string() + " can only be written sequentially.");
+	}
+
+	void ArchiveFileWriter::write(void* buf, const uint64_t size)
+	{
+		_archive->write(_entry, buf, size);
+		_curr_pos += size;
+	}
+
+	uint64_t ArchiveFileWriter::pos() const
+	{
+		return _curr_pos;
+	}
+
+	void ArchiveFileWriter::close()
+	{
+		_archive->close(_entry);
+	}
+}}
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <memory>
+#include <string>
+
+// VCL File System Library
+#include "../util/archivewriter.h"
+#include "../filewriter.h"
+
+namespace Vcl { namespace FileSystem
+{
+	/*!
+	 *	\brief Writer streaming a file into a new entry of an archive
+	 *
+	 *	Entries are written sequentially, seeking is only supported to the
+	 *	current position. Closing the writer hands the remaining data to the
+	 *	compression of the archive writer.
+	 */
+	class ArchiveFileWriter : public FileWriter
+	{
+	public:
+		/*!
+		 *	\brief Start a new entry in an archive
+		 *	\param virtual_path path of the file within the virtual file system
+		 *	\param archive archive being written
+		 *	\param entry_name name of the entry relative to the archive
+		 */
+		ArchiveFileWriter(path virtual_path, std::shared_ptr<Util::ArchiveWriter> archive, std::string entry_name);
+		ArchiveFileWriter(const ArchiveFileWriter&) = delete;
+		~ArchiveFileWriter();
+
+		ArchiveFileWriter& operator=(const ArchiveFileWriter&) = delete;
+
+		void     seek(const uint64_t pos) override;
+		void     write(void* buf, const uint64_t size) override;
+
+		uint64_t pos() const override;
+
+		void     close() override;
+
+	private:
+		//! Archive the entry is written to
+		std::shared_ptr<Util::ArchiveWriter> _archive;
+
+		//! Entry being written
+		std::shared_ptr<Util::ArchiveWriter::Entry> _entry;
+
+		//! Current position in the entry
+		uint64_t _curr_pos{ 0 };
+	};
+}}
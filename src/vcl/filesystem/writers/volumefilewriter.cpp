@@ -0,0 +1,213 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "volumefilewriter.h"
+
+// C++ standard library
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+// Windows
+#ifndef NOMINMAX
+#	define NOMINMAX
+#endif
+#include <windows.h>
+#else
+// POSIX
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Vcl { namespace FileSystem
+{
+#if defined(_WIN32)
+	VolumeFileWriter::VolumeFileWriter(path virtual_path, path volume_path, size_t buffer_size)
+	: FileWriter(virtual_path)
+	, _volumePath(std::move(volume_path))
+	, _buffer(new char[buffer_size])
+	, _bufferSize(buffer_size)
+	{
+		HANDLE h = CreateFileW(_volumePath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (h == INVALID_HANDLE_VALUE)
+			throw std::runtime_error(_volumePath.string() + " could not be created.");
+
+		_handle = h;
+	}
+
+	void VolumeFileWriter::reserve(const uint64_t size)
+	{
+		if (!_handle)
+			throw std::logic_error(_volumePath.string() + " is closed.");
+
+		FILE_ALLOCATION_INFO info;
+		info.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+		SetFileInformationByHandle(_handle, FileAllocationInfo, &info, sizeof(info));
+	}
+
+	void VolumeFileWriter::close()
+	{
+		if (!_handle)
+			return;
+
+		flush();
+		CloseHandle(_handle);
+		_handle = nullptr;
+	}
+
+	void VolumeFileWriter::writeAt(uint64_t offset, const void* buf, uint64_t size)
+	{
+		if (!_handle)
+			throw std::logic_error(_volumePath.string() + " is closed.");
+
+		uint64_t written_bytes = 0;
+		while (written_bytes < size)
+		{
+			OVERLAPPED ov = {};
+			ov.Offset = static_cast<DWORD>(offset + written_bytes);
+			ov.OffsetHigh = static_cast<DWORD>((offset + written_bytes) >> 32);
+
+			const DWORD chunk = static_cast<DWORD>(std::min<uint64_t>(size - written_bytes, 1u << 30));
+			DWORD chunk_written = 0;
+			if (!WriteFile(_handle, static_cast<const char*>(buf) + written_bytes, chunk, &chunk_written, &ov))
+				throw std::runtime_error(_volumePath.string() + " could not be written.");
+
+			written_bytes += chunk_written;
+		}
+	}
+#else
+	VolumeFileWriter::VolumeFileWriter(path virtual_path, path volume_path, size_t buffer_size)
+	: FileWriter(virtual_path)
+	, _volumePath(std::move(volume_path))
+	, _buffer(new char[buffer_size])
+	, _bufferSize(buffer_size)
+	{
+		_fd = ::open(_volumePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (_fd < 0)
+			throw std::runtime_error(_volumePath.string() + " could not be created.");
+	}
+
+	void VolumeFileWriter::reserve(const uint64_t size)
+	{
+		if (_fd < 0)
+			throw std::logic_error(_volumePath.string() + " is closed.");
+
+#if defined(__linux__)
+		// Allocate the blocks without changing the size. Failing is not an error,
+		// as not all the file systems support preallocation.
+		::fallocate(_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+#endif
+	}
+
+	void VolumeFileWriter::close()
+	{
+		if (_fd < 0)
+			return;
+
+		flush();
+		::close(_fd);
+		_fd = -1;
+	}
+
+	void VolumeFileWriter::writeAt(uint64_t offset, const void* buf, uint64_t size)
+	{
+		if (_fd < 0)
+			throw std::logic_error(_volumePath.string() + " is closed.");
+
+		uint64_t written_bytes = 0;
+		while (written_bytes < size)
+		{
+			const auto res = ::pwrite(_fd, static_cast<const char*>(buf) + written_bytes, size - written_bytes, static_cast<off_t>(offset + written_bytes));
+			if (res < 0 && errno == EINTR)
+				continue;
+			if (res < 0)
+				throw std::runtime_error(_volumePath.string() + " could not be written.");
+
+			written_bytes += static_cast<uint64_t>(res);
+		}
+	}
+#endif
+
+	VolumeFileWriter::~VolumeFileWriter()
+	{
+		try
+		{
+			close();
+		}
+		catch (...)
+		{
+			// Errors can only be reported by calling 'close' explicitly
+		}
+	}
+
+	void VolumeFileWriter::seek(const uint64_t pos)
+	{
+		_curr_pos = pos;
+	}
+
+	void VolumeFileWriter::write(void* buf, const uint64_t size)
+	{
+		// Start a new buffer if the write does not continue the buffered data
+		if (_bufferFill > 0 && _curr_pos != _bufferPos + _bufferFill)
+			flush();
+
+		if (_bufferFill + size > _bufferSize)
+		{
+			flush();
+
+			// Large writes bypass the buffer
+			if (size >= _bufferSize)
+			{
+				writeAt(_curr_pos, buf, size);
+				_curr_pos += size;
+				return;
+			}
+		}
+
+		if (_bufferFill == 0)
+			_bufferPos = _curr_pos;
+
+		memcpy(_buffer.get() + _bufferFill, buf, size);
+		_bufferFill += size;
+		_curr_pos += size;
+	}
+
+	uint64_t VolumeFileWriter::pos() const
+	{
+		return _curr_pos;
+	}
+
+	void VolumeFileWriter::flush()
+	{
+		if (_bufferFill == 0)
+			return;
+
+		// Reset the buffer before writing, such that a failing write does not repeat
+		const auto fill = _bufferFill;
+		_bufferFill = 0;
+		writeAt(_bufferPos, _buffer.get(), fill);
+	}
+}}
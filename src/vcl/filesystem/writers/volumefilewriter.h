@@ -0,0 +1,100 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <memory>
+
+// VCL File System Library
+#include "../filewriter.h"
+
+namespace Vcl { namespace FileSystem
+{
+	/*!
+	 *	\brief Writer for files on a native volume
+	 *
+	 *	Consecutive writes are collected in a buffer, which is passed to
+	 *	the operating system with a single positional write once it is full,
+	 *	the writer seeks to a different position, or it is flushed.
+	 */
+	class VolumeFileWriter : public FileWriter
+	{
+	public:
+		/*!
+		 *	\brief Create a new file or truncate an existing one
+		 *	\param virtual_path path of the file within the virtual file system
+		 *	\param volume_path path of the file on the volume
+		 *	\param buffer_size size of the buffer combining small writes
+		 */
+		VolumeFileWriter(path virtual_path, path volume_path, size_t buffer_size = 1 << 20);
+		VolumeFileWriter(const VolumeFileWriter&) = delete;
+		~VolumeFileWriter();
+
+		VolumeFileWriter& operator=(const VolumeFileWriter&) = delete;
+
+		void     seek(const uint64_t pos) override;
+		void     write(void* buf, const uint64_t size) override;
+
+		uint64_t pos() const override;
+
+		void     reserve(const uint64_t size) override;
+		void     flush() override;
+		void     close() override;
+
+	private:
+		//! Write data directly to the file at a given position
+		void writeAt(uint64_t offset, const void* buf, uint64_t size);
+
+	private:
+		//! Path of the file on the actual volume
+		path _volumePath;
+
+#if defined(_WIN32)
+		//! Native file handle
+		void* _handle{ nullptr };
+#else
+		//! Native file descriptor
+		int _fd{ -1 };
+#endif
+
+		//! Buffer combining consecutive writes
+		std::unique_ptr<char[]> _buffer;
+
+		//! Capacity of the write buffer
+		size_t _bufferSize{ 0 };
+
+		//! Number of bytes in the write buffer
+		size_t _bufferFill{ 0 };
+
+		//! Position in the file of the first byte in the write buffer
+		uint64_t _bufferPos{ 0 };
+
+		//! Current position in the file
+		uint64_t _curr_pos{ 0 };
+	};
+}}
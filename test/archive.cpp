@@ -0,0 +1,887 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/archivemountpoint.h>
+#include <vcl/filesystem/util/entrycache.h>
+#include <vcl/filesystem/filesystem.h>
+
+// Google test
+#include <gtest/gtest.h>
+
+// zlib
+#include <ZipLib/extlibs/zlib/zlib.h>
+
+namespace
+{
+	//! File stored in a test archive
+	struct TestEntry
+	{
+		std::string Name;
+		std::vector<char> Content;
+		bool Deflate;
+	};
+
+	template<typename T>
+	void writeLE(std::ofstream& file, T value)
+	{
+		for (size_t i = 0; i < sizeof(T); i++)
+			file.put(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+
+	//! \returns the raw deflate stream of 'data'
+	std::vector<char> deflateData(const std::vector<char>& data)
+	{
+		z_stream stream{};
+		deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+
+		std::vector<char> compressed(deflateBound(&stream, static_cast<uLong>(data.size())));
+		stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+		stream.avail_in = static_cast<uInt>(data.size());
+		stream.next_out = reinterpret_cast<Bytef*>(compressed.data());
+		stream.avail_out = static_cast<uInt>(compressed.size());
+		deflate(&stream, Z_FINISH);
+		compressed.resize(stream.total_out);
+		deflateEnd(&stream);
+
+		return compressed;
+	}
+
+	/*!
+	 *	\brief Write a zip archive containing 'entries'
+	 *	\param zip_file Path of the archive
+	 *	\param entries Files of the archive
+	 *	\param zip64 Store the sizes, offsets and the location of the central directory in zip64 records
+	 */
+	void writeTestArchive(const std::experimental::filesystem::path& zip_file, const std::vector<TestEntry>& entries, bool zip64 = false)
+	{
+		std::ofstream file{ zip_file.string(), std::ios::binary };
+
+		struct Record
+		{
+			uint32_t Offset;
+			uint32_t Crc;
+			uint32_t CompressedSize;
+		};
+		std::vector<Record> records;
+
+		for (const auto& entry : entries)
+		{
+			const auto data = entry.Deflate ? deflateData(entry.Content) : entry.Content;
+			const auto crc = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(entry.Content.data()), static_cast<uInt>(entry.Content.size())));
+			records.push_back({ static_cast<uint32_t>(file.tellp()), crc, static_cast<uint32_t>(data.size()) });
+
+			writeLE<uint32_t>(file, 0x04034b50);
+			writeLE<uint16_t>(file, 20);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, entry.Deflate ? 8 : 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, crc);
+			writeLE<uint32_t>(file, static_cast<uint32_t>(data.size()));
+			writeLE<uint32_t>(file, static_cast<uint32_t>(entry.Content.size()));
+			writeLE<uint16_t>(file, static_cast<uint16_t>(entry.Name.size()));
+			writeLE<uint16_t>(file, 0);
+			file.write(entry.Name.data(), entry.Name.size());
+			file.write(data.data(), data.size());
+		}
+
+		const auto dir_offset = static_cast<uint32_t>(file.tellp());
+		for (size_t e = 0; e < entries.size(); e++)
+		{
+			const auto& entry = entries[e];
+			writeLE<uint32_t>(file, 0x02014b50);
+			writeLE<uint16_t>(file, zip64 ? 45 : 20);
+			writeLE<uint16_t>(file, zip64 ? 45 : 20);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, entry.Deflate ? 8 : 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, records[e].Crc);
+			writeLE<uint32_t>(file, zip64 ? 0xffffffff : records[e].CompressedSize);
+			writeLE<uint32_t>(file, zip64 ? 0xffffffff : static_cast<uint32_t>(entry.Content.size()));
+			writeLE<uint16_t>(file, static_cast<uint16_t>(entry.Name.size()));
+			writeLE<uint16_t>(file, zip64 ? 28 : 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint16_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, zip64 ? 0xffffffff : records[e].Offset);
+			file.write(entry.Name.data(), entry.Name.size());
+			if (zip64)
+			{
+				// Zip64 extended information
+				writeLE<uint16_t>(file, 0x0001);
+				writeLE<uint16_t>(file, 24);
+				writeLE<uint64_t>(file, entry.Content.size());
+				writeLE<uint64_t>(file, records[e].CompressedSize);
+				writeLE<uint64_t>(file, records[e].Offset);
+			}
+		}
+		const auto dir_size = static_cast<uint32_t>(file.tellp()) - dir_offset;
+
+		if (zip64)
+		{
+			// Zip64 end of central directory record
+			const auto record_offset = static_cast<uint64_t>(file.tellp());
+			writeLE<uint32_t>(file, 0x06064b50);
+			writeLE<uint64_t>(file, 44);
+			writeLE<uint16_t>(file, 45);
+			writeLE<uint16_t>(file, 45);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint64_t>(file, entries.size());
+			writeLE<uint64_t>(file, entries.size());
+			writeLE<uint64_t>(file, dir_size);
+			writeLE<uint64_t>(file, dir_offset);
+
+			// Zip64 end of central directory locator
+			writeLE<uint32_t>(file, 0x07064b50);
+			writeLE<uint32_t>(file, 0);
+			writeLE<uint64_t>(file, record_offset);
+			writeLE<uint32_t>(file, 1);
+		}
+
+		writeLE<uint32_t>(file, 0x06054b50);
+		writeLE<uint16_t>(file, 0);
+		writeLE<uint16_t>(file, 0);
+		writeLE<uint16_t>(file, zip64 ? 0xffff : static_cast<uint16_t>(entries.size()));
+		writeLE<uint16_t>(file, zip64 ? 0xffff : static_cast<uint16_t>(entries.size()));
+		writeLE<uint32_t>(file, zip64 ? 0xffffffff : dir_size);
+		writeLE<uint32_t>(file, zip64 ? 0xffffffff : dir_offset);
+		writeLE<uint16_t>(file, 0);
+	}
+
+	//! \returns compressible content of 'size' bytes
+	std::vector<char> makeContent(size_t size, unsigned int seed)
+	{
+		const char* words[] = { "shader ", "texture ", "mesh ", "audio ", "level ", "script ", "\n" };
+
+		std::mt19937 rnd{ seed };
+		std::vector<char> content;
+		content.reserve(size + 16);
+		while (content.size() < size)
+		{
+			const char* word = words[rnd() % 7];
+			content.insert(content.end(), word, word + strlen(word));
+			content.push_back(static_cast<char>('0' + rnd() % 10));
+		}
+		content.resize(size);
+
+		return content;
+	}
+}
+
+class ArchiveReaderTest : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		large = makeContent(8 << 20, 1);
+		small = makeContent(1000, 2);
+		std::vector<TestEntry> entries =
+		{
+			{ "large.txt", large, true },
+			{ "small.txt", small, true },
+			{ "stored.txt", small, false },
+			{ "assets/", {}, false },
+		};
+		for (unsigned int i = 0; i < 32; i++)
+			entries.push_back({ "assets/asset" + std::to_string(i) + ".txt", makeContent(10000 + 1000 * i, 10 + i), true });
+
+		writeTestArchive(zip_file, entries);
+	}
+
+	void TearDown() override
+	{
+		std::experimental::filesystem::remove(zip_file);
+	}
+
+	const std::experimental::filesystem::path zip_file{ "ReaderContent.zip" };
+
+	std::vector<char> large;
+	std::vector<char> small;
+};
+
+TEST(EntryCacheTest, HitsAndEviction)
+{
+	using namespace Vcl::FileSystem::Util;
+
+	EntryCache cache{ 1000, 500 };
+
+	int loads = 0;
+	auto loader = [&loads](size_t size)
+	{
+		return [&loads, size]()
+		{
+			loads++;
+			return std::vector<std::byte>(size, std::byte{ 1 });
+		};
+	};
+
+	EXPECT_EQ(cache.get(0, loader(400))->size(), 400u);
+	EXPECT_EQ(cache.get(0, loader(400))->size(), 400u);
+	EXPECT_EQ(loads, 1);
+	EXPECT_EQ(cache.hits(), 1u);
+	EXPECT_EQ(cache.misses(), 1u);
+
+	// Entry 0 was used more recently than entry 1, thus entry 1 is evicted first
+	cache.get(1, loader(400));
+	cache.get(0, loader(400));
+	auto evicted = cache.get(2, loader(400));
+	EXPECT_EQ(cache.size(), 800u);
+	EXPECT_EQ(loads, 3);
+
+	cache.get(0, loader(400));
+	EXPECT_EQ(loads, 3);
+	cache.get(1, loader(400));
+	EXPECT_EQ(loads, 4);
+
+	// Entries exceeding the maximum entry size are not kept
+	cache.get(3, loader(600));
+	cache.get(3, loader(600));
+	EXPECT_EQ(loads, 6);
+	EXPECT_LE(cache.size(), 1000u);
+
+	cache.clear();
+	EXPECT_EQ(cache.size(), 0u);
+	EXPECT_EQ(evicted->size(), 400u);
+}
+
+TEST(EntryCacheTest, FailedLoad)
+{
+	using namespace Vcl::FileSystem::Util;
+
+	EntryCache cache{ 1000, 1000 };
+	EXPECT_THROW(cache.get(0, []() -> std::vector<std::byte> { throw std::runtime_error("Failed"); }), std::runtime_error);
+	EXPECT_EQ(cache.get(0, []() { return std::vector<std::byte>(10); })->size(), 10u);
+	EXPECT_EQ(cache.misses(), 2u);
+}
+
+TEST(EntryCacheTest, SingleLoad)
+{
+	using namespace Vcl::FileSystem::Util;
+
+	EntryCache cache{ 1 << 20, 1 << 20 };
+
+	std::atomic<int> loads{ 0 };
+	std::atomic<int> errors{ 0 };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 16; t++)
+	{
+		threads.emplace_back([&]()
+		{
+			auto content = cache.get(42, [&loads]()
+			{
+				loads++;
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				return std::vector<std::byte>(1000, std::byte{ 7 });
+			});
+
+			if (content->size() != 1000 || (*content)[999] != std::byte{ 7 })
+				errors++;
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(loads, 1);
+	EXPECT_EQ(errors, 0);
+	EXPECT_EQ(cache.hits() + cache.misses(), 16u);
+}
+
+TEST_F(ArchiveReaderTest, ReadCachedArchiveFile)
+{
+	using namespace Vcl::FileSystem;
+
+	auto mount = std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, ArchiveOptions{ 1 << 20 });
+	auto archive = mount.get();
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount));
+
+	for (int i = 0; i < 3; i++)
+	{
+		auto reader = fs.createReader("/content/small.txt");
+
+		std::vector<char> content(2000);
+		EXPECT_EQ(reader->read(content.data(), content.size()), small.size());
+		EXPECT_TRUE(std::equal(small.begin(), small.end(), content.begin()));
+	}
+
+	EXPECT_EQ(archive->cache()->misses(), 1u);
+	EXPECT_EQ(archive->cache()->hits(), 2u);
+}
+
+TEST_F(ArchiveReaderTest, SeekDeflatedEntry)
+{
+	using namespace Vcl::FileSystem;
+
+	ArchiveOptions options;
+	options.SeekIndexSpan = 256 << 10;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options));
+
+	auto reader = fs.createReader("/content/large.txt");
+	ASSERT_EQ(reader->size(), large.size());
+
+	// Jump back and forth through the entry
+	std::mt19937 rnd{ 42 };
+	std::vector<char> buffer(5000);
+	for (int i = 0; i < 200; i++)
+	{
+		const size_t offset = rnd() % large.size();
+		const size_t expected = std::min(buffer.size(), large.size() - offset);
+
+		reader->seek(offset);
+		ASSERT_EQ(reader->read(buffer.data(), buffer.size()), expected) << "Offset " << offset;
+		EXPECT_TRUE(std::equal(buffer.begin(), buffer.begin() + expected, large.begin() + offset)) << "Offset " << offset;
+		EXPECT_EQ(reader->pos(), offset + expected);
+	}
+
+	// Sequential reading continues without seeking
+	reader->seek(0);
+	std::vector<char> content(large.size());
+	for (size_t pos = 0; pos < content.size(); pos += 100000)
+		reader->read(content.data() + pos, std::min<size_t>(100000, content.size() - pos));
+	EXPECT_TRUE(reader->eof());
+	EXPECT_TRUE(content == large);
+
+	// Entries smaller than the span do not need an index
+	auto small_reader = fs.createReader("/content/small.txt");
+	std::vector<char> small_content(small.size());
+	EXPECT_EQ(small_reader->readAt(500, small_content.data(), small_content.size()), 500u);
+	EXPECT_TRUE(std::equal(small_content.begin(), small_content.begin() + 500, small.begin() + 500));
+}
+
+TEST_F(ArchiveReaderTest, ConcurrentDeflatedReads)
+{
+	using namespace Vcl::FileSystem;
+
+	ArchiveOptions options;
+	options.SeekIndexSpan = 256 << 10;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options));
+
+	auto reader = fs.createReader("/content/large.txt");
+
+	std::atomic<int> errors{ 0 };
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < 8; t++)
+	{
+		threads.emplace_back([this, &reader, &errors, t]()
+		{
+			std::mt19937 rnd{ t };
+			std::vector<char> buffer(4096);
+			for (int i = 0; i < 50; i++)
+			{
+				const size_t offset = rnd() % large.size();
+				const size_t expected = std::min(buffer.size(), large.size() - offset);
+				if (reader->readAt(offset, buffer.data(), buffer.size()) != expected ||
+					!std::equal(buffer.begin(), buffer.begin() + expected, large.begin() + offset))
+					errors++;
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(errors, 0);
+}
+
+TEST_F(ArchiveReaderTest, ConcurrentSeekIndexBuild)
+{
+	using namespace Vcl::FileSystem;
+
+	ArchiveOptions options;
+	options.SeekIndexSpan = 256 << 10;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options));
+
+	// All threads open the entry at once, one builds the seek index while the others wait for it
+	std::atomic<bool> start{ false };
+	std::atomic<int> errors{ 0 };
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([this, &fs, &start, &errors, t]()
+		{
+			while (!start)
+				std::this_thread::yield();
+
+			auto reader = fs.createReader("/content/large.txt");
+			std::mt19937 rnd{ t };
+			std::vector<char> buffer(4096);
+			for (int i = 0; i < 20; i++)
+			{
+				const size_t offset = rnd() % large.size();
+				const size_t expected = std::min(buffer.size(), large.size() - offset);
+				if (reader->readAt(offset, buffer.data(), buffer.size()) != expected ||
+					!std::equal(buffer.begin(), buffer.begin() + expected, large.begin() + offset))
+					errors++;
+			}
+		});
+	}
+	start = true;
+
+	for (auto& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(errors, 0);
+}
+
+TEST_F(ArchiveReaderTest, ReadStoredEntry)
+{
+	using namespace Vcl::FileSystem;
+
+	ArchiveOptions options;
+	options.CacheBudget = 1 << 20;
+
+	auto mount_point = std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options);
+	const auto* cache = mount_point->cache();
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount_point));
+
+	auto reader = fs.createReader("/content/stored.txt");
+	ASSERT_EQ(reader->size(), small.size());
+
+	std::vector<char> content(small.size());
+	reader->seek(100);
+	EXPECT_EQ(reader->read(content.data(), content.size()), small.size() - 100);
+	EXPECT_TRUE(std::equal(content.begin(), content.end() - 100, small.begin() + 100));
+	EXPECT_TRUE(reader->eof());
+
+	// Views of stored entries point into the mapped archive and are not cached
+	auto view = reader->view(10, 2000);
+	ASSERT_EQ(view.size(), small.size() - 10);
+	EXPECT_TRUE(std::equal(view.begin(), view.end(), reinterpret_cast<const std::byte*>(small.data()) + 10));
+	EXPECT_EQ(fs.createReader("/content/stored.txt")->view(10, 1).data(), view.data());
+	EXPECT_EQ(cache->misses(), 0u);
+}
+
+TEST(ArchiveZip64Test, MountZip64Archive)
+{
+	using namespace Vcl::FileSystem;
+
+	const std::experimental::filesystem::path zip_file{ "Zip64Content.zip" };
+	const auto deflated = makeContent(300000, 3);
+	const auto stored = makeContent(5000, 4);
+	writeTestArchive(zip_file, { { "data/", {}, false }, { "data/deflated.txt", deflated, true }, { "data/stored.txt", stored, false } }, true);
+
+	{
+		Util::Archive archive{ zip_file };
+		ASSERT_EQ(archive.nrEntries(), 3u);
+		EXPECT_TRUE(archive.isDirectory(archive.findEntry("data/")));
+		EXPECT_EQ(archive.entry(archive.findEntry("data/stored.txt")).Size, stored.size());
+		EXPECT_EQ(archive.entry(archive.findEntry("data/stored.txt")).CompressedSize, stored.size());
+		EXPECT_GT(archive.entry(archive.findEntry("data/stored.txt")).HeaderOffset, deflated.size() / 10);
+
+		FileSystem fs;
+		fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file));
+
+		auto readAll = [&fs](const char* file_name)
+		{
+			auto reader = fs.createReader(file_name);
+			std::vector<char> content(reader->size());
+			content.resize(reader->read(content.data(), content.size()));
+			return content;
+		};
+		EXPECT_EQ(fs.stat("/content/data/deflated.txt").Size, deflated.size());
+		EXPECT_TRUE(readAll("/content/data/deflated.txt") == deflated);
+		EXPECT_TRUE(readAll("/content/data/stored.txt") == stored);
+	}
+
+	std::experimental::filesystem::remove(zip_file);
+}
+
+TEST_F(ArchiveReaderTest, ReadDeflatedEntry)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file));
+
+	// Whole entries are decoded in one pass
+	auto reader = fs.createReader("/content/large.txt");
+	std::vector<char> content(large.size() + 100);
+	EXPECT_EQ(reader->readAt(0, content.data(), content.size()), large.size());
+	EXPECT_TRUE(std::equal(large.begin(), large.end(), content.begin()));
+
+	EXPECT_EQ(reader->read(content.data(), content.size()), large.size());
+	EXPECT_TRUE(reader->eof());
+	EXPECT_TRUE(std::equal(large.begin(), large.end(), content.begin()));
+
+	// Partial reads continue the stream, seeking back restarts it without an index
+	reader->seek(0);
+	std::fill(content.begin(), content.end(), 0);
+	EXPECT_EQ(reader->read(content.data(), 1000), 1000u);
+	EXPECT_EQ(reader->read(content.data() + 1000, large.size()), large.size() - 1000);
+	EXPECT_TRUE(std::equal(large.begin(), large.end(), content.begin()));
+
+	reader->seek(10);
+	EXPECT_EQ(reader->read(content.data(), 10), 10u);
+	EXPECT_TRUE(std::equal(large.begin() + 10, large.begin() + 20, content.begin()));
+}
+
+TEST_F(ArchiveReaderTest, LoadFileBatch)
+{
+	using namespace Vcl::FileSystem;
+
+	ArchiveOptions options;
+	options.NrWorkers = 4;
+
+	std::vector<std::experimental::filesystem::path> files = { "/content/large.txt", "/content/missing.txt", "/content/stored.txt", "/content/assets/" };
+	for (unsigned int i = 0; i < 32; i++)
+		files.push_back("/content/assets/asset" + std::to_string(i) + ".txt");
+
+	for (size_t budget : { 0, 1 << 20 })
+	{
+		options.CacheBudget = budget;
+		ArchiveMountPoint mp{ "Content", "/content", zip_file, options };
+
+		auto loaded = mp.loadFiles(files);
+		ASSERT_EQ(loaded.size(), files.size());
+
+		auto equals = [](const LoadedFile& file, const std::vector<char>& content)
+		{
+			return file.Data.size() == content.size() && memcmp(file.Data.data(), content.data(), content.size()) == 0;
+		};
+		EXPECT_EQ(loaded[0].Error, 0);
+		EXPECT_TRUE(equals(loaded[0], large));
+		EXPECT_EQ(loaded[1].Error, ENOENT);
+		EXPECT_TRUE(equals(loaded[2], small));
+		EXPECT_EQ(loaded[3].Error, EISDIR);
+		for (unsigned int i = 0; i < 32; i++)
+		{
+			EXPECT_EQ(loaded[4 + i].Error, 0);
+			EXPECT_TRUE(equals(loaded[4 + i], makeContent(10000 + 1000 * i, 10 + i))) << "Asset " << i;
+		}
+	}
+}
+
+TEST_F(ArchiveReaderTest, PrefetchEntries)
+{
+	using namespace Vcl::FileSystem;
+
+	ArchiveOptions options;
+	options.CacheBudget = 4 << 20;
+	options.NrWorkers = 4;
+	options.MaxPrefetchInFlight = 64 << 10;
+
+	auto mount = std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options);
+	auto archive = mount.get();
+
+	std::vector<std::experimental::filesystem::path> files = { "/content/large.txt", "/content/missing.txt", "/content/stored.txt", "/content/small.txt" };
+	for (unsigned int i = 0; i < 32; i++)
+		files.push_back("/content/assets/asset" + std::to_string(i) + ".txt");
+
+	// Only the deflated entries fitting into the cache are loaded
+	archive->prefetch(files);
+	EXPECT_EQ(archive->cache()->misses(), 33u);
+	EXPECT_EQ(archive->cache()->hits(), 0u);
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount));
+
+	for (unsigned int i = 0; i < 32; i++)
+	{
+		const auto content = makeContent(10000 + 1000 * i, 10 + i);
+		auto reader = fs.createReader(files[4 + i]);
+		std::vector<char> data(content.size());
+		EXPECT_EQ(reader->read(data.data(), data.size()), content.size());
+		EXPECT_TRUE(data == content);
+	}
+	EXPECT_EQ(archive->cache()->misses(), 33u);
+	EXPECT_EQ(archive->cache()->hits(), 32u);
+}
+
+TEST_F(ArchiveReaderTest, IndependentReaders)
+{
+	using namespace Vcl::FileSystem;
+
+	ArchiveOptions options;
+	options.SeekIndexSpan = 256 << 10;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options));
+
+	// Each thread streams through its own readers of the same archive
+	std::atomic<int> errors{ 0 };
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < 8; t++)
+	{
+		threads.emplace_back([this, &fs, &errors, t]()
+		{
+			std::mt19937 rnd{ t };
+			std::vector<char> buffer(3000);
+			for (int i = 0; i < 20; i++)
+			{
+				const unsigned int asset = rnd() % 32;
+				const auto content = i % 4 == 0 ? large : makeContent(10000 + 1000 * asset, 10 + asset);
+				auto reader = fs.createReader(i % 4 == 0 ? "/content/large.txt" : "/content/assets/asset" + std::to_string(asset) + ".txt");
+
+				const size_t offset = rnd() % content.size();
+				reader->seek(offset);
+				for (size_t pos = offset; pos < std::min(content.size(), offset + 20000); pos += buffer.size())
+				{
+					const size_t expected = std::min(buffer.size(), content.size() - pos);
+					if (reader->read(buffer.data(), buffer.size()) != expected ||
+						!std::equal(buffer.begin(), buffer.begin() + expected, content.begin() + pos))
+						errors++;
+				}
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(errors, 0);
+}
+
+TEST(ArchiveWriterTest, WriteEntries)
+{
+	using namespace Vcl::FileSystem;
+
+	const std::experimental::filesystem::path zip_file{ "WrittenContent.zip" };
+	const auto large = makeContent(3 << 20, 1);
+	const auto small = makeContent(1000, 2);
+
+	for (int level : { -1, 0 })
+	{
+		ArchiveOptions options;
+		options.Create = true;
+		options.NrWorkers = 4;
+		options.CompressionLevel = level;
+		options.CompressionBlockSize = 64 << 10;
+
+		auto mount = std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options);
+		auto archive = mount.get();
+
+		FileSystem fs;
+		fs.addMountPoint(std::move(mount));
+
+		// Entries are not visible before the archive is finalized
+		{
+			auto writer = fs.createWriter("/content/large.txt");
+			for (size_t pos = 0; pos < large.size(); pos += 7777)
+				writer->write(const_cast<char*>(large.data()) + pos, std::min<size_t>(7777, large.size() - pos));
+			EXPECT_EQ(writer->pos(), large.size());
+			EXPECT_THROW(writer->seek(0), std::logic_error);
+		}
+		fs.createWriter("/content/assets/small.txt")->write(const_cast<char*>(small.data()), small.size());
+		fs.createWriter("/content/empty.txt");
+		EXPECT_FALSE(fs.exists("/content/large.txt"));
+
+		archive->finalize();
+
+		for (const auto& file : { std::make_pair("/content/large.txt", large), std::make_pair("/content/assets/small.txt", small), std::make_pair("/content/empty.txt", std::vector<char>{}) })
+		{
+			auto reader = fs.createReader(file.first);
+			ASSERT_EQ(reader->size(), file.second.size()) << file.first;
+
+			std::vector<char> content(file.second.size() + 1);
+			EXPECT_EQ(reader->read(content.data(), content.size()), file.second.size());
+			EXPECT_TRUE(std::equal(file.second.begin(), file.second.end(), content.begin())) << file.first;
+		}
+
+		// The checksums in the directory match the content
+		Vcl::FileSystem::Util::Archive zip{ zip_file };
+		ASSERT_EQ(zip.nrEntries(), 3u);
+		const auto idx = zip.findEntry("large.txt");
+		ASSERT_NE(idx, Vcl::FileSystem::Util::Archive::npos);
+		EXPECT_EQ(zip.entry(idx).Method, level == 0 ? Vcl::FileSystem::Util::ArchiveEntry::Stored : Vcl::FileSystem::Util::ArchiveEntry::Deflated);
+		EXPECT_EQ(zip.entry(idx).Crc32, crc32(0, reinterpret_cast<const Bytef*>(large.data()), static_cast<uInt>(large.size())));
+		if (level != 0)
+		{
+			EXPECT_LT(zip.entry(idx).CompressedSize, large.size() / 2);
+		}
+	}
+
+	std::experimental::filesystem::remove(zip_file);
+}
+
+TEST(ArchiveWriterTest, ConcurrentWriters)
+{
+	using namespace Vcl::FileSystem;
+
+	const std::experimental::filesystem::path zip_file{ "ConcurrentContent.zip" };
+
+	ArchiveOptions options;
+	options.Create = true;
+	options.NrWorkers = 4;
+	options.CompressionBlockSize = 16 << 10;
+
+	auto mount = std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options);
+	auto archive = mount.get();
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount));
+
+	// Each thread streams its own entries, interleaving with the other threads
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&fs, t]()
+		{
+			for (unsigned int i = 0; i < 8; i++)
+			{
+				const unsigned int asset = 8 * t + i;
+				const auto content = makeContent(10000 + 5000 * asset, 10 + asset);
+				auto writer = fs.createWriter("/content/assets/asset" + std::to_string(asset) + ".txt");
+				for (size_t pos = 0; pos < content.size(); pos += 3000)
+					writer->write(const_cast<char*>(content.data()) + pos, std::min<size_t>(3000, content.size() - pos));
+				writer->close();
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	archive->finalize();
+
+	// A new mount reads the finished archive
+	ArchiveMountPoint mp{ "Content", "/content", zip_file };
+	std::vector<std::experimental::filesystem::path> files;
+	for (unsigned int i = 0; i < 32; i++)
+		files.push_back("/content/assets/asset" + std::to_string(i) + ".txt");
+
+	auto loaded = mp.loadFiles(files);
+	for (unsigned int i = 0; i < 32; i++)
+	{
+		const auto content = makeContent(10000 + 5000 * i, 10 + i);
+		EXPECT_EQ(loaded[i].Error, 0);
+		EXPECT_TRUE(loaded[i].Data.size() == content.size() && memcmp(loaded[i].Data.data(), content.data(), content.size()) == 0) << "Asset " << i;
+	}
+
+	std::experimental::filesystem::remove(zip_file);
+}
+
+TEST_F(ArchiveReaderTest, UpdateEntries)
+{
+	using namespace Vcl::FileSystem;
+
+	ArchiveOptions options;
+	options.CacheBudget = 1 << 20;
+
+	auto mount = std::make_unique<ArchiveMountPoint>("Content", "/content", zip_file, options);
+	auto archive = mount.get();
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount));
+
+	auto readAll = [&fs](const std::experimental::filesystem::path& file)
+	{
+		auto reader = fs.createReader(file);
+		std::vector<char> content(reader->size());
+		content.resize(reader->read(content.data(), content.size()));
+		return content;
+	};
+
+	// Cache the previous content and keep a reader of the previous mapping
+	EXPECT_TRUE(readAll("/content/small.txt") == small);
+	auto old_reader = fs.createReader("/content/large.txt");
+	const auto old_size = std::experimental::filesystem::file_size(zip_file);
+
+	const auto changed = makeContent(2000, 3);
+	const auto added = makeContent(500000, 4);
+	archive->beginUpdate();
+	EXPECT_THROW(archive->beginUpdate(), std::logic_error);
+	fs.createWriter("/content/small.txt")->write(const_cast<char*>(changed.data()), changed.size());
+	auto writer = fs.createWriter("/content/new/added.txt");
+	writer->write(const_cast<char*>(added.data()), added.size());
+
+	// An update with open writers stays pending
+	EXPECT_THROW(archive->finalize(), std::logic_error);
+	writer.reset();
+
+	// The update becomes visible once it is finalized
+	EXPECT_FALSE(fs.exists("/content/new/added.txt"));
+	EXPECT_TRUE(readAll("/content/small.txt") == small);
+	archive->finalize();
+
+	EXPECT_TRUE(readAll("/content/small.txt") == changed);
+	EXPECT_TRUE(readAll("/content/new/added.txt") == added);
+	EXPECT_TRUE(readAll("/content/stored.txt") == small);
+	EXPECT_TRUE(readAll("/content/assets/asset7.txt") == makeContent(17000, 17));
+
+	std::vector<char> content(large.size());
+	EXPECT_EQ(old_reader->readAt(0, content.data(), content.size()), large.size());
+	EXPECT_TRUE(content == large);
+
+	// Only the new entries and the directory were written
+	const auto updated_size = std::experimental::filesystem::file_size(zip_file);
+	EXPECT_LT(updated_size, old_size + added.size() / 2);
+	{
+		Util::Archive reopened{ zip_file };
+		EXPECT_EQ(reopened.nrEntries(), 37u);
+		const auto idx = reopened.findEntry("small.txt");
+		ASSERT_NE(idx, Util::Archive::npos);
+		EXPECT_EQ(reopened.entry(idx).Size, changed.size());
+	}
+
+#if defined(_WIN32)
+	// Mapped files cannot be replaced on Windows, the reader of the previous mapping blocks the compaction
+	EXPECT_THROW(archive->compact(), std::exception);
+	EXPECT_EQ(std::experimental::filesystem::file_size(zip_file), updated_size);
+	EXPECT_TRUE(readAll("/content/small.txt") == changed);
+#endif
+	old_reader.reset();
+
+	// Compaction drops the replaced data
+	archive->compact();
+	EXPECT_LT(std::experimental::filesystem::file_size(zip_file), updated_size);
+	EXPECT_TRUE(readAll("/content/small.txt") == changed);
+	EXPECT_TRUE(readAll("/content/new/added.txt") == added);
+	EXPECT_TRUE(readAll("/content/large.txt") == large);
+	EXPECT_TRUE(readAll("/content/stored.txt") == small);
+
+	ArchiveMountPoint reopened{ "Content", "/content", zip_file };
+	auto loaded = reopened.loadFiles({ "/content/small.txt", "/content/new/added.txt", "/content/assets/asset31.txt" });
+	EXPECT_TRUE(loaded[0].Data.size() == changed.size() && memcmp(loaded[0].Data.data(), changed.data(), changed.size()) == 0);
+	EXPECT_TRUE(loaded[1].Data.size() == added.size() && memcmp(loaded[1].Data.data(), added.data(), added.size()) == 0);
+	const auto asset = makeContent(41000, 41);
+	EXPECT_TRUE(loaded[2].Data.size() == asset.size() && memcmp(loaded[2].Data.data(), asset.data(), asset.size()) == 0);
+}
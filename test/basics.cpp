@@ -27,10 +27,12 @@
 #include <vcl/config/global.h>
 
 // C++ standard library
+#include <algorithm>
 #include <fstream>
 
 // Include the relevant parts from the library
 #include <vcl/filesystem/mountpoints/archivemountpoint.h>
+#include <vcl/filesystem/mountpoints/memorymountpoint.h>
 #include <vcl/filesystem/mountpoints/volumemountpoint.h>
 #include <vcl/filesystem/filesystem.h>
 #include <vcl/filesystem/util/archive.h>
@@ -75,7 +77,11 @@ protected:
 
 		const fs::path sample_dir{ "SampleContent" };
 		ASSERT_TRUE(exists(sample_dir)) << "Sample content directory must exists.";
-		ASSERT_EQ(fs::remove_all(sample_dir), 3);
+
+		// Older implementations only count the removed files, the standard includes the directories
+		const auto nr_removed = fs::remove_all(sample_dir);
+		ASSERT_TRUE(nr_removed == 3 || nr_removed == 5) << "Removed " << nr_removed << " entries.";
+		ASSERT_FALSE(exists(sample_dir)) << "Sample content directory must be removed.";
 	}
 
 	const std::experimental::filesystem::path sample_dir{ "SampleContent" };
@@ -112,6 +118,141 @@ TEST_F(SimpleFileSystemTest, ReadVolumeFile)
 	EXPECT_STREQ(text, "File2");
 }
 
+TEST_F(SimpleFileSystemTest, MapVolumeFile)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<VolumeMountPoint>("Basics", "/texts", "SampleContent", VolumeAccess::Map));
+	fs.addMountPoint(std::make_unique<VolumeMountPoint>("Copies", "/copies", "SampleContent"));
+
+	// Mapped files are accessed in place
+	auto reader = fs.createReader("/texts/File2.txt");
+	auto view = reader->view(1, 128);
+	ASSERT_EQ(view.size(), 4);
+	EXPECT_EQ(std::string(reinterpret_cast<const char*>(view.data()), view.size()), "ile2");
+
+	char text[128];
+	auto read_bytes = reader->read(text, sizeof(text));
+	EXPECT_EQ(read_bytes, 5);
+	EXPECT_EQ(std::string(text, read_bytes), "File2");
+
+	// Other readers copy the requested range
+	auto copy_reader = fs.createReader("/copies/File2.txt");
+	auto copy_view = copy_reader->view(0, 5);
+	ASSERT_EQ(copy_view.size(), 5);
+	EXPECT_EQ(std::string(reinterpret_cast<const char*>(copy_view.data()), copy_view.size()), "File2");
+	EXPECT_EQ(copy_reader->pos(), 0);
+	EXPECT_TRUE(reader->view(5, 1).empty());
+}
+
+TEST_F(SimpleFileSystemTest, LoadVolumeFileBatch)
+{
+	using namespace Vcl::FileSystem;
+
+	VolumeMountPoint mp{ "Basics", "/texts", "SampleContent" };
+	const std::vector<std::experimental::filesystem::path> files =
+	{
+		"/texts/File2.txt", "/texts/Missing.txt", "/texts/SubText/File3.txt", "/texts/SubText", "/texts/SubText.txt"
+	};
+
+	for (auto io : { VolumeBatchIO::Blocking, VolumeBatchIO::Ring })
+	{
+		auto loaded = mp.loadFiles(files, io);
+		ASSERT_EQ(loaded.size(), files.size());
+
+		auto as_string = [](const LoadedFile& file) { return std::string(reinterpret_cast<const char*>(file.Data.data()), file.Data.size()); };
+		EXPECT_EQ(loaded[0].Error, 0);
+		EXPECT_EQ(as_string(loaded[0]), "File2");
+		EXPECT_NE(loaded[1].Error, 0);
+		EXPECT_TRUE(loaded[1].Data.empty());
+		EXPECT_EQ(as_string(loaded[2]), "File3");
+		EXPECT_NE(loaded[3].Error, 0);
+		EXPECT_EQ(as_string(loaded[4]), "File1");
+	}
+}
+
+TEST_F(SimpleFileSystemTest, WriteVolumeFile)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<VolumeMountPoint>("Basics", "/texts", "SampleContent"));
+
+	// Data to test
+	std::vector<uint32_t> ref(100000);
+
+	int n = { 0 };
+	std::generate(ref.begin(), ref.end(), [&n] { return n++; });
+
+	// Write the data in small pieces
+	{
+		auto writer = fs.createWriter("/texts/Written/Numbers.bin");
+		ASSERT_TRUE(writer);
+		writer->reserve(ref.size() * sizeof(uint32_t));
+		for (size_t i = 0; i < ref.size(); i += 10)
+			writer->write(ref.data() + i, 10 * sizeof(uint32_t));
+
+		// Overwrite an earlier part of the file
+		uint32_t marker = 0xdeadbeef;
+		writer->seek(10 * sizeof(uint32_t));
+		writer->write(&marker, sizeof(uint32_t));
+		ref[10] = marker;
+
+		EXPECT_EQ(writer->pos(), 11 * sizeof(uint32_t));
+		writer->close();
+	}
+
+	ASSERT_EQ(fs.stat("/texts/Written/Numbers.bin").Size, ref.size() * sizeof(uint32_t));
+
+	// Read the data back
+	std::vector<uint32_t> read_back(ref.size());
+	auto reader = fs.createReader("/texts/Written/Numbers.bin");
+	reader->read(read_back.data(), read_back.size() * sizeof(uint32_t));
+	EXPECT_TRUE(std::equal(ref.begin(), ref.end(), read_back.begin(), read_back.end()));
+
+	std::experimental::filesystem::remove_all("SampleContent/Written");
+}
+
+TEST_F(SimpleFileSystemTest, StatVolumeFile)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<VolumeMountPoint>("Basics", "/texts", "SampleContent"));
+
+	auto entry = fs.resolve("/texts/File2.txt");
+	ASSERT_TRUE(entry);
+	EXPECT_EQ(entry.Status.Size, 5);
+	EXPECT_FALSE(entry.Status.IsDirectory);
+	EXPECT_TRUE(fs.stat("/texts/SubText").IsDirectory);
+	EXPECT_FALSE(fs.resolve("/texts/Missing.txt"));
+
+	auto reader = fs.createReader("/texts/File2.txt", entry);
+	EXPECT_EQ(reader->size(), 5);
+}
+
+TEST(FileSystemTest, MountPointResolution)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<MemoryMountPoint>("Root", "/"));
+	fs.addMountPoint(std::make_unique<MemoryMountPoint>("A", "/a"));
+	fs.addMountPoint(std::make_unique<MemoryMountPoint>("AB", "/a/b"));
+
+	fs.createWriter("/a/b/file.txt");
+	fs.createWriter("/abc/file.txt");
+
+	// Files are resolved by the mount point with the longest common path
+	EXPECT_TRUE(fs.exists("/a/b/file.txt"));
+	EXPECT_FALSE(fs.exists("/a/file.txt"));
+	EXPECT_FALSE(fs.exists("/a/b/c/file.txt"));
+
+	// Mount paths only match complete path components
+	EXPECT_TRUE(fs.exists("/abc/file.txt"));
+}
+
 TEST(FileSystemTest, ArchivePathExistence)
 {
 	using namespace Vcl::FileSystem;
@@ -153,6 +294,22 @@ TEST(FileSystemTest, ListZipFileContent)
 	}
 }
 
+TEST(FileSystemTest, StatArchiveFile)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", "simple.zip"));
+
+	auto entry = fs.resolve("/content/test/test.txt");
+	ASSERT_TRUE(entry);
+	EXPECT_EQ(entry.Status.Size, 11);
+	EXPECT_FALSE(entry.Status.IsDirectory);
+	EXPECT_TRUE(fs.stat("/content/test/").IsDirectory);
+	EXPECT_FALSE(fs.resolve("/content/test/missing.txt"));
+	EXPECT_FALSE(fs.resolve("/content/test"));
+}
+
 TEST(FileSystemTest, ReadArchiveFile)
 {
 	using namespace Vcl::FileSystem;
@@ -28,10 +28,14 @@
 
 // C++ standard library
 #include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
 
 // Include the relevant parts from the library
 #include <vcl/filesystem/mountpoints/memorymountpoint.h>
 #include <vcl/filesystem/util/memoryfile.h>
+#include <vcl/filesystem/util/pagearena.h>
 #include <vcl/filesystem/filesystem.h>
 
 // Google test
@@ -58,6 +62,26 @@ TEST(MemoryFileTest, SimpleMemoryFileRW)
 	EXPECT_TRUE(std::equal(ref.begin(), ref.end(), read_back.begin(), read_back.end()));
 }
 
+TEST(MemoryFileTest, DefaultPageArena)
+{
+	using namespace Vcl::FileSystem::Util;
+
+	// Standalone files share the pages of a single arena
+	const auto arena = PageArena::defaultArena();
+	const auto nr_slabs = arena->nrSlabs();
+	{
+		std::vector<std::unique_ptr<MemoryFile>> files;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			files.push_back(std::make_unique<MemoryFile>("SampleFile" + std::to_string(i)));
+			files.back()->write(0, &i, sizeof(i));
+			EXPECT_EQ(files.back()->pageSize(), size_t{ PageArena::DefaultPageSize });
+		}
+	}
+	EXPECT_LE(arena->nrSlabs(), nr_slabs + 1);
+	EXPECT_EQ(PageArena::defaultArena(), arena);
+}
+
 TEST(MemoryFileTest, SimpleMemoryFileInFileSystem)
 {
 	using namespace Vcl::FileSystem;
@@ -75,6 +99,8 @@ TEST(MemoryFileTest, SimpleMemoryFileInFileSystem)
 	auto writer = fs.createWriter("/SampleFile");
 	writer->write(ref.data(), ref.size() * sizeof(uint32_t));
 
+	EXPECT_EQ(fs.stat("/SampleFile").Size, ref.size() * sizeof(uint32_t));
+
 	// Read the data back
 	std::vector<uint32_t> read_back(4000);
 	auto reader = fs.createReader("/SampleFile");
@@ -82,3 +108,180 @@ TEST(MemoryFileTest, SimpleMemoryFileInFileSystem)
 
 	EXPECT_TRUE(std::equal(ref.begin(), ref.end(), read_back.begin(), read_back.end()));
 }
+
+TEST(MemoryFileTest, SharedPageArena)
+{
+	using namespace Vcl::FileSystem::Util;
+
+	EXPECT_THROW(PageArena{ 1000 }, std::invalid_argument);
+	EXPECT_THROW(PageArena{ 4 << 20 }, std::invalid_argument);
+
+	auto arena = std::make_shared<PageArena>(8192);
+
+	// Data to test
+	std::vector<uint32_t> ref(10000);
+
+	int n = { 0 };
+	std::generate(ref.begin(), ref.end(), [&n] { return n++; });
+
+	{
+		MemoryFile mem_file{ "SampleFile", arena };
+		mem_file.write(0, ref.data(), ref.size() * sizeof(uint32_t));
+		EXPECT_EQ(mem_file.nrPages(), 5u);
+	}
+	EXPECT_EQ(arena->nrFreePages(), 5u);
+
+	// Pages are recycled, skipped ranges still read as zero
+	MemoryFile mem_file{ "SampleFile", arena };
+	mem_file.write(2 * 8192, ref.data(), 4);
+	EXPECT_EQ(arena->nrFreePages(), 2u);
+	EXPECT_EQ(arena->nrSlabs(), 1u);
+
+	std::vector<uint8_t> read_back(2 * 8192 + 4, 0xff);
+	EXPECT_EQ(mem_file.read(0, read_back.data(), read_back.size()), read_back.size());
+	EXPECT_TRUE(std::all_of(read_back.begin(), read_back.end() - 4, [](uint8_t v) { return v == 0; }));
+	EXPECT_EQ(*reinterpret_cast<uint32_t*>(read_back.data() + 2 * 8192), 0u);
+}
+
+TEST(MemoryFileTest, MemoryMountPointIndex)
+{
+	using namespace Vcl::FileSystem;
+
+	auto mount = std::make_unique<MemoryMountPoint>("Basics", "/memory");
+	auto memory = mount.get();
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount));
+
+	uint32_t value = 42;
+	fs.createWriter("/memory/shaders/./common//lighting.hlsl")->write(&value, sizeof(value));
+	for (int i = 0; i < 1000; i++)
+		fs.createWriter("/memory/blobs/" + std::to_string(i) + ".bin")->write(&value, sizeof(value));
+	EXPECT_EQ(memory->nrFiles(), 1001u);
+
+	// Different spellings of a path refer to the same file
+	EXPECT_TRUE(fs.exists("/memory/shaders/common/lighting.hlsl"));
+	EXPECT_TRUE(fs.exists("/memory/shaders/unused/../common/lighting.hlsl"));
+	fs.createWriter("/memory/shaders/common/lighting.hlsl")->write(&value, sizeof(value));
+	EXPECT_EQ(memory->nrFiles(), 1001u);
+
+	// Open readers keep removed files alive
+	auto reader = fs.createReader("/memory/blobs/500.bin");
+	EXPECT_TRUE(memory->remove("/memory/blobs/500.bin"));
+	EXPECT_FALSE(memory->remove("/memory/blobs/500.bin"));
+	EXPECT_FALSE(fs.exists("/memory/blobs/500.bin"));
+	EXPECT_TRUE(fs.exists("/memory/blobs/501.bin"));
+	EXPECT_EQ(memory->nrFiles(), 1000u);
+
+	uint32_t read_back = 0;
+	EXPECT_EQ(reader->read(&read_back, sizeof(read_back)), sizeof(read_back));
+	EXPECT_EQ(read_back, value);
+}
+
+TEST(MemoryFileTest, CopyOnWriteSnapshot)
+{
+	using namespace Vcl::FileSystem::Util;
+
+	auto arena = std::make_shared<PageArena>(4096);
+	MemoryFile mem_file{ "SampleFile", arena };
+
+	std::vector<uint8_t> ref(5 * 4096, 1);
+	mem_file.write(0, ref.data(), ref.size());
+
+	// Modify a single page after taking the snapshot
+	auto snapshot = mem_file.snapshot();
+	uint8_t value = 2;
+	mem_file.write(2 * 4096 + 10, &value, 1);
+	mem_file.write(2 * 4096 + 20, &value, 1);
+
+	std::vector<uint8_t> read_back(ref.size());
+	EXPECT_EQ(snapshot->read(0, read_back.data(), read_back.size()), ref.size());
+	EXPECT_TRUE(std::equal(ref.begin(), ref.end(), read_back.begin()));
+
+	EXPECT_EQ(mem_file.read(0, read_back.data(), read_back.size()), ref.size());
+	EXPECT_EQ(read_back[2 * 4096 + 10], 2);
+	EXPECT_EQ(read_back[2 * 4096 + 20], 2);
+	EXPECT_EQ(std::count(read_back.begin(), read_back.end(), 1), static_cast<ptrdiff_t>(ref.size() - 2));
+
+	// Only the modified page was copied, releasing the snapshot frees the original
+	EXPECT_EQ(arena->nrFreePages(), 0u);
+	snapshot.reset();
+	EXPECT_EQ(arena->nrFreePages(), 1u);
+
+	// Appending to a file without snapshots happens in place
+	mem_file.write(ref.size(), &value, 1);
+	EXPECT_EQ(arena->nrFreePages(), 0u);
+	EXPECT_EQ(mem_file.nrPages(), 6u);
+}
+
+TEST(MemoryFileTest, CopyOnWriteChunks)
+{
+	using namespace Vcl::FileSystem::Util;
+
+	auto arena = std::make_shared<PageArena>(4096);
+	MemoryFile mem_file{ "SampleFile", arena };
+
+	// Content spanning several chunks of the page table, ending within a chunk
+	const size_t nr_pages = 2 * MemoryFileSnapshot::PagesPerChunk + 10;
+	std::vector<uint8_t> ref(nr_pages * 4096);
+	for (size_t i = 0; i < ref.size(); i++)
+		ref[i] = static_cast<uint8_t>(i / 4096);
+	mem_file.write(0, ref.data(), ref.size());
+
+	// Plain reads do not share the content with later versions
+	uint8_t value = 0;
+	EXPECT_EQ(mem_file.read(4096, &value, 1), 1u);
+	mem_file.write(4096, &value, 1);
+	EXPECT_EQ(arena->nrFreePages(), 0u);
+
+	// Modify the first chunk and append to the last one after taking the snapshot
+	auto snapshot = mem_file.snapshot();
+	value = 0xff;
+	mem_file.write(10, &value, 1);
+	mem_file.write(ref.size(), &value, 1);
+	EXPECT_EQ(mem_file.nrPages(), nr_pages + 1);
+	EXPECT_EQ(snapshot->nrPages(), nr_pages);
+
+	std::vector<uint8_t> read_back(ref.size());
+	EXPECT_EQ(snapshot->read(0, read_back.data(), read_back.size()), ref.size());
+	EXPECT_TRUE(read_back == ref);
+
+	read_back.resize(ref.size() + 1);
+	EXPECT_EQ(mem_file.read(0, read_back.data(), read_back.size()), ref.size() + 1);
+	EXPECT_EQ(read_back[10], 0xff);
+	EXPECT_EQ(read_back[ref.size()], 0xff);
+	EXPECT_TRUE(std::equal(ref.begin() + 11, ref.end(), read_back.begin() + 11));
+
+	// Only the modified page was copied, releasing the snapshot frees the original
+	snapshot.reset();
+	EXPECT_EQ(arena->nrFreePages(), 1u);
+}
+
+TEST(MemoryFileTest, ReaderSeesSnapshot)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<MemoryMountPoint>("Basics", "/"));
+
+	auto writer = fs.createWriter("/SampleFile");
+	uint32_t value = 1;
+	writer->write(&value, sizeof(value));
+
+	auto reader = fs.createReader("/SampleFile");
+
+	// Overwrite and extend the file
+	writer->seek(0);
+	value = 2;
+	writer->write(&value, sizeof(value));
+	writer->write(&value, sizeof(value));
+
+	uint32_t read_back[2] = {};
+	EXPECT_EQ(reader->size(), sizeof(uint32_t));
+	EXPECT_EQ(reader->read(read_back, sizeof(read_back)), sizeof(uint32_t));
+	EXPECT_EQ(read_back[0], 1u);
+
+	EXPECT_EQ(fs.createReader("/SampleFile")->read(read_back, sizeof(read_back)), sizeof(read_back));
+	EXPECT_EQ(read_back[0], 2u);
+	EXPECT_EQ(read_back[1], 2u);
+}
@@ -0,0 +1,360 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/packmountpoint.h>
+#include <vcl/filesystem/util/packwriter.h>
+#include <vcl/filesystem/filesystem.h>
+
+// Google test
+#include <gtest/gtest.h>
+
+namespace
+{
+	//! \returns compressible content of 'size' bytes
+	std::vector<char> makeText(size_t size, unsigned int seed)
+	{
+		const char* words[] = { "shader ", "texture ", "mesh ", "audio ", "level ", "script ", "\n" };
+
+		std::mt19937 rnd{ seed };
+		std::vector<char> content;
+		content.reserve(size + 16);
+		while (content.size() < size)
+		{
+			const char* word = words[rnd() % 7];
+			content.insert(content.end(), word, word + strlen(word));
+		}
+		content.resize(size);
+
+		return content;
+	}
+
+	//! \returns incompressible content of 'size' bytes
+	std::vector<char> makeRandom(size_t size, unsigned int seed)
+	{
+		std::mt19937 rnd{ seed };
+		std::vector<char> content(size);
+		for (auto& c : content)
+			c = static_cast<char>(rnd());
+
+		return content;
+	}
+}
+
+class PackTest : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		text = makeText((1 << 20) + 123, 1);
+		random = makeRandom(100000, 2);
+
+		Vcl::FileSystem::Util::PackWriter writer{ pack_file, 4, 16 << 10 };
+		writer.addFile("text.txt", text.data(), text.size());
+		writer.addFile("random.bin", random.data(), random.size());
+		writer.addFile("empty.txt", nullptr, 0);
+		writer.addDirectory("assets");
+		for (unsigned int i = 0; i < 16; i++)
+		{
+			const auto asset = makeText(1000 + 3000 * i, 10 + i);
+			writer.addFile("assets/asset" + std::to_string(i) + ".txt", asset.data(), asset.size());
+		}
+		writer.finalize();
+	}
+
+	void TearDown() override
+	{
+		std::experimental::filesystem::remove(pack_file);
+	}
+
+	const std::experimental::filesystem::path pack_file{ "Content.pack" };
+
+	std::vector<char> text;
+	std::vector<char> random;
+};
+
+TEST_F(PackTest, FindEntries)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<PackMountPoint>("Content", "/content", pack_file));
+
+	EXPECT_EQ(fs.stat("/content/text.txt").Size, text.size());
+	EXPECT_FALSE(fs.stat("/content/text.txt").IsDirectory);
+	EXPECT_EQ(fs.stat("/content/empty.txt").Size, 0u);
+	EXPECT_EQ(fs.stat("/content/assets/asset15.txt").Size, 46000u);
+	EXPECT_TRUE(fs.stat("/content/assets").IsDirectory);
+	EXPECT_TRUE(fs.stat("/content/assets/").IsDirectory);
+	EXPECT_FALSE(fs.exists("/content/missing.txt"));
+	EXPECT_FALSE(fs.exists("/content/assets/asset16.txt"));
+
+	Util::Pack pack{ pack_file };
+	EXPECT_EQ(pack.nrEntries(), 20u);
+	EXPECT_EQ(pack.blockSize(), 16u << 10);
+	EXPECT_EQ(pack.nrBlocks(pack.findEntry("text.txt")), 65u);
+}
+
+TEST_F(PackTest, ReadBlocks)
+{
+	using namespace Vcl::FileSystem;
+
+	PackOptions options;
+	options.NrWorkers = 4;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<PackMountPoint>("Content", "/content", pack_file, options));
+
+	for (const auto& file : { std::make_pair("/content/text.txt", &text), std::make_pair("/content/random.bin", &random) })
+	{
+		const auto& expected = *file.second;
+		auto reader = fs.createReader(file.first);
+		ASSERT_EQ(reader->size(), expected.size());
+
+		// Entire file, decoded in parallel
+		std::vector<char> content(expected.size() + 100);
+		EXPECT_EQ(reader->readAt(0, content.data(), content.size()), expected.size());
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), content.begin()));
+
+		// Zero-length requests do not decode anything
+		EXPECT_EQ(reader->readAt(0, content.data(), 0), 0u);
+		EXPECT_EQ(reader->readAt(expected.size() / 2, content.data(), 0), 0u);
+		EXPECT_EQ(reader->read(content.data(), 0), 0u);
+		EXPECT_EQ(reader->pos(), 0u);
+
+		// Ranges starting and ending within blocks
+		std::mt19937 rnd{ 7 };
+		for (int i = 0; i < 50; i++)
+		{
+			const size_t offset = rnd() % expected.size();
+			const size_t size = rnd() % 70000;
+			const size_t expected_size = std::min(size, expected.size() - offset);
+			EXPECT_EQ(reader->readAt(offset, content.data(), size), expected_size);
+			EXPECT_TRUE(std::equal(expected.begin() + offset, expected.begin() + offset + expected_size, content.begin())) << file.first << " at " << offset;
+		}
+
+		// Small sequential reads
+		reader->seek(1000);
+		for (size_t pos = 1000; pos < expected.size(); pos += 777)
+		{
+			const size_t expected_size = std::min<size_t>(777, expected.size() - pos);
+			ASSERT_EQ(reader->read(content.data(), 777), expected_size);
+			ASSERT_TRUE(std::equal(expected.begin() + pos, expected.begin() + pos + expected_size, content.begin())) << file.first << " at " << pos;
+		}
+		EXPECT_TRUE(reader->eof());
+	}
+
+	auto empty = fs.createReader("/content/empty.txt");
+	char c;
+	EXPECT_EQ(empty->read(&c, 1), 0u);
+	EXPECT_TRUE(empty->eof());
+}
+
+TEST_F(PackTest, ViewStoredBlocks)
+{
+	using namespace Vcl::FileSystem;
+
+	PackMountPoint* mount;
+	FileSystem fs;
+	{
+		auto mp = std::make_unique<PackMountPoint>("Content", "/content", pack_file);
+		mount = mp.get();
+		fs.addMountPoint(std::move(mp));
+	}
+	const auto mapping = mount->pack().mapping();
+
+	// Incompressible blocks are stored and viewed in place
+	auto reader = fs.createReader("/content/random.bin");
+	auto view = reader->view(100, 1000);
+	ASSERT_EQ(view.size(), 1000u);
+	EXPECT_TRUE(view.data() >= mapping->data() && view.data() < mapping->data() + mapping->size());
+	EXPECT_EQ(memcmp(view.data(), random.data() + 100, 1000), 0);
+
+	// Compressed blocks are copied
+	auto text_view = fs.createReader("/content/text.txt")->view(16000, 1000);
+	ASSERT_EQ(text_view.size(), 1000u);
+	EXPECT_FALSE(text_view.data() >= mapping->data() && text_view.data() < mapping->data() + mapping->size());
+	EXPECT_EQ(memcmp(text_view.data(), text.data() + 16000, 1000), 0);
+}
+
+TEST_F(PackTest, CachedFiles)
+{
+	using namespace Vcl::FileSystem;
+
+	PackOptions options;
+	options.CacheBudget = 1 << 20;
+	options.MaxCachedSize = 64 << 10;
+
+	auto mount = std::make_unique<PackMountPoint>("Content", "/content", pack_file, options);
+	const auto* cache = mount->cache();
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount));
+
+	for (int i = 0; i < 2; i++)
+	{
+		const auto asset = makeText(1000 + 3000 * 5, 15);
+		auto reader = fs.createReader("/content/assets/asset5.txt");
+		std::vector<char> content(asset.size());
+		EXPECT_EQ(reader->read(content.data(), content.size()), asset.size());
+		EXPECT_TRUE(content == asset);
+	}
+	EXPECT_EQ(cache->misses(), 1u);
+	EXPECT_EQ(cache->hits(), 1u);
+
+	// Large files are not cached
+	fs.createReader("/content/text.txt");
+	EXPECT_EQ(cache->misses(), 1u);
+}
+
+TEST_F(PackTest, ConcurrentReads)
+{
+	using namespace Vcl::FileSystem;
+
+	PackOptions options;
+	options.NrWorkers = 2;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<PackMountPoint>("Content", "/content", pack_file, options));
+
+	std::atomic<int> errors{ 0 };
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([this, &fs, &errors, t]()
+		{
+			std::mt19937 rnd{ t };
+			auto reader = fs.createReader("/content/text.txt");
+			std::vector<char> buffer(100000);
+			for (int i = 0; i < 50; i++)
+			{
+				const size_t offset = rnd() % text.size();
+				const size_t size = std::min<size_t>(rnd() % buffer.size(), text.size() - offset);
+				if (reader->readAt(offset, buffer.data(), size) != size ||
+					!std::equal(buffer.begin(), buffer.begin() + size, text.begin() + offset))
+					errors++;
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(errors, 0);
+}
+
+TEST_F(PackTest, DeduplicateFiles)
+{
+	using namespace Vcl::FileSystem;
+
+	auto modified = text;
+	modified.back() = '!';
+	const auto small = makeText(5000, 3);
+	{
+		Util::PackWriter writer{ pack_file, 2, 16 << 10 };
+		writer.addFile("a/level.txt", text.data(), text.size());
+		writer.addFile("b/level.txt", text.data(), text.size());
+		writer.addFile("c/level.txt", modified.data(), modified.size());
+		writer.addFile("empty0.txt", nullptr, 0);
+		writer.addFile("small0.txt", small.data(), small.size());
+		writer.addFile("empty1.txt", nullptr, 0);
+		writer.addFile("small1.txt", small.data(), small.size());
+		writer.finalize();
+
+		EXPECT_EQ(writer.nrDuplicates(), 2u);
+		EXPECT_EQ(writer.duplicateSize(), text.size() + small.size());
+	}
+
+	const Util::Pack pack{ pack_file };
+	EXPECT_EQ(pack.entry(pack.findEntry("a/level.txt")).FirstBlock, pack.entry(pack.findEntry("b/level.txt")).FirstBlock);
+	EXPECT_NE(pack.entry(pack.findEntry("a/level.txt")).FirstBlock, pack.entry(pack.findEntry("c/level.txt")).FirstBlock);
+	EXPECT_EQ(pack.entry(pack.findEntry("small0.txt")).FirstBlock, pack.entry(pack.findEntry("small1.txt")).FirstBlock);
+
+	PackOptions options;
+	options.CacheBudget = 8 << 20;
+	options.MaxCachedSize = 2 << 20;
+
+	auto mount = std::make_unique<PackMountPoint>("Content", "/content", pack_file, options);
+	const auto* cache = mount->cache();
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount));
+
+	auto readFile = [&fs](const char* file_name)
+	{
+		auto reader = fs.createReader(file_name);
+		std::vector<char> content(reader->size());
+		content.resize(reader->read(content.data(), content.size()));
+		return content;
+	};
+
+	// Duplicates share the cached content
+	EXPECT_TRUE(readFile("/content/a/level.txt") == text);
+	EXPECT_TRUE(readFile("/content/b/level.txt") == text);
+	EXPECT_EQ(cache->misses(), 1u);
+	EXPECT_EQ(cache->hits(), 1u);
+	EXPECT_EQ(cache->size(), text.size());
+
+	EXPECT_TRUE(readFile("/content/c/level.txt") == modified);
+	EXPECT_TRUE(readFile("/content/small1.txt") == small);
+	EXPECT_TRUE(readFile("/content/small0.txt") == small);
+	EXPECT_TRUE(readFile("/content/empty0.txt").empty());
+	EXPECT_TRUE(readFile("/content/empty1.txt").empty());
+	EXPECT_EQ(cache->misses(), 3u);
+	EXPECT_EQ(cache->hits(), 2u);
+}
+
+TEST_F(PackTest, InvalidPacks)
+{
+	using namespace Vcl::FileSystem;
+
+	EXPECT_THROW(Util::PackWriter(pack_file, 1, 1000), std::invalid_argument);
+	{
+		Util::PackWriter writer{ pack_file, 1 };
+		writer.addFile("file.txt", text.data(), 100);
+		EXPECT_THROW(writer.addFile("file.txt", text.data(), 100), std::invalid_argument);
+		EXPECT_THROW(writer.addDirectory("dir/"), std::invalid_argument);
+	}
+
+	// A file without the header of a pack
+	{
+		std::ofstream file{ pack_file.string(), std::ios::binary | std::ios::trunc };
+		file.write(text.data(), 10000);
+	}
+	EXPECT_THROW(Util::Pack{ pack_file }, std::runtime_error);
+}
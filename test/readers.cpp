@@ -0,0 +1,138 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <vector>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/memorymountpoint.h>
+#include <vcl/filesystem/mountpoints/volumemountpoint.h>
+#include <vcl/filesystem/filesystem.h>
+
+// Google test
+#include <gtest/gtest.h>
+
+class FileReaderTest : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		namespace fs = std::experimental::filesystem;
+
+		ASSERT_FALSE(exists(sample_dir)) << "Sample content directory must not exists.";
+		ASSERT_TRUE(fs::create_directory(sample_dir)) << "Sample content directory could not be created.";
+
+		std::mt19937 rnd{ 5489u };
+		content.resize(100000);
+		std::generate(content.begin(), content.end(), [&rnd]() { return static_cast<char>(rnd()); });
+
+		std::ofstream file{ (sample_dir / "Random.bin").string(), std::ios::binary };
+		ASSERT_TRUE(file.is_open()) << "Sample content could not be created.";
+		file.write(content.data(), content.size());
+		file.close();
+
+		file_system.addMountPoint(std::make_unique<Vcl::FileSystem::VolumeMountPoint>("Content", "/content", sample_dir));
+		file_system.addMountPoint(std::make_unique<Vcl::FileSystem::VolumeMountPoint>("Mapped", "/mapped", sample_dir, Vcl::FileSystem::VolumeAccess::Map));
+		file_system.addMountPoint(std::make_unique<Vcl::FileSystem::MemoryMountPoint>("Memory", "/memory"));
+
+		auto writer = file_system.createWriter("/memory/Random.bin");
+		writer->write(content.data(), content.size());
+	}
+
+	void TearDown() override
+	{
+		std::experimental::filesystem::remove_all(sample_dir);
+	}
+
+	//! Read a set of adjacent, close, distant, overlapping and invalid ranges in random order
+	void checkBatchedRead(const Vcl::FileSystem::FileReader& reader)
+	{
+		using Vcl::FileSystem::ReadRequest;
+
+		const std::vector<std::pair<uint64_t, uint64_t>> ranges =
+		{
+			{ 1000, 100 }, { 1100, 200 }, { 1300, 50 },  // Adjacent
+			{ 2000, 100 }, { 3000, 100 },                 // Small gaps
+			{ 50000, 1000 }, { 50500, 1000 },             // Overlapping
+			{ 99990, 100 },                               // Crossing the end of the file
+			{ 200000, 100 },                              // Outside of the file
+			{ 0, 0 },                                     // Empty
+		};
+
+		std::vector<std::vector<char>> buffers;
+		std::vector<ReadRequest> requests;
+		for (const auto& range : ranges)
+		{
+			buffers.emplace_back(range.second);
+			requests.push_back({ range.first, buffers.back().data(), range.second });
+		}
+		std::shuffle(requests.begin(), requests.end(), std::mt19937{ 42 });
+
+		uint64_t expected_total = 0;
+		for (const auto& request : requests)
+			expected_total += request.Offset < content.size() ? std::min<uint64_t>(request.Size, content.size() - request.Offset) : 0;
+
+		EXPECT_EQ(reader.readv(requests), expected_total);
+		for (const auto& request : requests)
+		{
+			const auto expected = request.Offset < content.size() ? std::min<uint64_t>(request.Size, content.size() - request.Offset) : 0;
+			ASSERT_EQ(request.ReadBytes, expected) << "Offset " << request.Offset;
+
+			const char* data = static_cast<const char*>(request.Buffer);
+			EXPECT_TRUE(std::equal(data, data + expected, content.begin() + std::min<uint64_t>(request.Offset, content.size()))) << "Offset " << request.Offset;
+		}
+	}
+
+	const std::experimental::filesystem::path sample_dir{ "ReaderContent" };
+
+	std::vector<char> content;
+
+	Vcl::FileSystem::FileSystem file_system;
+};
+
+TEST_F(FileReaderTest, BatchedVolumeRead)
+{
+	auto reader = file_system.createReader("/content/Random.bin");
+	checkBatchedRead(*reader);
+	EXPECT_EQ(reader->pos(), 0);
+}
+
+TEST_F(FileReaderTest, BatchedMappedRead)
+{
+	auto reader = file_system.createReader("/mapped/Random.bin");
+	checkBatchedRead(*reader);
+}
+
+TEST_F(FileReaderTest, BatchedMemoryRead)
+{
+	auto reader = file_system.createReader("/memory/Random.bin");
+	checkBatchedRead(*reader);
+}
@@ -0,0 +1,411 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Include the relevant parts from the library
+#include <vcl/filesystem/mountpoints/archivemountpoint.h>
+#include <vcl/filesystem/mountpoints/memorymountpoint.h>
+#include <vcl/filesystem/mountpoints/volumemountpoint.h>
+#include <vcl/filesystem/filesystem.h>
+
+// Google test
+#include <gtest/gtest.h>
+
+namespace
+{
+	/*!
+	 *	\brief Read random ranges of a file from an increasing number of threads
+	 *	\param reader Reader shared by all the threads
+	 */
+	void hammerReader(const Vcl::FileSystem::FileReader& reader)
+	{
+		// Reference content
+		std::vector<char> ref(reader.size());
+		ASSERT_EQ(reader.readAt(0, ref.data(), ref.size()), ref.size());
+
+		for (unsigned int nr_threads = 1; nr_threads <= 64; nr_threads *= 2)
+		{
+			std::atomic<int> errors{ 0 };
+			std::vector<std::thread> threads;
+			for (unsigned int t = 0; t < nr_threads; t++)
+			{
+				threads.emplace_back([&reader, &ref, &errors, t]()
+				{
+					std::mt19937 rnd{ t };
+					std::vector<char> buffer(256);
+					for (int i = 0; i < 1000; i++)
+					{
+						const size_t offset = rnd() % ref.size();
+						const size_t size = 1 + rnd() % buffer.size();
+						const size_t expected = std::min(size, ref.size() - offset);
+
+						const auto read_bytes = reader.readAt(offset, buffer.data(), size);
+						if (read_bytes != expected || !std::equal(buffer.begin(), buffer.begin() + expected, ref.begin() + offset))
+							errors++;
+					}
+				});
+			}
+
+			for (auto& thread : threads)
+				thread.join();
+
+			EXPECT_EQ(errors, 0) << "Failed with " << nr_threads << " threads.";
+		}
+	}
+}
+
+class ConcurrentReaderTest : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		namespace fs = std::experimental::filesystem;
+
+		ASSERT_FALSE(exists(sample_dir)) << "Sample content directory must not exists.";
+		ASSERT_TRUE(fs::create_directory(sample_dir)) << "Sample content directory could not be created.";
+
+		std::mt19937 rnd{ 5489u };
+		content.resize(1 << 20);
+		std::generate(content.begin(), content.end(), [&rnd]() { return static_cast<char>(rnd()); });
+
+		std::ofstream file{ (sample_dir / "Random.bin").string(), std::ios::binary };
+		ASSERT_TRUE(file.is_open()) << "Sample content could not be created.";
+		file.write(content.data(), content.size());
+	}
+
+	void TearDown() override
+	{
+		std::experimental::filesystem::remove_all(sample_dir);
+	}
+
+	const std::experimental::filesystem::path sample_dir{ "ConcurrentContent" };
+
+	std::vector<char> content;
+};
+
+TEST_F(ConcurrentReaderTest, VolumeFile)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<VolumeMountPoint>("Content", "/content", sample_dir));
+
+	auto reader = fs.createReader("/content/Random.bin");
+	hammerReader(*reader);
+}
+
+TEST_F(ConcurrentReaderTest, MappedVolumeFile)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<VolumeMountPoint>("Content", "/content", sample_dir, VolumeAccess::Map));
+
+	auto reader = fs.createReader("/content/Random.bin");
+	hammerReader(*reader);
+}
+
+TEST_F(ConcurrentReaderTest, MemoryFile)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<MemoryMountPoint>("Content", "/content"));
+
+	auto writer = fs.createWriter("/content/Random.bin");
+	writer->write(content.data(), content.size());
+
+	auto reader = fs.createReader("/content/Random.bin");
+	hammerReader(*reader);
+}
+
+TEST(ConcurrentReader, ArchiveFile)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<ArchiveMountPoint>("Content", "/content", "simple.zip"));
+
+	auto reader = fs.createReader("/content/simple.txt");
+	hammerReader(*reader);
+}
+
+TEST_F(ConcurrentReaderTest, AsyncRead)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs{ 4, 8 };
+	fs.addMountPoint(std::make_unique<VolumeMountPoint>("Content", "/content", sample_dir));
+	fs.addMountPoint(std::make_unique<MemoryMountPoint>("Memory", "/memory"));
+
+	auto writer = fs.createWriter("/memory/Random.bin");
+	writer->write(content.data(), content.size());
+
+	// Issue more requests than the queue can hold
+	std::vector<AsyncRequest> requests;
+	for (uint64_t r = 0; r < 32; r++)
+	{
+		const auto* file = r % 2 ? "/content/Random.bin" : "/memory/Random.bin";
+		requests.emplace_back(fs.readAsync(file, r * 1000, 4096));
+	}
+
+	for (uint64_t r = 0; r < requests.size(); r++)
+	{
+		auto data = requests[r].get();
+		ASSERT_EQ(data.size(), 4096);
+		EXPECT_EQ(memcmp(data.data(), content.data() + r * 1000, data.size()), 0) << "Request " << r;
+	}
+
+	// Load entire files with a completion callback
+	std::atomic<size_t> loaded_bytes{ 0 };
+	auto load = fs.loadAsync("/content/Random.bin", [&loaded_bytes](const std::experimental::filesystem::path&, const std::vector<std::byte>& data)
+	{
+		loaded_bytes += data.size();
+	});
+	EXPECT_EQ(load.get().size(), content.size());
+	EXPECT_EQ(loaded_bytes, content.size());
+
+	// Errors are reported through the request
+	EXPECT_THROW(fs.loadAsync("/content/Missing.bin").get(), std::domain_error);
+}
+
+TEST_F(ConcurrentReaderTest, CancelAsyncRead)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs{ 1, 4 };
+	fs.addMountPoint(std::make_unique<VolumeMountPoint>("Content", "/content", sample_dir));
+
+	// Block the only worker until the second request is cancelled
+	std::promise<void> release;
+	auto released = release.get_future().share();
+	auto blocking = fs.readAsync("/content/Random.bin", 0, 16, [released](const std::experimental::filesystem::path&, const std::vector<std::byte>&)
+	{
+		released.wait();
+	});
+
+	auto cancelled = fs.readAsync("/content/Random.bin", 0, 16);
+	cancelled.cancel();
+	release.set_value();
+
+	EXPECT_EQ(blocking.get().size(), 16);
+	EXPECT_THROW(cancelled.get(), RequestCancelled);
+}
+
+namespace
+{
+	//! Expected content of the files written by 'ConcurrentMemoryMountPoint'
+	char memoryContent(size_t file, size_t pos)
+	{
+		return static_cast<char>((file * 31 + pos) & 0xff);
+	}
+}
+
+TEST(ConcurrentMemoryMountPoint, ProducersAndConsumers)
+{
+	using namespace Vcl::FileSystem;
+
+	const size_t nr_producers = 8;
+	const size_t nr_consumers = 4;
+	const size_t nr_files = 100;
+
+	auto mount = std::make_unique<MemoryMountPoint>("Memory", "/memory");
+	auto memory = mount.get();
+
+	FileSystem fs;
+	fs.addMountPoint(std::move(mount));
+
+	auto file_name = [](size_t producer, size_t file)
+	{
+		return "/memory/" + std::to_string(producer) + "/" + std::to_string(file) + ".bin";
+	};
+	auto file_size = [](size_t file) { return 1000 + (file * 3779) % 20000; };
+
+	// Number of completed files of each producer
+	std::vector<std::atomic<size_t>> completed(nr_producers);
+	std::atomic<bool> done{ false };
+	std::atomic<int> errors{ 0 };
+
+	// Producers create the files and write them in small chunks
+	std::vector<std::thread> producers;
+	for (size_t p = 0; p < nr_producers; p++)
+	{
+		producers.emplace_back([&, p]()
+		{
+			std::vector<char> chunk(777);
+			for (size_t f = 0; f < nr_files; f++)
+			{
+				const size_t id = p * nr_files + f;
+				auto writer = fs.createWriter(file_name(p, f));
+				for (size_t pos = 0; pos < file_size(id); pos += chunk.size())
+				{
+					const size_t size = std::min(chunk.size(), file_size(id) - pos);
+					for (size_t i = 0; i < size; i++)
+						chunk[i] = memoryContent(id, pos + i);
+
+					writer->write(chunk.data(), size);
+				}
+
+				completed[p].store(f + 1, std::memory_order_release);
+			}
+		});
+	}
+
+	// Consumers read completed files as well as files still being written
+	std::vector<std::thread> consumers;
+	for (size_t c = 0; c < nr_consumers; c++)
+	{
+		consumers.emplace_back([&, c]()
+		{
+			std::mt19937 rnd{ static_cast<unsigned int>(c) };
+			std::vector<char> buffer;
+			while (!done)
+			{
+				const size_t p = rnd() % nr_producers;
+				const size_t nr_completed = completed[p].load(std::memory_order_acquire);
+
+				// Either pick a completed file or the one currently written
+				const bool complete = nr_completed == nr_files || (nr_completed > 0 && rnd() % 2 == 0);
+				const size_t f = complete ? rnd() % nr_completed : nr_completed;
+				const size_t id = p * nr_files + f;
+				const auto name = file_name(p, f);
+
+				auto entry = fs.resolve(name);
+				if (!entry)
+				{
+					if (complete)
+						errors++;
+					continue;
+				}
+
+				auto reader = fs.createReader(name, entry);
+				buffer.resize(reader->size());
+				const auto read_bytes = reader->readAt(0, buffer.data(), buffer.size());
+				if (complete && read_bytes != file_size(id))
+					errors++;
+
+				for (size_t i = 0; i < read_bytes; i++)
+				{
+					if (buffer[i] != memoryContent(id, i))
+					{
+						errors++;
+						break;
+					}
+				}
+			}
+		});
+	}
+
+	for (auto& producer : producers)
+		producer.join();
+	done = true;
+	for (auto& consumer : consumers)
+		consumer.join();
+
+	EXPECT_EQ(errors, 0);
+	EXPECT_EQ(memory->nrFiles(), nr_producers * nr_files);
+
+	// Remove the files of each producer from a separate thread
+	std::vector<std::thread> removers;
+	for (size_t p = 0; p < nr_producers; p++)
+	{
+		removers.emplace_back([&, p]()
+		{
+			for (size_t f = 0; f < nr_files; f++)
+			{
+				if (!memory->remove(file_name(p, f)))
+					errors++;
+			}
+		});
+	}
+	for (auto& remover : removers)
+		remover.join();
+
+	EXPECT_EQ(errors, 0);
+	EXPECT_EQ(memory->nrFiles(), 0u);
+}
+
+TEST(ConcurrentMemoryMountPoint, ConsistentSnapshots)
+{
+	using namespace Vcl::FileSystem;
+
+	FileSystem fs;
+	fs.addMountPoint(std::make_unique<MemoryMountPoint>("Memory", "/memory"));
+
+	// Every generation overwrites the entire file with a single value
+	std::vector<char> content(64 << 10, 0);
+	auto writer = fs.createWriter("/memory/telemetry.bin");
+	writer->write(content.data(), content.size());
+
+	std::atomic<bool> done{ false };
+	std::atomic<int> errors{ 0 };
+
+	std::vector<std::thread> readers;
+	for (int r = 0; r < 4; r++)
+	{
+		readers.emplace_back([&]()
+		{
+			std::vector<char> buffer(content.size());
+			while (!done)
+			{
+				// Reading the file in multiple steps sees a single generation
+				auto reader = fs.createReader("/memory/telemetry.bin");
+				const size_t half = buffer.size() / 2;
+				reader->read(buffer.data(), half);
+				std::this_thread::yield();
+				reader->read(buffer.data() + half, buffer.size() - half);
+
+				if (std::count(buffer.begin(), buffer.end(), buffer[0]) != static_cast<ptrdiff_t>(buffer.size()))
+					errors++;
+			}
+		});
+	}
+
+	for (int generation = 1; generation < 200; generation++)
+	{
+		std::fill(content.begin(), content.end(), static_cast<char>(generation));
+		writer->seek(0);
+		writer->write(content.data(), content.size());
+	}
+
+	done = true;
+	for (auto& reader : readers)
+		reader.join();
+
+	EXPECT_EQ(errors, 0);
+}
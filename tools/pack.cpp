@@ -0,0 +1,156 @@
+/*
+ * This file is part of the Visual Computing Library (VCL) release under the
+ * MIT license.
+ *
+ * Copyright (c) 2014-2016 Basil Fierz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// VCL configuration
+#include <vcl/config/global.h>
+
+// C++ standard library
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <experimental/filesystem>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// VCL File System Library
+#include <vcl/filesystem/util/mappedfile.h>
+#include <vcl/filesystem/util/packwriter.h>
+
+namespace
+{
+	void printUsage()
+	{
+		std::printf("Usage: vcl.filesystem.pack [options] <directory> <pack>\n");
+		std::printf("Builds a pack from all files in a directory, storing identical files once.\n\n");
+		std::printf("Options:\n");
+		std::printf("  -b <bytes>   Uncompressed size of the blocks (default: 65536)\n");
+		std::printf("  -l <level>   zlib compression level, 0 stores the data (default: -1)\n");
+		std::printf("  -j <threads> Number of compressing threads (default: one per hardware thread)\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	namespace fs = std::experimental::filesystem;
+	using Vcl::FileSystem::Util::MappedFile;
+	using Vcl::FileSystem::Util::PackWriter;
+
+	uint32_t block_size = 64 << 10;
+	int level = -1;
+	unsigned int nr_workers = 0;
+	std::vector<std::string> arguments;
+	for (int i = 1; i < argc; i++)
+	{
+		const bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "-b") == 0 && has_value)
+			block_size = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (strcmp(argv[i], "-l") == 0 && has_value)
+			level = std::atoi(argv[++i]);
+		else if (strcmp(argv[i], "-j") == 0 && has_value)
+			nr_workers = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		else if (argv[i][0] == '-')
+		{
+			printUsage();
+			return 1;
+		}
+		else
+			arguments.emplace_back(argv[i]);
+	}
+	if (arguments.size() != 2)
+	{
+		printUsage();
+		return 1;
+	}
+
+	const fs::path root{ arguments[0] };
+	const fs::path pack_file{ arguments[1] };
+	bool created = false;
+	try
+	{
+		// Sort the entries, such that the same directory always results in the same pack
+		std::vector<std::pair<std::string, fs::path>> entries;
+		for (auto entry_it = fs::recursive_directory_iterator(root); entry_it != fs::recursive_directory_iterator(); ++entry_it)
+		{
+			const auto& entry = entry_it->path();
+			if (!fs::is_directory(entry_it->status()) && !fs::is_regular_file(entry_it->status()))
+				continue;
+
+			// Names are formed by the components below the directory and use '/' as separator,
+			// independent of the spelling of the directory
+			const std::vector<fs::path> components(entry.begin(), entry.end());
+			fs::path name;
+			for (auto component_it = components.end() - (entry_it.depth() + 1); component_it != components.end(); ++component_it)
+				name /= *component_it;
+
+			entries.emplace_back(name.generic_string(), entry);
+		}
+		std::sort(entries.begin(), entries.end());
+
+		const auto start = std::chrono::steady_clock::now();
+		uint64_t total_size = 0;
+
+		PackWriter writer{ pack_file, nr_workers, block_size, level };
+		created = true;
+		for (const auto& entry : entries)
+		{
+			if (fs::is_directory(entry.second))
+			{
+				writer.addDirectory(entry.first);
+				continue;
+			}
+
+			MappedFile file{ entry.second };
+			writer.addFile(entry.first, file.data(), file.size());
+			total_size += file.size();
+		}
+		writer.finalize();
+
+		const auto end = std::chrono::steady_clock::now();
+		const double seconds = std::chrono::duration<double>(end - start).count();
+		std::printf("Packed %zu entries, %.1f MiB into %.1f MiB in %.2f s\n",
+			writer.nrEntries(), total_size / double(1 << 20), fs::file_size(pack_file) / double(1 << 20), seconds);
+		std::printf("Stored %zu duplicate files (%.1f MiB) only once\n",
+			writer.nrDuplicates(), writer.duplicateSize() / double(1 << 20));
+	}
+	catch (const std::exception& e)
+	{
+		// Incomplete packs are not left behind
+		if (created)
+		{
+			std::error_code ec;
+			fs::remove(pack_file, ec);
+		}
+
+		std::fprintf(stderr, "Error: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}